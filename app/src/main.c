@@ -4,8 +4,16 @@
 #include <zephyr/device.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
 
+#include "elerium/subsys/clock.h"
+#include "elerium/subsys/crypto.h"
+#include "elerium/subsys/energy.h"
 #include "elerium/subsys/nfc.h"
+#include "elerium/subsys/power.h"
+#include "elerium/subsys/psbt.h"
+#include "elerium/subsys/scratch.h"
+#include "elerium/subsys/subsys.h"
 #include "elerium/subsys/url_sign.h"
 #include "elerium/subsys/wallet.h"
 
@@ -13,16 +21,33 @@
 
 #define ELERIUM_URL_SIGN_MAX_PWD_LEN 8
 
+#define ELERIUM_BOOT_PROFILE_ENTRY_SIZE (3 + (3 * sizeof(uint32_t)))
+
+// A command holds its request and response in the scratch arena, and programming URL signing
+// stages a storage transaction journal after them
+BUILD_ASSERT(((2 * ELERIUM_SCRATCH_ROUND(sizeof(struct elerium_nfc_message)))
+              + ELERIUM_SCRATCH_ROUND(CONFIG_BEECHAT_ELERIUM_STORAGE_TXN_SIZE))
+             <= ELERIUM_SCRATCH_SIZE);
+
 //***************************************************************************//
 
 enum elerium_cmd {
     ELERIUM_CMD_WALLET_CREATE = 0xA0,
     ELERIUM_CMD_WALLET_SIGN = 0xA1,
     ELERIUM_CMD_WALLET_SEED = 0xA2,
+    ELERIUM_CMD_WALLET_PSBT_BEGIN = 0xA3,
+    ELERIUM_CMD_WALLET_PSBT_DATA = 0xA4,
+    ELERIUM_CMD_WALLET_PSBT_END = 0xA5,
 
     ELERIUM_CMD_URL_SIGN_PROGRAM = 0xB0,
     ELERIUM_CMD_URL_SIGN_PUB_KEY = 0xB1,
     ELERIUM_CMD_URL_SIGN_RESET = 0xB2,
+
+    ELERIUM_CMD_DIAG_BOOT_PROFILE = 0xC0,
+    ELERIUM_CMD_DIAG_ENERGY = 0xC1,
+    ELERIUM_CMD_DIAG_POWER = 0xC2,
+    ELERIUM_CMD_DIAG_DRBG = 0xC3,
+    ELERIUM_CMD_DIAG_CLOCK = 0xC4,
 };
 
 //***************************************************************************//
@@ -31,6 +56,167 @@ LOG_MODULE_DECLARE(elerium);
 
 //***************************************************************************//
 
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_PSBT)
+// Response: count byte, then (input index, signature) pairs
+static void psbt_collect(struct elerium_nfc_message* res_msg) {
+    const size_t entry_size = sizeof(uint32_t) + sizeof(struct elerium_signature);
+
+    size_t count = 0;
+    size_t offset = 4 + 1;
+
+    struct elerium_psbt_signature signature;
+
+    while (((offset + entry_size) <= sizeof(res_msg->data))
+           && (elerium_psbt_pop_signature(&signature) == 0)) {
+
+        sys_put_le32(signature.input, &res_msg->data[offset]);
+        (void)memcpy(&res_msg->data[offset + sizeof(uint32_t)],
+                     signature.sign.data,
+                     sizeof(signature.sign.data));
+
+        offset += entry_size;
+        ++count;
+    }
+
+    (void)memset(&signature, 0x00, sizeof(signature));
+
+    res_msg->data[4] = count;
+    res_msg->length = offset;
+}
+#endif
+
+// Response: boot time in us, count, then (id, state, rc, start us, init us, provision us) per
+// subsystem. Boot time plus the provisioning times is the boot a first start took when init
+// generated the keys.
+static int boot_profile(struct elerium_nfc_message* res_msg) {
+    BUILD_ASSERT((4 + sizeof(uint32_t) + 1
+                  + (ELERIUM_SUBSYS_COUNT * ELERIUM_BOOT_PROFILE_ENTRY_SIZE))
+                 <= ELERIUM_NFC_MESSAGE_SIZE);
+
+    size_t offset = 4;
+
+    struct elerium_subsys_profile profile;
+
+    sys_put_le32(elerium_subsys_boot_us(), &res_msg->data[offset]);
+    offset += sizeof(uint32_t);
+
+    res_msg->data[offset++] = ELERIUM_SUBSYS_COUNT;
+
+    for (size_t i = 0; i < ELERIUM_SUBSYS_COUNT; ++i) {
+        (void)elerium_subsys_profile(i, &profile);
+
+        res_msg->data[offset] = i;
+        res_msg->data[offset + 1] = profile.state;
+        res_msg->data[offset + 2] = (uint8_t)(int8_t)profile.rc;
+        sys_put_le32(profile.start_us, &res_msg->data[offset + 3]);
+        sys_put_le32(profile.init_us, &res_msg->data[offset + 3 + sizeof(uint32_t)]);
+        sys_put_le32(profile.provision_us, &res_msg->data[offset + 3 + (2 * sizeof(uint32_t))]);
+
+        offset += ELERIUM_BOOT_PROFILE_ENTRY_SIZE;
+    }
+
+    res_msg->length = offset;
+
+    return 0;
+}
+
+// Response: supply, lowest supply and vbat in mV, then samples, admitted, deferred and forced jobs
+static int energy_stats(struct elerium_nfc_message* res_msg) {
+    size_t offset = 4;
+
+    struct elerium_energy_stats stats;
+
+    // The only vbat sample, the supply checks run on vref alone
+    (void)elerium_energy_vbat_mv();
+    (void)elerium_energy_stats(&stats);
+
+    sys_put_le16(stats.supply_mv, &res_msg->data[offset]);
+    sys_put_le16(stats.min_supply_mv, &res_msg->data[offset + 2]);
+    sys_put_le16(stats.vbat_mv, &res_msg->data[offset + 4]);
+    offset += 3 * sizeof(uint16_t);
+
+    sys_put_le32(stats.samples, &res_msg->data[offset]);
+    sys_put_le32(stats.admitted, &res_msg->data[offset + 4]);
+    sys_put_le32(stats.deferred, &res_msg->data[offset + 8]);
+    sys_put_le32(stats.forced, &res_msg->data[offset + 12]);
+    offset += 4 * sizeof(uint32_t);
+
+    res_msg->length = offset;
+
+    return 0;
+}
+
+// Response: (entries, residency ms) per stop mode, then wakes, last and max ED interrupt to handler
+// us, budget us and wakes over budget
+static int power_stats(struct elerium_nfc_message* res_msg) {
+    BUILD_ASSERT((4 + ((2 * ELERIUM_POWER_STOP_MODES) + 5) * sizeof(uint32_t))
+                 <= ELERIUM_NFC_MESSAGE_SIZE);
+
+    size_t offset = 4;
+
+    struct elerium_power_stats stats;
+
+    (void)elerium_power_stats(&stats);
+
+    for (size_t i = 0; i < ELERIUM_POWER_STOP_MODES; ++i) {
+        sys_put_le32(stats.stop[i].entries, &res_msg->data[offset]);
+        sys_put_le32(stats.stop[i].residency_ms, &res_msg->data[offset + 4]);
+        offset += 2 * sizeof(uint32_t);
+    }
+
+    sys_put_le32(stats.wakes, &res_msg->data[offset]);
+    sys_put_le32(stats.wake_us_last, &res_msg->data[offset + 4]);
+    sys_put_le32(stats.wake_us_max, &res_msg->data[offset + 8]);
+    sys_put_le32(stats.wake_budget_us, &res_msg->data[offset + 12]);
+    sys_put_le32(stats.over_budget, &res_msg->data[offset + 16]);
+    offset += 5 * sizeof(uint32_t);
+
+    res_msg->length = offset;
+
+    return 0;
+}
+
+// Response: reseeds, health failures and pool misses, then bytes generated and since reseed
+static int drbg_stats(struct elerium_nfc_message* res_msg) {
+    size_t offset = 4;
+
+    struct elerium_crypto_drbg_stats stats;
+
+    elerium_crypto_random_stats(&stats);
+
+    sys_put_le32(stats.reseeds, &res_msg->data[offset]);
+    sys_put_le32(stats.health_failures, &res_msg->data[offset + 4]);
+    sys_put_le32(stats.pool_misses, &res_msg->data[offset + 8]);
+    offset += 3 * sizeof(uint32_t);
+
+    sys_put_le64(stats.bytes_generated, &res_msg->data[offset]);
+    sys_put_le64(stats.bytes_since_reseed, &res_msg->data[offset + 8]);
+    offset += 2 * sizeof(uint64_t);
+
+    res_msg->length = offset;
+
+    return 0;
+}
+
+// Response: boosts, denied and failed boosts, then time spent boosted in ms
+static int clock_stats(struct elerium_nfc_message* res_msg) {
+    size_t offset = 4;
+
+    struct elerium_clock_stats stats;
+
+    (void)elerium_clock_stats(&stats);
+
+    sys_put_le32(stats.boosts, &res_msg->data[offset]);
+    sys_put_le32(stats.denied, &res_msg->data[offset + 4]);
+    sys_put_le32(stats.failed, &res_msg->data[offset + 8]);
+    sys_put_le32(stats.boost_ms, &res_msg->data[offset + 12]);
+    offset += 4 * sizeof(uint32_t);
+
+    res_msg->length = offset;
+
+    return 0;
+}
+
 static int handle_message(const struct elerium_nfc_message* req_msg,
                           struct elerium_nfc_message* res_msg) {
     int rc = -EINVAL;
@@ -48,10 +234,64 @@ static int handle_message(const struct elerium_nfc_message* req_msg,
             rc = elerium_wallet_seed(NULL, &res_msg->data[4]);
             res_msg->length = 4 + 32;
             break;
-        case ELERIUM_CMD_WALLET_SIGN:
-            rc = elerium_wallet_sign(
-                elerium_wallet_get(NULL), &req_msg->data[4], 32, &res_msg->data[4]);
+        case ELERIUM_CMD_WALLET_SIGN: {
+            // data[36] holds the BIP32 path depth, followed by little-endian indexes
+            uint32_t path[ELERIUM_WALLET_BIP32_MAX_DEPTH];
+
+            if (req_msg->length < (4 + 32 + 1)) {
+                rc = -EINVAL;
+                break;
+            }
+
+            const size_t depth = req_msg->data[4 + 32];
+
+            if ((depth > ARRAY_SIZE(path))
+                || (req_msg->length < (4 + 32 + 1 + (depth * sizeof(path[0]))))) {
+                rc = -EINVAL;
+                break;
+            }
+
+            for (size_t i = 0; i < depth; ++i) {
+                path[i] = sys_get_le32(&req_msg->data[4 + 32 + 1 + (i * sizeof(path[0]))]);
+            }
+
+            if (depth > 0) {
+                rc = elerium_wallet_sign_path(elerium_wallet_get(NULL),
+                                              path,
+                                              depth,
+                                              &req_msg->data[4],
+                                              32,
+                                              &res_msg->data[4]);
+            } else {
+                // data[1] selects the curve, zero keeps the original secp256r1 behaviour
+                rc = elerium_wallet_sign(elerium_wallet_get(NULL),
+                                         (enum elerium_crypto_curve)req_msg->data[1],
+                                         &req_msg->data[4],
+                                         32,
+                                         &res_msg->data[4]);
+            }
             res_msg->length = 4 + 64;
+        } break;
+#endif
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_PSBT)
+        case ELERIUM_CMD_WALLET_PSBT_BEGIN:
+            rc = elerium_psbt_begin();
+            break;
+
+        case ELERIUM_CMD_WALLET_PSBT_DATA:
+            if (req_msg->length < 4) {
+                rc = -EINVAL;
+                break;
+            }
+
+            rc = elerium_psbt_feed(&req_msg->data[4], req_msg->length - 4);
+            psbt_collect(res_msg);
+            break;
+
+        case ELERIUM_CMD_WALLET_PSBT_END:
+            rc = elerium_psbt_finish();
+            psbt_collect(res_msg);
             break;
 #endif
 
@@ -76,13 +316,34 @@ static int handle_message(const struct elerium_nfc_message* req_msg,
             break;
 
         case ELERIUM_CMD_URL_SIGN_PUB_KEY:
+            rc = elerium_url_sign_get_pub_raw(&res_msg->data[0], 64);
             if (rc == 0) {
-                rc = elerium_url_sign_get_pub_raw(&res_msg->data[0], 64);
                 res_msg->length = 64;
             }
             break;
 
 #endif
+
+        case ELERIUM_CMD_DIAG_BOOT_PROFILE:
+            rc = boot_profile(res_msg);
+            break;
+
+        case ELERIUM_CMD_DIAG_ENERGY:
+            rc = energy_stats(res_msg);
+            break;
+
+        case ELERIUM_CMD_DIAG_POWER:
+            rc = power_stats(res_msg);
+            break;
+
+        case ELERIUM_CMD_DIAG_DRBG:
+            rc = drbg_stats(res_msg);
+            break;
+
+        case ELERIUM_CMD_DIAG_CLOCK:
+            rc = clock_stats(res_msg);
+            break;
+
         default:
             break;
     }
@@ -91,17 +352,46 @@ static int handle_message(const struct elerium_nfc_message* req_msg,
 
 //***************************************************************************//
 
+// Request and response only live in the scratch arena while the command is served
+static void handle_comm(void) {
+    int rc;
+
+    const size_t mark = elerium_scratch_begin();
+
+    struct elerium_nfc_message* req_msg = elerium_scratch_alloc(sizeof(*req_msg));
+    struct elerium_nfc_message* res_msg = elerium_scratch_alloc(sizeof(*res_msg));
+
+    rc = elerium_nfc_take_message(req_msg);
+
+    if (rc == 0) {
+        rc = handle_message(req_msg, res_msg);
+
+        uint8_t flags = 0x00;
+        if (rc == 0) {
+            flags |= ELERIUM_NFC_MESSAGE_FLAG_OK;
+        } else {
+            flags |= ELERIUM_NFC_MESSAGE_FLAG_ERR;
+        }
+
+        // Keys are still being generated in the background, retry later
+        if (rc == -EINPROGRESS) {
+            flags |= ELERIUM_NFC_MESSAGE_FLAG_NOT_READY;
+        }
+
+        elerium_nfc_write_message(flags, res_msg);
+    }
+
+    elerium_scratch_end(mark);
+}
+
 int main(void) {
 
     while (true) {
-        int rc;
-
-        struct elerium_nfc_message req_msg = { 0 };
-        struct elerium_nfc_message res_msg = { 0 };
+        enum elerium_nfc_message_type type;
 
-        elerium_nfc_read_message(&req_msg, K_FOREVER);
+        elerium_nfc_wait_message(&type, K_FOREVER);
 
-        switch (req_msg.type) {
+        switch (type) {
 
             case ELERIUM_NFC_MESSAGE_TYPE_NDEF:
 
@@ -110,20 +400,19 @@ int main(void) {
 #endif
                 break;
 
-            case ELERIUM_NFC_MESSAGE_TYPE_COMM: {
-                rc = handle_message(&req_msg, &res_msg);
-
-                uint8_t flags = 0x00;
-                if (rc == 0) {
-                    flags |= ELERIUM_NFC_MESSAGE_FLAG_OK;
-                } else {
-                    flags |= ELERIUM_NFC_MESSAGE_FLAG_ERR;
-                }
+            case ELERIUM_NFC_MESSAGE_TYPE_COMM:
+                handle_comm();
+                break;
 
-                elerium_nfc_write_message(flags, &res_msg);
-            }
+            // Derived keys do not outlive the reader that asked for them
+            case ELERIUM_NFC_MESSAGE_TYPE_SESSION_END:
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET)
+                elerium_wallet_cache_wipe();
+#endif
+                break;
 
-            break;
+            default:
+                break;
         }
     }
 
@@ -9,6 +9,8 @@
 #include <zephyr/drivers/i2c.h>
 #include <zephyr/kernel.h>
 
+#include <string.h>
+
 #include "ntag5.h"
 
 //***************************************************************************//
@@ -23,6 +25,7 @@ struct ntag5_data {
     struct k_sem sem;
     ntag5_ed_callback ed_callback;
     struct k_work work;
+    uint32_t ed_cycle;
 };
 
 //***************************************************************************//
@@ -197,48 +200,99 @@ int ntag5_write_ndef_uri_record(const struct device* dev,
                                 const uint8_t* uri,
                                 uint8_t uri_len) {
 
-    int rc = 0;
+    int rc;
+
+    struct ntag5_ndef_writer writer;
+
+    rc = ntag5_ndef_uri_begin(dev, &writer, uri_prefix, uri_len);
+
+    if (rc == 0) {
+        rc = ntag5_ndef_uri_append(dev, &writer, uri, uri_len);
+    }
+
+    if (rc == 0) {
+        rc = ntag5_ndef_uri_end(dev, &writer);
+    }
+
+    return rc;
+}
+
+static void ndef_push(const struct device* dev, struct ntag5_ndef_writer* writer, uint8_t byte) {
+
+    writer->block.data[writer->fill++] = byte;
+
+    if (writer->fill == NTAG5_MEMORY_BLOCK_SIZE) {
+        if (writer->rc == 0) {
+            writer->rc = ntag5_write_block(dev, writer->addr, &writer->block, 1);
+        }
+
+        writer->addr++;
+        writer->fill = 0;
+    }
+}
 
-    struct ntag5_block ndef_block = {
+int ntag5_ndef_uri_begin(const struct device* dev,
+                         struct ntag5_ndef_writer* writer,
+                         uint8_t uri_prefix,
+                         size_t uri_len) {
+
+    if ((writer == NULL) || (uri_len > NTAG5_NDEF_URI_MAX_LEN)) {
+        return -EINVAL;
+    }
+
+    const struct ntag5_block cc_block = {
         .data = { NTAG5_CAPABILITY_CONTAINER },
     };
 
-    rc += ntag5_write_block(dev, NTAG5_CAPABILITY_CONTAINER_ADDRESS, &ndef_block, 1);
+    (void)memset(writer, 0x00, sizeof(*writer));
 
-    uint8_t addr = NTAG5_NDEF_MESSAGE_START_ADDRESS;
-    ndef_block.data[0] = NTAG5_TYPE_NDEF_MESSAGE;  // NDEF Message
-    ndef_block.data[1] = uri_len + 5;              // Message size
-    ndef_block.data[2] = NTAG5_NDEF_RECORD_HEADER; // Record header
-    ndef_block.data[3] = NTAG5_NDEF_TYPE_LENGTH;   // Type Length - 1 byte
-    rc += ntag5_write_block(dev, addr++, &ndef_block, 1);
+    writer->rc = ntag5_write_block(dev, NTAG5_CAPABILITY_CONTAINER_ADDRESS, &cc_block, 1);
+    writer->addr = NTAG5_NDEF_MESSAGE_START_ADDRESS;
+    writer->remaining = uri_len;
 
-    ndef_block.data[0] = uri_len + 1;         // Payload Length
-    ndef_block.data[1] = NTAG5_NDEF_URI_TYPE; // Type / URI
-    ndef_block.data[2] = uri_prefix;          // URI prefix
-    ndef_block.data[3] = uri[0];              // URI data
-    rc += ntag5_write_block(dev, addr++, &ndef_block, 1);
+    ndef_push(dev, writer, NTAG5_TYPE_NDEF_MESSAGE);  // NDEF Message
+    ndef_push(dev, writer, uri_len + 5);              // Message size
+    ndef_push(dev, writer, NTAG5_NDEF_RECORD_HEADER); // Record header
+    ndef_push(dev, writer, NTAG5_NDEF_TYPE_LENGTH);   // Type Length - 1 byte
+    ndef_push(dev, writer, uri_len + 1);              // Payload Length
+    ndef_push(dev, writer, NTAG5_NDEF_URI_TYPE);      // Type / URI
+    ndef_push(dev, writer, uri_prefix);               // URI prefix
 
-    uri_len--;
-    while (uri_len >= NTAG5_MEMORY_BLOCK_SIZE) {
+    return writer->rc;
+}
 
-        memcpy(ndef_block.data,
-               &uri[(addr - NTAG5_NDEF_MESSAGE_START_ADDRESS - 2) * NTAG5_MEMORY_BLOCK_SIZE + 1],
-               NTAG5_MEMORY_BLOCK_SIZE);
+int ntag5_ndef_uri_append(const struct device* dev,
+                          struct ntag5_ndef_writer* writer,
+                          const uint8_t* data,
+                          size_t len) {
 
-        rc += ntag5_write_block(dev, addr++, &ndef_block, 1);
-        uri_len -= NTAG5_MEMORY_BLOCK_SIZE;
+    if ((writer == NULL) || ((data == NULL) && (len > 0)) || (len > writer->remaining)) {
+        return -EINVAL;
     }
 
-    memset(ndef_block.data, 0x00, sizeof(ndef_block.data));
+    writer->remaining -= len;
 
-    memcpy(ndef_block.data,
-           &uri[(addr - NTAG5_NDEF_MESSAGE_START_ADDRESS - 2) * NTAG5_MEMORY_BLOCK_SIZE + 1],
-           uri_len % NTAG5_MEMORY_BLOCK_SIZE);
+    for (size_t i = 0; (i < len) && (writer->rc == 0); ++i) {
+        ndef_push(dev, writer, data[i]);
+    }
 
-    ndef_block.data[uri_len % NTAG5_MEMORY_BLOCK_SIZE] = NTAG5_NDEF_MESSAGE_END_MARK;
-    rc += ntag5_write_block(dev, addr, &ndef_block, 1);
+    return writer->rc;
+}
 
-    return rc;
+int ntag5_ndef_uri_end(const struct device* dev, struct ntag5_ndef_writer* writer) {
+
+    if ((writer == NULL) || (writer->remaining != 0)) {
+        return -EINVAL;
+    }
+
+    ndef_push(dev, writer, NTAG5_NDEF_MESSAGE_END_MARK);
+
+    // Pad and flush the last partial block
+    while (writer->fill != 0) {
+        ndef_push(dev, writer, 0x00);
+    }
+
+    return writer->rc;
 }
 
 //***************************************************************************//
@@ -260,6 +314,8 @@ ed_gpio_interrupt(const struct device* dev, struct gpio_callback* cbdata, uint32
 
     struct ntag5_data* const data = CONTAINER_OF(cbdata, struct ntag5_data, ed_gpio_callback);
 
+    data->ed_cycle = k_cycle_get_32();
+
     k_sem_give(&data->sem);
 
     k_work_submit(&data->work);
@@ -270,6 +326,11 @@ int ntag5_wait_on_ed(const struct device* dev, k_timeout_t timeout) {
     return k_sem_take(&data->sem, timeout);
 }
 
+uint32_t ntag5_ed_cycle(const struct device* dev) {
+    const struct ntag5_data* const data = dev->data;
+    return data->ed_cycle;
+}
+
 void ntag5_set_callback(const struct device* dev, ntag5_ed_callback callback) {
     struct ntag5_data* const data = dev->data;
     data->ed_callback = callback;
@@ -87,6 +87,8 @@
 #define NTAG5_CONFIG_MEMORY_ADDRESS_MAX 0x109F
 #define NTAG5_SESSION_REG_ADDRESS_MIN 0x10A0
 #define NTAG5_SESSION_REG_ADDRESS_MAX 0x10AF
+#define NTAG5_SRAM_ADDRESS_MIN 0x2000
+#define NTAG5_SRAM_ADDRESS_MAX 0x203F
 #define NTAG5_MEMORY_BLOCK_SIZE 4
 
 /// @brief NTAG 5 Link CONFIG registers setting
@@ -121,6 +123,17 @@
 #define NTAG5_CONFIG_2_GPIO1_HIGH_SLEW_RATE 0x02
 #define NTAG5_CONFIG_2_GPIO0_HIGH_SLEW_RATE 0x01
 
+/// @brief NTAG 5 Link STATUS session register, byte 0
+
+#define NTAG5_STATUS_0_EEPROM_WR_BUSY 0x80
+#define NTAG5_STATUS_0_EEPROM_WR_ERROR 0x40
+#define NTAG5_STATUS_0_SRAM_DATA_READY 0x20
+#define NTAG5_STATUS_0_SYNCH_BLOCK_WRITE 0x10
+#define NTAG5_STATUS_0_SYNCH_BLOCK_READ 0x08
+#define NTAG5_STATUS_0_PT_TRANSFER_DIR 0x04
+#define NTAG5_STATUS_0_VCC_SUPPLY_OK 0x02
+#define NTAG5_STATUS_0_NFC_FIELD_OK 0x01
+
 /// @brief NTAG 5 Link NDEF message setting
 
 #define NTAG5_CAPABILITY_CONTAINER_ADDRESS 0x0000
@@ -131,6 +144,8 @@
 #define NTAG5_NDEF_TYPE_LENGTH 0x01
 #define NTAG5_NDEF_URI_TYPE 'U'
 #define NTAG5_NDEF_MESSAGE_END_MARK 0xFE
+// The TLV length counts the URI and 5 record bytes, 0xFF would start a three byte length
+#define NTAG5_NDEF_URI_MAX_LEN 249
 
 /// @brief NTAG 5 Link NDEF URI prefix list
 
@@ -182,6 +197,15 @@ struct ntag5_block_spec {
     struct ntag5_block block;
 };
 
+/// @brief Incremental NDEF URI record writer, flushes one block at a time
+struct ntag5_ndef_writer {
+    uint16_t addr;
+    uint8_t fill;
+    size_t remaining;
+    struct ntag5_block block;
+    int rc;
+};
+
 typedef void (*ntag5_ed_callback)(void);
 
 //***************************************************************************//
@@ -190,6 +214,9 @@ void ntag5_set_callback(const struct device* dev, ntag5_ed_callback callback);
 
 int ntag5_wait_on_ed(const struct device* dev, k_timeout_t timeout);
 
+/// @brief Cycle count taken when the last ED interrupt entered its handler
+uint32_t ntag5_ed_cycle(const struct device* dev);
+
 int ntag5_write_block(const struct device* dev,
                       uint16_t addr,
                       const struct ntag5_block* block,
@@ -228,6 +255,18 @@ int ntag5_write_ndef_uri_record(const struct device* dev,
                                 const uint8_t* uri,
                                 uint8_t uri_len);
 
+int ntag5_ndef_uri_begin(const struct device* dev,
+                         struct ntag5_ndef_writer* writer,
+                         uint8_t uri_prefix,
+                         size_t uri_len);
+
+int ntag5_ndef_uri_append(const struct device* dev,
+                          struct ntag5_ndef_writer* writer,
+                          const uint8_t* data,
+                          size_t len);
+
+int ntag5_ndef_uri_end(const struct device* dev, struct ntag5_ndef_writer* writer);
+
 
 //***************************************************************************//
 
@@ -0,0 +1,327 @@
+//***************************************************************************//
+
+#define DT_DRV_COMPAT nxp_ntag5
+
+//***************************************************************************//
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/kernel.h>
+
+#include <string.h>
+
+#include "ntag5.h"
+#include "ntag5_emul_bottom.h"
+
+//***************************************************************************//
+
+// Emulated tag on the I2C emulator bus of native_sim. Memory and session registers live in RAM,
+// and a reader connected to the socket stands in for the NFC side of pass-through: each SRAM
+// image it sends raises SRAM_DATA_READY and the ED pin, and the I2C read of the synch block hands
+// the SRAM, by then holding the answer, back to the reader.
+
+#define NTAG5_EMUL_USER_BLOCKS (NTAG5_USER_MEMORY_ADDRESS_MAX - NTAG5_USER_MEMORY_ADDRESS_MIN + 1)
+#define NTAG5_EMUL_CONFIG_BLOCKS                                                                  \
+    (NTAG5_CONFIG_MEMORY_ADDRESS_MAX - NTAG5_CONFIG_MEMORY_ADDRESS_MIN + 1)
+#define NTAG5_EMUL_SESSION_BLOCKS                                                                 \
+    (NTAG5_SESSION_REG_ADDRESS_MAX - NTAG5_SESSION_REG_ADDRESS_MIN + 1)
+#define NTAG5_EMUL_SRAM_BLOCKS (NTAG5_SRAM_ADDRESS_MAX - NTAG5_SRAM_ADDRESS_MIN + 1)
+#define NTAG5_EMUL_SRAM_SIZE (NTAG5_EMUL_SRAM_BLOCKS * NTAG5_MEMORY_BLOCK_SIZE)
+
+// Address, then a block or a session register byte, mask and value
+#define NTAG5_EMUL_BLOCK_WRITE_LEN (2 + NTAG5_MEMORY_BLOCK_SIZE)
+#define NTAG5_EMUL_SESSION_WRITE_LEN 5
+#define NTAG5_EMUL_BLOCK_READ_LEN 2
+#define NTAG5_EMUL_SESSION_READ_LEN 3
+
+#define NTAG5_EMUL_POLL_INTERVAL K_MSEC(CONFIG_NTAG5_EMUL_POLL_MS)
+
+//***************************************************************************//
+
+struct ntag5_emul_config {
+    struct gpio_dt_spec ed_gpio;
+};
+
+struct ntag5_emul_data {
+    const struct emul* target;
+    struct k_mutex mut;
+
+    struct ntag5_block user[NTAG5_EMUL_USER_BLOCKS];
+    struct ntag5_block config[NTAG5_EMUL_CONFIG_BLOCKS];
+    struct ntag5_block session[NTAG5_EMUL_SESSION_BLOCKS];
+    struct ntag5_block sram[NTAG5_EMUL_SRAM_BLOCKS];
+
+    // Reader socket, an image is collected in rx until it is whole
+    int listen_fd;
+    int fd;
+    uint8_t rx[NTAG5_EMUL_SRAM_SIZE];
+    size_t rx_len;
+    struct k_work_delayable poll_work;
+};
+
+BUILD_ASSERT(sizeof(struct ntag5_block) == NTAG5_MEMORY_BLOCK_SIZE);
+
+//***************************************************************************//
+
+static uint16_t get_addr(const uint8_t* buf) {
+    return (uint16_t)((buf[0] << 8) | buf[1]);
+}
+
+static uint8_t* status_reg(struct ntag5_emul_data* data) {
+    return &data->session[NTAG5_SESSION_REG_STATUS - NTAG5_SESSION_REG_ADDRESS_MIN]
+                .data[NTAG5_SESSION_REG_BYTE_0];
+}
+
+static struct ntag5_block* emul_block(struct ntag5_emul_data* data, uint16_t addr) {
+
+    if (addr <= NTAG5_USER_MEMORY_ADDRESS_MAX) {
+        return &data->user[addr - NTAG5_USER_MEMORY_ADDRESS_MIN];
+    }
+
+    if ((addr >= NTAG5_CONFIG_MEMORY_ADDRESS_MIN) && (addr <= NTAG5_CONFIG_MEMORY_ADDRESS_MAX)) {
+        return &data->config[addr - NTAG5_CONFIG_MEMORY_ADDRESS_MIN];
+    }
+
+    if ((addr >= NTAG5_SRAM_ADDRESS_MIN) && (addr <= NTAG5_SRAM_ADDRESS_MAX)) {
+        return &data->sram[addr - NTAG5_SRAM_ADDRESS_MIN];
+    }
+
+    return NULL;
+}
+
+// The synch block is taken from the configuration the firmware wrote, as the tag loads it at boot
+static uint16_t synch_block(struct ntag5_emul_data* data) {
+    const struct ntag5_block* block =
+        &data->config[NTAG5_CONFIG_SYNC_DATA_BLOCK - NTAG5_CONFIG_MEMORY_ADDRESS_MIN];
+
+    return NTAG5_SRAM_ADDRESS_MIN + block->data[0];
+}
+
+// Pass-through ends on the synch block read, the reader gets the SRAM as the MCU left it
+static void sram_hand_over(struct ntag5_emul_data* data) {
+
+    *status_reg(data) &= ~NTAG5_STATUS_0_SRAM_DATA_READY;
+
+    if ((data->fd >= 0)
+        && (ntag5_emul_bottom_send(data->fd, (const uint8_t*)data->sram, NTAG5_EMUL_SRAM_SIZE)
+            != 0)) {
+        ntag5_emul_bottom_close(data->fd);
+        data->fd = -1;
+        *status_reg(data) &= ~NTAG5_STATUS_0_NFC_FIELD_OK;
+    }
+}
+
+static int block_write(struct ntag5_emul_data* data, const uint8_t* buf) {
+    struct ntag5_block* block = emul_block(data, get_addr(buf));
+
+    if (block == NULL) {
+        return -EIO;
+    }
+
+    (void)memcpy(block->data, &buf[2], sizeof(block->data));
+
+    return 0;
+}
+
+static int block_read(struct ntag5_emul_data* data, const uint8_t* buf, uint8_t* out) {
+    const uint16_t addr = get_addr(buf);
+    const struct ntag5_block* block = emul_block(data, addr);
+
+    if (block == NULL) {
+        return -EIO;
+    }
+
+    (void)memcpy(out, block->data, sizeof(block->data));
+
+    const bool pending = (*status_reg(data) & NTAG5_STATUS_0_SRAM_DATA_READY) != 0;
+
+    if (pending && (addr == synch_block(data))) {
+        sram_hand_over(data);
+    }
+
+    return 0;
+}
+
+static int session_write(struct ntag5_emul_data* data, const uint8_t* buf) {
+    const uint16_t addr = get_addr(buf);
+
+    if ((addr < NTAG5_SESSION_REG_ADDRESS_MIN) || (addr > NTAG5_SESSION_REG_ADDRESS_MAX)
+        || (buf[2] > NTAG5_SESSION_REG_BYTE_3)) {
+        return -EIO;
+    }
+
+    // STATUS only reports the tag state
+    if (addr != NTAG5_SESSION_REG_STATUS) {
+        uint8_t* reg = &data->session[addr - NTAG5_SESSION_REG_ADDRESS_MIN].data[buf[2]];
+        *reg = (*reg & ~buf[3]) | (buf[4] & buf[3]);
+    }
+
+    return 0;
+}
+
+static int session_read(struct ntag5_emul_data* data, const uint8_t* buf, uint8_t* out) {
+    const uint16_t addr = get_addr(buf);
+
+    if ((addr < NTAG5_SESSION_REG_ADDRESS_MIN) || (addr > NTAG5_SESSION_REG_ADDRESS_MAX)
+        || (buf[2] > NTAG5_SESSION_REG_BYTE_3)) {
+        return -EIO;
+    }
+
+    *out = data->session[addr - NTAG5_SESSION_REG_ADDRESS_MIN].data[buf[2]];
+
+    return 0;
+}
+
+// The driver only issues a block or register write alone, or its address followed by a read
+static int
+ntag5_emul_transfer(const struct emul* target, struct i2c_msg* msgs, int num_msgs, int addr) {
+    ARG_UNUSED(addr);
+
+    struct ntag5_emul_data* data = target->data;
+
+    int rc = -EIO;
+
+    if ((num_msgs < 1) || ((msgs[0].flags & I2C_MSG_READ) != 0)) {
+        return -EIO;
+    }
+
+    k_mutex_lock(&data->mut, K_FOREVER);
+
+    if (num_msgs == 1) {
+        if (msgs[0].len == NTAG5_EMUL_BLOCK_WRITE_LEN) {
+            rc = block_write(data, msgs[0].buf);
+        } else if (msgs[0].len == NTAG5_EMUL_SESSION_WRITE_LEN) {
+            rc = session_write(data, msgs[0].buf);
+        }
+    } else if ((num_msgs == 2) && ((msgs[1].flags & I2C_MSG_READ) != 0)) {
+        if ((msgs[0].len == NTAG5_EMUL_BLOCK_READ_LEN)
+            && (msgs[1].len == NTAG5_MEMORY_BLOCK_SIZE)) {
+            rc = block_read(data, msgs[0].buf, msgs[1].buf);
+        } else if ((msgs[0].len == NTAG5_EMUL_SESSION_READ_LEN) && (msgs[1].len == 1)) {
+            rc = session_read(data, msgs[0].buf, msgs[1].buf);
+        }
+    }
+
+    k_mutex_unlock(&data->mut);
+
+    return rc;
+}
+
+static const struct i2c_emul_api ntag5_emul_api = {
+    .transfer = ntag5_emul_transfer,
+};
+
+//***************************************************************************//
+
+// Levels are physical, the emulated input only takes them once the driver configured the pin
+static void ed_pulse(const struct gpio_dt_spec* ed_gpio) {
+    if (ed_gpio->port != NULL) {
+        const int active = ((ed_gpio->dt_flags & GPIO_ACTIVE_LOW) != 0) ? 0 : 1;
+
+        (void)gpio_emul_input_set(ed_gpio->port, ed_gpio->pin, !active);
+        (void)gpio_emul_input_set(ed_gpio->port, ed_gpio->pin, active);
+        (void)gpio_emul_input_set(ed_gpio->port, ed_gpio->pin, !active);
+    }
+}
+
+// A new reader brings the field up, its next whole image goes to the MCU once the last one was
+// handed back
+static void ntag5_emul_poll(struct k_work* work) {
+    struct k_work_delayable* dwork = k_work_delayable_from_work(work);
+    struct ntag5_emul_data* data = CONTAINER_OF(dwork, struct ntag5_emul_data, poll_work);
+    const struct ntag5_emul_config* config = data->target->cfg;
+
+    bool ready = false;
+
+    k_mutex_lock(&data->mut, K_FOREVER);
+
+    if (data->fd < 0) {
+        data->fd = ntag5_emul_bottom_accept(data->listen_fd);
+        data->rx_len = 0;
+
+        if (data->fd >= 0) {
+            *status_reg(data) |= NTAG5_STATUS_0_NFC_FIELD_OK;
+        }
+    }
+
+    if ((data->fd >= 0) && ((*status_reg(data) & NTAG5_STATUS_0_SRAM_DATA_READY) == 0)) {
+        const int len = ntag5_emul_bottom_recv(
+            data->fd, &data->rx[data->rx_len], sizeof(data->rx) - data->rx_len);
+
+        if (len < 0) {
+            ntag5_emul_bottom_close(data->fd);
+            data->fd = -1;
+            *status_reg(data) &= ~NTAG5_STATUS_0_NFC_FIELD_OK;
+        } else {
+            data->rx_len += (size_t)len;
+        }
+
+        if (data->rx_len == sizeof(data->rx)) {
+            (void)memcpy(data->sram, data->rx, sizeof(data->sram));
+            data->rx_len = 0;
+            *status_reg(data) |= NTAG5_STATUS_0_SRAM_DATA_READY;
+            ready = true;
+        }
+    }
+
+    k_mutex_unlock(&data->mut);
+
+    // The driver reads the status from its own work item, never under the lock
+    if (ready) {
+        ed_pulse(&config->ed_gpio);
+    }
+
+    (void)k_work_schedule(&data->poll_work, NTAG5_EMUL_POLL_INTERVAL);
+}
+
+static int ntag5_emul_init(const struct emul* target, const struct device* parent) {
+    ARG_UNUSED(parent);
+
+    struct ntag5_emul_data* data = target->data;
+
+    data->target = target;
+    data->fd = -1;
+    data->listen_fd = -1;
+
+    k_mutex_init(&data->mut);
+    k_work_init_delayable(&data->poll_work, ntag5_emul_poll);
+
+    *status_reg(data) = NTAG5_STATUS_0_VCC_SUPPLY_OK;
+
+    if (strlen(CONFIG_NTAG5_EMUL_SOCKET) > 0) {
+        data->listen_fd = ntag5_emul_bottom_listen(CONFIG_NTAG5_EMUL_SOCKET);
+
+        if (data->listen_fd < 0) {
+            return -EIO;
+        }
+
+        (void)k_work_schedule(&data->poll_work, NTAG5_EMUL_POLL_INTERVAL);
+    }
+
+    return 0;
+}
+
+//***************************************************************************//
+
+#define NTAG5_EMUL(inst)                                                 \
+                                                                         \
+    static const struct ntag5_emul_config ntag5_emul_config_##inst = {   \
+        .ed_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, ed_gpios, { 0 }),      \
+    };                                                                   \
+                                                                         \
+    static struct ntag5_emul_data ntag5_emul_data_##inst;                \
+                                                                         \
+    EMUL_DT_INST_DEFINE(inst,                                            \
+                        ntag5_emul_init,                                 \
+                        &ntag5_emul_data_##inst,                         \
+                        &ntag5_emul_config_##inst,                       \
+                        &ntag5_emul_api,                                 \
+                        NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(NTAG5_EMUL)
+
+//***************************************************************************//
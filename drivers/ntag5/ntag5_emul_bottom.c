@@ -0,0 +1,112 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ntag5_emul_bottom.h"
+
+//***************************************************************************//
+
+#define NTAG5_EMUL_BOTTOM_BACKLOG 1
+#define NTAG5_EMUL_BOTTOM_SEND_TIMEOUT_MS 1000
+
+//***************************************************************************//
+
+static int set_nonblocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+
+    if ((flags < 0) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)) {
+        (void)close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int ntag5_emul_bottom_listen(const char* path) {
+
+    struct sockaddr_un addr = {
+        .sun_family = AF_UNIX,
+    };
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+
+    (void)strcpy(addr.sun_path, path);
+    (void)unlink(path);
+
+    const int fd = set_nonblocking(socket(AF_UNIX, SOCK_STREAM, 0));
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    if ((bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        || (listen(fd, NTAG5_EMUL_BOTTOM_BACKLOG) != 0)) {
+        (void)close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int ntag5_emul_bottom_accept(int listen_fd) {
+    const int fd = accept(listen_fd, NULL, NULL);
+
+    return (fd < 0) ? -1 : set_nonblocking(fd);
+}
+
+int ntag5_emul_bottom_recv(int fd, uint8_t* data, size_t len) {
+
+    const ssize_t size = recv(fd, data, len, 0);
+
+    if (size > 0) {
+        return (int)size;
+    }
+
+    if ((size < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))) {
+        return 0;
+    }
+
+    return -1;
+}
+
+// Whole images are small next to the socket buffer, the wait only covers a reader that stalls
+int ntag5_emul_bottom_send(int fd, const uint8_t* data, size_t len) {
+    size_t done = 0;
+
+    struct pollfd pfd = {
+        .fd = fd,
+        .events = POLLOUT,
+    };
+
+    while (done < len) {
+        const ssize_t size = send(fd, &data[done], len - done, MSG_NOSIGNAL);
+
+        if (size > 0) {
+            done += (size_t)size;
+        } else if ((size < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+            if (poll(&pfd, 1, NTAG5_EMUL_BOTTOM_SEND_TIMEOUT_MS) <= 0) {
+                return -1;
+            }
+        } else if ((size < 0) && (errno == EINTR)) {
+            continue;
+        } else {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void ntag5_emul_bottom_close(int fd) {
+    (void)close(fd);
+}
+
+//***************************************************************************//
@@ -0,0 +1,30 @@
+#ifndef DRIVERS_NTAG5_EMUL_BOTTOM_H_
+#define DRIVERS_NTAG5_EMUL_BOTTOM_H_
+
+//***************************************************************************//
+
+#include <stddef.h>
+#include <stdint.h>
+
+//***************************************************************************//
+
+// Host side of the emulator socket, built against the host C library. Errors are -1, host errno
+// values do not mean anything on the embedded side
+
+/// @brief Non-blocking stream socket listening on path, a stale socket file is replaced
+int ntag5_emul_bottom_listen(const char* path);
+
+/// @brief Next waiting connection, -1 when none is waiting
+int ntag5_emul_bottom_accept(int listen_fd);
+
+/// @brief Bytes read without blocking, 0 when none are waiting and -1 once the peer is gone
+int ntag5_emul_bottom_recv(int fd, uint8_t* data, size_t len);
+
+/// @brief Sends all of data, 0 on success
+int ntag5_emul_bottom_send(int fd, const uint8_t* data, size_t len);
+
+void ntag5_emul_bottom_close(int fd);
+
+//***************************************************************************//
+
+#endif // DRIVERS_NTAG5_EMUL_BOTTOM_H_
@@ -0,0 +1,145 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <string.h>
+
+#include "elerium/host/comm.h"
+
+//***************************************************************************//
+
+// Same result as Zephyr's crc32_ieee_update, frames are short enough to go without a table
+uint32_t elerium_comm_crc32(uint32_t initial, const uint8_t* data, size_t len) {
+    uint32_t crc = ~initial;
+
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0);
+        }
+    }
+
+    return ~crc;
+}
+
+static void put_le32(uint32_t value, uint8_t* out) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get_le32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16)
+        | ((uint32_t)in[3] << 24);
+}
+
+int elerium_comm_encode(const struct elerium_comm_frame* frame,
+                        uint8_t sram[ELERIUM_COMM_SRAM_SIZE]) {
+
+    if ((frame == NULL) || (sram == NULL) || (frame->length > ELERIUM_COMM_DATA_MAX_LEN)) {
+        return -EINVAL;
+    }
+
+    (void)memset(sram, 0x00, ELERIUM_COMM_SRAM_SIZE);
+
+    sram[0] = ELERIUM_COMM_MAGIC_0;
+    sram[1] = ELERIUM_COMM_MAGIC_1;
+    sram[2] = frame->flags;
+    sram[3] = frame->length;
+
+    put_le32(elerium_comm_crc32(0, frame->data, frame->length), &sram[ELERIUM_COMM_BLOCK_SIZE]);
+
+    (void)memcpy(&sram[ELERIUM_COMM_HEADER_SIZE], frame->data, frame->length);
+
+    return 0;
+}
+
+int elerium_comm_decode(const uint8_t sram[ELERIUM_COMM_SRAM_SIZE],
+                        struct elerium_comm_frame* frame) {
+
+    if ((sram == NULL) || (frame == NULL)) {
+        return -EINVAL;
+    }
+
+    if ((sram[0] != ELERIUM_COMM_MAGIC_0) || (sram[1] != ELERIUM_COMM_MAGIC_1)) {
+        return -EBADMSG;
+    }
+
+    if (sram[3] > ELERIUM_COMM_DATA_MAX_LEN) {
+        return -EMSGSIZE;
+    }
+
+    frame->flags = sram[2];
+    frame->length = sram[3];
+    (void)memcpy(frame->data, &sram[ELERIUM_COMM_HEADER_SIZE], frame->length);
+
+    const uint32_t crc = get_le32(&sram[ELERIUM_COMM_BLOCK_SIZE]);
+
+    return (elerium_comm_crc32(0, frame->data, frame->length) == crc) ? 0 : -EIO;
+}
+
+int elerium_comm_request(struct elerium_comm_frame* frame,
+                         enum elerium_comm_cmd cmd,
+                         const uint8_t args[3],
+                         const void* payload,
+                         size_t len) {
+
+    if ((frame == NULL) || ((payload == NULL) && (len > 0))
+        || (len > (ELERIUM_COMM_DATA_MAX_LEN - ELERIUM_COMM_PAYLOAD_OFFSET))) {
+        return -EINVAL;
+    }
+
+    (void)memset(frame, 0x00, sizeof(*frame));
+
+    frame->data[0] = (uint8_t)cmd;
+
+    if (args != NULL) {
+        (void)memcpy(&frame->data[1], args, 3);
+    }
+
+    if (len > 0) {
+        (void)memcpy(&frame->data[ELERIUM_COMM_PAYLOAD_OFFSET], payload, len);
+    }
+
+    frame->length = (uint8_t)(ELERIUM_COMM_PAYLOAD_OFFSET + len);
+
+    return 0;
+}
+
+int elerium_comm_call(const struct elerium_comm_transport* transport,
+                      const struct elerium_comm_frame* request,
+                      struct elerium_comm_frame* response,
+                      int timeout_ms) {
+    int rc;
+
+    uint8_t sram[ELERIUM_COMM_SRAM_SIZE];
+
+    if ((transport == NULL) || (transport->exchange == NULL) || (response == NULL)) {
+        return -EINVAL;
+    }
+
+    rc = elerium_comm_encode(request, sram);
+
+    if (rc == 0) {
+        rc = transport->exchange(transport->ctx, sram, sram, timeout_ms);
+    }
+
+    if (rc == 0) {
+        rc = elerium_comm_decode(sram, response);
+    }
+
+    return rc;
+}
+
+void elerium_comm_close(struct elerium_comm_transport* transport) {
+
+    if ((transport != NULL) && (transport->close != NULL)) {
+        transport->close(transport->ctx);
+        transport->close = NULL;
+        transport->exchange = NULL;
+        transport->ctx = NULL;
+    }
+}
+
+//***************************************************************************//
@@ -0,0 +1,137 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "elerium/host/comm.h"
+
+//***************************************************************************//
+
+// Each direction carries whole SRAM images. The other end is a reader bridge or the NTAG5
+// emulator of a native_sim build, see drivers/ntag5/ntag5_emul.c and CONFIG_NTAG5_EMUL_SOCKET.
+
+struct socket_ctx {
+    int fd;
+};
+
+//***************************************************************************//
+
+static int socket_transfer(int fd, uint8_t* data, size_t len, bool write, int timeout_ms) {
+    size_t done = 0;
+
+    struct pollfd pfd = {
+        .fd = fd,
+        .events = write ? POLLOUT : POLLIN,
+    };
+
+    while (done < len) {
+        const int ready = poll(&pfd, 1, timeout_ms);
+
+        if (ready == 0) {
+            return -ETIMEDOUT;
+        }
+
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+
+        const ssize_t size = write ? send(fd, &data[done], len - done, MSG_NOSIGNAL)
+                                   : recv(fd, &data[done], len - done, 0);
+
+        if (size == 0) {
+            return -ECONNRESET;
+        }
+
+        if (size < 0) {
+            if ((errno == EINTR) || (errno == EAGAIN)) {
+                continue;
+            }
+            return -errno;
+        }
+
+        done += (size_t)size;
+    }
+
+    return 0;
+}
+
+static int socket_exchange(void* ctx,
+                           const uint8_t request[ELERIUM_COMM_SRAM_SIZE],
+                           uint8_t response[ELERIUM_COMM_SRAM_SIZE],
+                           int timeout_ms) {
+    int rc;
+
+    struct socket_ctx* sock = ctx;
+    uint8_t image[ELERIUM_COMM_SRAM_SIZE];
+
+    // The request is copied first because callers may pass one buffer for both directions
+    (void)memcpy(image, request, sizeof(image));
+
+    rc = socket_transfer(sock->fd, image, sizeof(image), true, timeout_ms);
+
+    if (rc == 0) {
+        rc = socket_transfer(sock->fd, response, ELERIUM_COMM_SRAM_SIZE, false, timeout_ms);
+    }
+
+    return rc;
+}
+
+static void socket_close(void* ctx) {
+    struct socket_ctx* sock = ctx;
+
+    (void)close(sock->fd);
+    free(sock);
+}
+
+int elerium_comm_socket_open(const char* path, struct elerium_comm_transport* transport) {
+
+    if ((path == NULL) || (transport == NULL)) {
+        return -EINVAL;
+    }
+
+    struct sockaddr_un addr = {
+        .sun_family = AF_UNIX,
+    };
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return -ENAMETOOLONG;
+    }
+
+    (void)strcpy(addr.sun_path, path);
+
+    struct socket_ctx* sock = calloc(1, sizeof(*sock));
+    if (sock == NULL) {
+        return -ENOMEM;
+    }
+
+    sock->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if ((sock->fd < 0) || (connect(sock->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)) {
+        const int rc = -errno;
+
+        if (sock->fd >= 0) {
+            (void)close(sock->fd);
+        }
+        free(sock);
+
+        return rc;
+    }
+
+    transport->exchange = socket_exchange;
+    transport->close = socket_close;
+    transport->ctx = sock;
+
+    return 0;
+}
+
+//***************************************************************************//
@@ -0,0 +1,98 @@
+#ifndef ELERIUM_HOST_COMM_H_
+#define ELERIUM_HOST_COMM_H_
+
+//***************************************************************************//
+
+#include <stddef.h>
+#include <stdint.h>
+
+//***************************************************************************//
+
+// NTAG5 SRAM window shared with the tag, a header block, a CRC block, then data
+#define ELERIUM_COMM_SRAM_SIZE 256
+#define ELERIUM_COMM_BLOCK_SIZE 4
+#define ELERIUM_COMM_HEADER_SIZE (2 * ELERIUM_COMM_BLOCK_SIZE)
+
+// The tag writes data up to the block before the pass-through control block
+#define ELERIUM_COMM_DATA_MAX_LEN (60 * ELERIUM_COMM_BLOCK_SIZE)
+
+#define ELERIUM_COMM_MAGIC_0 0xE1
+#define ELERIUM_COMM_MAGIC_1 0xED
+
+#define ELERIUM_COMM_FLAG_OK (1u << 0)
+#define ELERIUM_COMM_FLAG_ERR (1u << 1)
+#define ELERIUM_COMM_FLAG_NOT_READY (1u << 2)
+
+// Command byte, then three argument bytes, then the payload
+#define ELERIUM_COMM_PAYLOAD_OFFSET 4
+
+//***************************************************************************//
+
+enum elerium_comm_cmd {
+    ELERIUM_COMM_CMD_WALLET_CREATE = 0xA0,
+    ELERIUM_COMM_CMD_WALLET_SIGN = 0xA1,
+    ELERIUM_COMM_CMD_WALLET_SEED = 0xA2,
+    ELERIUM_COMM_CMD_WALLET_PSBT_BEGIN = 0xA3,
+    ELERIUM_COMM_CMD_WALLET_PSBT_DATA = 0xA4,
+    ELERIUM_COMM_CMD_WALLET_PSBT_END = 0xA5,
+
+    ELERIUM_COMM_CMD_URL_SIGN_PROGRAM = 0xB0,
+    ELERIUM_COMM_CMD_URL_SIGN_PUB_KEY = 0xB1,
+    ELERIUM_COMM_CMD_URL_SIGN_RESET = 0xB2,
+
+    ELERIUM_COMM_CMD_DIAG_BOOT_PROFILE = 0xC0,
+    ELERIUM_COMM_CMD_DIAG_ENERGY = 0xC1,
+    ELERIUM_COMM_CMD_DIAG_POWER = 0xC2,
+    ELERIUM_COMM_CMD_DIAG_DRBG = 0xC3,
+    ELERIUM_COMM_CMD_DIAG_CLOCK = 0xC4,
+};
+
+struct elerium_comm_frame {
+    uint8_t flags;
+    uint8_t length;
+    uint8_t data[ELERIUM_COMM_DATA_MAX_LEN];
+};
+
+/// @brief Moves one SRAM image to the tag and waits for the image it answers with
+struct elerium_comm_transport {
+    int (*exchange)(void* ctx,
+                    const uint8_t request[ELERIUM_COMM_SRAM_SIZE],
+                    uint8_t response[ELERIUM_COMM_SRAM_SIZE],
+                    int timeout_ms);
+    void (*close)(void* ctx);
+    void* ctx;
+};
+
+//***************************************************************************//
+
+/// @brief CRC-32/IEEE as computed by the firmware over the data bytes
+uint32_t elerium_comm_crc32(uint32_t initial, const uint8_t* data, size_t len);
+
+int elerium_comm_encode(const struct elerium_comm_frame* frame,
+                        uint8_t sram[ELERIUM_COMM_SRAM_SIZE]);
+
+/// @brief Returns -EBADMSG without the magic, -EMSGSIZE for a bad length and -EIO on a CRC error
+int elerium_comm_decode(const uint8_t sram[ELERIUM_COMM_SRAM_SIZE],
+                        struct elerium_comm_frame* frame);
+
+/// @brief Request frame for cmd with args in bytes 1 to 3 and payload from byte 4
+int elerium_comm_request(struct elerium_comm_frame* frame,
+                         enum elerium_comm_cmd cmd,
+                         const uint8_t args[3],
+                         const void* payload,
+                         size_t len);
+
+/// @brief One command round trip, the tag's status is left in response->flags
+int elerium_comm_call(const struct elerium_comm_transport* transport,
+                      const struct elerium_comm_frame* request,
+                      struct elerium_comm_frame* response,
+                      int timeout_ms);
+
+/// @brief Stream socket to a reader bridge or the NTAG5 emulator of a native_sim firmware
+int elerium_comm_socket_open(const char* path, struct elerium_comm_transport* transport);
+
+void elerium_comm_close(struct elerium_comm_transport* transport);
+
+//***************************************************************************//
+
+#endif // ELERIUM_HOST_COMM_H_
@@ -0,0 +1,253 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "elerium/host/comm.h"
+
+//***************************************************************************//
+
+#define SCENARIO_MAX_TAPS 256
+#define COMMAND_COUNT 256
+
+//***************************************************************************//
+
+struct command_stats {
+    size_t count;
+    size_t cap;
+    double* latency_ms;
+
+    size_t ok;
+    size_t err;
+    size_t not_ready;
+    size_t failed;
+};
+
+//***************************************************************************//
+
+static double now_ms(void) {
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((double)ts.tv_sec * 1e3) + ((double)ts.tv_nsec / 1e6);
+}
+
+static int compare_double(const void* a, const void* b) {
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+// A scenario line is one tap: the frame data as hex bytes, command byte first, # starts a comment
+static int scenario_load(const char* path, struct elerium_comm_frame* taps, size_t* count) {
+    char line[4 * ELERIUM_COMM_DATA_MAX_LEN];
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -errno;
+    }
+
+    *count = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        struct elerium_comm_frame* tap = &taps[*count];
+        char* p = line;
+
+        (void)memset(tap, 0x00, sizeof(*tap));
+
+        while (*p != '\0') {
+            unsigned value;
+            int used;
+
+            if ((*p == '#') || (*p == '\n')) {
+                break;
+            }
+
+            if ((*p == ' ') || (*p == '\t') || (*p == '\r')) {
+                ++p;
+                continue;
+            }
+
+            if ((sscanf(p, "%2x%n", &value, &used) != 1)
+                || (tap->length >= ELERIUM_COMM_DATA_MAX_LEN)) {
+                (void)fclose(file);
+                return -EINVAL;
+            }
+
+            tap->data[tap->length++] = (uint8_t)value;
+            p += used;
+        }
+
+        // Requests carry the command and its three argument bytes at least
+        if (tap->length > 0) {
+            tap->length = (tap->length < ELERIUM_COMM_PAYLOAD_OFFSET) ? ELERIUM_COMM_PAYLOAD_OFFSET
+                                                                      : tap->length;
+
+            if (++(*count) == SCENARIO_MAX_TAPS) {
+                break;
+            }
+        }
+    }
+
+    (void)fclose(file);
+
+    return (*count > 0) ? 0 : -ENODATA;
+}
+
+static void stats_add(struct command_stats* stats, double latency_ms, int rc, uint8_t flags) {
+
+    if (stats->count == stats->cap) {
+        const size_t cap = (stats->cap > 0) ? (stats->cap * 2) : 64;
+        double* latency = realloc(stats->latency_ms, cap * sizeof(latency[0]));
+
+        if (latency == NULL) {
+            return;
+        }
+
+        stats->latency_ms = latency;
+        stats->cap = cap;
+    }
+
+    stats->latency_ms[stats->count++] = latency_ms;
+
+    if (rc != 0) {
+        ++stats->failed;
+    } else if (flags & ELERIUM_COMM_FLAG_NOT_READY) {
+        ++stats->not_ready;
+    } else if (flags & ELERIUM_COMM_FLAG_OK) {
+        ++stats->ok;
+    } else {
+        ++stats->err;
+    }
+}
+
+static double percentile(const struct command_stats* stats, double p) {
+    const size_t index = (size_t)((p / 100.0) * (double)(stats->count - 1) + 0.5);
+
+    return stats->latency_ms[index];
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s -s <socket> [-n iterations] [-t timeout_ms] <scenario>\n"
+            "  replays every tap of the scenario n times and reports per command\n",
+            name);
+}
+
+int main(int argc, char** argv) {
+    int rc;
+    int opt;
+
+    const char* socket_path = NULL;
+    unsigned long iterations = 100;
+    int timeout_ms = 5000;
+
+    while ((opt = getopt(argc, argv, "s:n:t:h")) != -1) {
+        switch (opt) {
+            case 's':
+                socket_path = optarg;
+                break;
+            case 'n':
+                iterations = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                timeout_ms = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+
+    if ((socket_path == NULL) || (optind >= argc)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static struct elerium_comm_frame taps[SCENARIO_MAX_TAPS];
+    static struct command_stats stats[COMMAND_COUNT];
+    size_t tap_count = 0;
+
+    rc = scenario_load(argv[optind], taps, &tap_count);
+    if (rc != 0) {
+        fprintf(stderr, "scenario %s: %s\n", argv[optind], strerror(-rc));
+        return 1;
+    }
+
+    struct elerium_comm_transport transport;
+
+    rc = elerium_comm_socket_open(socket_path, &transport);
+    if (rc != 0) {
+        fprintf(stderr, "socket %s: %s\n", socket_path, strerror(-rc));
+        return 1;
+    }
+
+    size_t calls = 0;
+    const double start = now_ms();
+
+    for (unsigned long i = 0; (rc != -ECONNRESET) && (i < iterations); ++i) {
+        for (size_t t = 0; t < tap_count; ++t) {
+            struct elerium_comm_frame response = { 0 };
+
+            const double sent = now_ms();
+
+            rc = elerium_comm_call(&transport, &taps[t], &response, timeout_ms);
+
+            stats_add(&stats[taps[t].data[0]], now_ms() - sent, rc, response.flags);
+            ++calls;
+
+            if (rc == -ECONNRESET) {
+                fprintf(stderr, "connection closed by the tag\n");
+                break;
+            }
+        }
+    }
+
+    const double elapsed_ms = now_ms() - start;
+
+    elerium_comm_close(&transport);
+
+    printf("%zu calls in %.1f ms, %.1f calls/s\n", calls, elapsed_ms, (calls * 1e3) / elapsed_ms);
+    printf("cmd  count     ok    err  !rdy   fail    calls/s"
+           "   p50 ms   p90 ms   p99 ms   max ms\n");
+
+    for (size_t cmd = 0; cmd < COMMAND_COUNT; ++cmd) {
+        struct command_stats* s = &stats[cmd];
+
+        if (s->count == 0) {
+            continue;
+        }
+
+        double busy_ms = 0;
+        for (size_t i = 0; i < s->count; ++i) {
+            busy_ms += s->latency_ms[i];
+        }
+
+        qsort(s->latency_ms, s->count, sizeof(s->latency_ms[0]), compare_double);
+
+        printf("%02zX %7zu %6zu %6zu %5zu %6zu %10.1f %8.2f %8.2f %8.2f %8.2f\n",
+               cmd,
+               s->count,
+               s->ok,
+               s->err,
+               s->not_ready,
+               s->failed,
+               (s->count * 1e3) / busy_ms,
+               percentile(s, 50),
+               percentile(s, 90),
+               percentile(s, 99),
+               s->latency_ms[s->count - 1]);
+
+        free(s->latency_ms);
+    }
+
+    return 0;
+}
+
+//***************************************************************************//
@@ -0,0 +1,213 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "elerium/host/comm.h"
+#include "ntag5_emul_bottom.h"
+
+//***************************************************************************//
+
+// The tag side is the socket half of the native_sim NTAG5 emulator, answering as the firmware does
+
+#define TEST_TIMEOUT_MS 1000
+#define TEST_ROUND_TRIPS 3
+#define TEST_PATH_MAX_LEN 64
+
+#define TEST_EXPECT(cond)                                                                       \
+    do {                                                                                        \
+        if (!(cond)) {                                                                          \
+            printf("%s:%d: %s: %s\n", __FILE__, __LINE__, name, #cond);                         \
+            ++failed;                                                                           \
+        }                                                                                       \
+    } while (0)
+
+//***************************************************************************//
+
+enum tag_mode {
+    // Answers with the request data reversed
+    TAG_MODE_ANSWER,
+    // Takes the request and keeps the SRAM
+    TAG_MODE_SILENT,
+    // Drops the reader after the request
+    TAG_MODE_CLOSE,
+};
+
+struct tag {
+    int listen_fd;
+    enum tag_mode mode;
+    size_t exchanges;
+};
+
+//***************************************************************************//
+
+static int tag_accept(int listen_fd) {
+
+    for (int wait_ms = 0; wait_ms < TEST_TIMEOUT_MS; ++wait_ms) {
+        const int fd = ntag5_emul_bottom_accept(listen_fd);
+
+        if (fd >= 0) {
+            return fd;
+        }
+
+        (void)usleep(1000);
+    }
+
+    return -1;
+}
+
+static int tag_recv(int fd, uint8_t sram[ELERIUM_COMM_SRAM_SIZE]) {
+    size_t done = 0;
+
+    for (int wait_ms = 0; (done < ELERIUM_COMM_SRAM_SIZE) && (wait_ms < TEST_TIMEOUT_MS);) {
+        const int len = ntag5_emul_bottom_recv(fd, &sram[done], ELERIUM_COMM_SRAM_SIZE - done);
+
+        if (len < 0) {
+            return -1;
+        }
+
+        if (len == 0) {
+            (void)usleep(1000);
+            ++wait_ms;
+        }
+
+        done += (size_t)len;
+    }
+
+    return (done == ELERIUM_COMM_SRAM_SIZE) ? 0 : -1;
+}
+
+// The firmware leaves its answer in the same SRAM the request came in
+static void* tag_run(void* arg) {
+    struct tag* tag = arg;
+    struct elerium_comm_frame frame;
+    uint8_t sram[ELERIUM_COMM_SRAM_SIZE];
+
+    const int fd = tag_accept(tag->listen_fd);
+
+    while ((fd >= 0) && (tag_recv(fd, sram) == 0)) {
+        ++tag->exchanges;
+
+        if (tag->mode == TAG_MODE_CLOSE) {
+            break;
+        }
+
+        if ((tag->mode == TAG_MODE_SILENT) || (elerium_comm_decode(sram, &frame) != 0)) {
+            continue;
+        }
+
+        struct elerium_comm_frame answer = {
+            .flags = ELERIUM_COMM_FLAG_OK,
+            .length = frame.length,
+        };
+
+        for (size_t i = 0; i < frame.length; ++i) {
+            answer.data[i] = frame.data[frame.length - 1 - i];
+        }
+
+        if ((elerium_comm_encode(&answer, sram) != 0)
+            || (ntag5_emul_bottom_send(fd, sram, sizeof(sram)) != 0)) {
+            break;
+        }
+    }
+
+    if (fd >= 0) {
+        ntag5_emul_bottom_close(fd);
+    }
+
+    return NULL;
+}
+
+static int test_round_trip(const char* path) {
+    const char* name = "round_trip";
+    int failed = 0;
+
+    struct tag tag = { .mode = TAG_MODE_ANSWER };
+    struct elerium_comm_transport transport;
+    struct elerium_comm_frame request;
+    struct elerium_comm_frame response;
+    pthread_t thread;
+
+    tag.listen_fd = ntag5_emul_bottom_listen(path);
+    TEST_EXPECT(tag.listen_fd >= 0);
+    TEST_EXPECT(pthread_create(&thread, NULL, tag_run, &tag) == 0);
+    TEST_EXPECT(elerium_comm_socket_open(path, &transport) == 0);
+
+    // Each request takes the SRAM back from the tag before the next one is written
+    for (size_t i = 0; i < TEST_ROUND_TRIPS; ++i) {
+        const uint8_t args[3] = { (uint8_t)i, 0x01, 0x02 };
+        const char payload[] = "ping";
+
+        TEST_EXPECT(elerium_comm_request(&request,
+                                         ELERIUM_COMM_CMD_DIAG_CLOCK,
+                                         args,
+                                         payload,
+                                         sizeof(payload))
+                    == 0);
+        TEST_EXPECT(elerium_comm_call(&transport, &request, &response, TEST_TIMEOUT_MS) == 0);
+
+        TEST_EXPECT(response.flags == ELERIUM_COMM_FLAG_OK);
+        TEST_EXPECT(response.length == request.length);
+        TEST_EXPECT(response.data[request.length - 1] == ELERIUM_COMM_CMD_DIAG_CLOCK);
+        TEST_EXPECT(response.data[request.length - 2] == i);
+    }
+
+    elerium_comm_close(&transport);
+
+    TEST_EXPECT(pthread_join(thread, NULL) == 0);
+    TEST_EXPECT(tag.exchanges == TEST_ROUND_TRIPS);
+
+    ntag5_emul_bottom_close(tag.listen_fd);
+
+    return failed;
+}
+
+// A request the tag never answers, or a reader it drops, ends the call instead of hanging it
+static int test_no_answer(const char* path, enum tag_mode mode, int expected_rc) {
+    const char* name = (mode == TAG_MODE_SILENT) ? "silent" : "close";
+    int failed = 0;
+
+    struct tag tag = { .mode = mode };
+    struct elerium_comm_transport transport;
+    struct elerium_comm_frame request;
+    struct elerium_comm_frame response;
+    pthread_t thread;
+
+    tag.listen_fd = ntag5_emul_bottom_listen(path);
+    TEST_EXPECT(tag.listen_fd >= 0);
+    TEST_EXPECT(pthread_create(&thread, NULL, tag_run, &tag) == 0);
+    TEST_EXPECT(elerium_comm_socket_open(path, &transport) == 0);
+
+    TEST_EXPECT(elerium_comm_request(&request, ELERIUM_COMM_CMD_DIAG_POWER, NULL, NULL, 0) == 0);
+    TEST_EXPECT(elerium_comm_call(&transport, &request, &response, TEST_TIMEOUT_MS / 4)
+                == expected_rc);
+
+    elerium_comm_close(&transport);
+
+    TEST_EXPECT(pthread_join(thread, NULL) == 0);
+    TEST_EXPECT(tag.exchanges == 1);
+
+    ntag5_emul_bottom_close(tag.listen_fd);
+
+    return failed;
+}
+
+int main(void) {
+    int failed = 0;
+    char path[TEST_PATH_MAX_LEN];
+
+    (void)snprintf(path, sizeof(path), "elerium_comm_test_%ld.sock", (long)getpid());
+
+    failed += test_round_trip(path);
+    failed += test_no_answer(path, TAG_MODE_SILENT, -ETIMEDOUT);
+    failed += test_no_answer(path, TAG_MODE_CLOSE, -ECONNRESET);
+
+    (void)unlink(path);
+
+    return (failed == 0) ? 0 : 1;
+}
+
+//***************************************************************************//
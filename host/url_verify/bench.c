@@ -0,0 +1,196 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/x509.h>
+
+#include "elerium/host/url_verify.h"
+
+//***************************************************************************//
+
+#define BENCH_TAGS 64
+#define BENCH_URLS 4096
+#define BENCH_URL_MAX_LEN 256
+
+// Tags are named by their device ID, as {uid} renders it
+#define BENCH_TEMPLATE "example.com/t/{uid}?v=1&ctr={ctr}&rnd={rnd}&sign={sig}"
+#define BENCH_TAMPER_OFFSET (sizeof("https://example.com/t/000000000000000000000000?v=1&ctr=") - 1)
+
+//***************************************************************************//
+
+struct bench_tag {
+    char name[ELERIUM_URL_VERIFY_TAG_MAX_LEN + 1];
+    EVP_PKEY* key;
+};
+
+//***************************************************************************//
+
+static double now_s(void) {
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+// Rendered like the firmware's hex format, the message is signed with "sign=" empty
+static size_t bench_url(const struct bench_tag* tag, uint32_t ctr, char* url) {
+    char message[BENCH_URL_MAX_LEN];
+    uint8_t sig[ELERIUM_URL_VERIFY_SIG_SIZE];
+    uint8_t der[ELERIUM_URL_VERIFY_SIG_SIZE + 8];
+    size_t der_len = sizeof(der);
+
+    const int len = snprintf(message,
+                             sizeof(message),
+                             "example.com/t/%s?v=1&ctr=%u&rnd=%u%u&sign=",
+                             tag->name,
+                             (unsigned)ctr,
+                             (unsigned)rand(),
+                             (unsigned)rand());
+
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+
+    (void)EVP_DigestSignInit(ctx, NULL, EVP_sha256(), NULL, tag->key);
+    (void)EVP_DigestSign(ctx, der, &der_len, (const uint8_t*)message, len);
+    EVP_MD_CTX_free(ctx);
+
+    const unsigned char* data = der;
+    ECDSA_SIG* ecdsa_sig = d2i_ECDSA_SIG(NULL, &data, (long)der_len);
+    const BIGNUM* r;
+    const BIGNUM* s;
+
+    ECDSA_SIG_get0(ecdsa_sig, &r, &s);
+    (void)BN_bn2binpad(r, sig, sizeof(sig) / 2);
+    (void)BN_bn2binpad(s, &sig[sizeof(sig) / 2], sizeof(sig) / 2);
+    ECDSA_SIG_free(ecdsa_sig);
+
+    size_t pos = (size_t)snprintf(url, BENCH_URL_MAX_LEN, "https://%s", message);
+
+    for (size_t i = 0; i < sizeof(sig); ++i) {
+        pos += (size_t)snprintf(&url[pos], BENCH_URL_MAX_LEN - pos, "%02x", sig[i]);
+    }
+
+    return pos;
+}
+
+// Raw X || Y as the tag reports it, the tail of the SubjectPublicKeyInfo encoding
+static EVP_PKEY* bench_key(uint8_t* pub_key) {
+    EVP_PKEY* key = NULL;
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+
+    if ((ctx == NULL) || (EVP_PKEY_keygen_init(ctx) != 1)
+        || (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, NID_X9_62_prime256v1) != 1)
+        || (EVP_PKEY_keygen(ctx, &key) != 1)) {
+        EVP_PKEY_CTX_free(ctx);
+        return NULL;
+    }
+
+    EVP_PKEY_CTX_free(ctx);
+
+    uint8_t spki[BENCH_URL_MAX_LEN];
+    uint8_t* data = spki;
+    const int len = i2d_PUBKEY(key, &data);
+
+    if ((len < ELERIUM_URL_VERIFY_PUB_KEY_SIZE) || (len > (int)sizeof(spki))) {
+        EVP_PKEY_free(key);
+        return NULL;
+    }
+
+    (void)memcpy(pub_key,
+                 &spki[len - ELERIUM_URL_VERIFY_PUB_KEY_SIZE],
+                 ELERIUM_URL_VERIFY_PUB_KEY_SIZE);
+
+    return key;
+}
+
+int main(int argc, char** argv) {
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    const unsigned max_threads = (argc > 1) ? (unsigned)atoi(argv[1]) : (unsigned)cores;
+
+    struct elerium_url_verifier_config config = {
+        .capacity = BENCH_TAGS,
+        .template = BENCH_TEMPLATE,
+    };
+
+    struct elerium_url_verifier* verifier = elerium_url_verifier_create(&config);
+    struct bench_tag* tags = calloc(BENCH_TAGS, sizeof(tags[0]));
+    struct elerium_url_verify_job* jobs = calloc(BENCH_URLS, sizeof(jobs[0]));
+    char* urls = calloc(BENCH_URLS, BENCH_URL_MAX_LEN);
+
+    if ((verifier == NULL) || (tags == NULL) || (jobs == NULL) || (urls == NULL)) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < BENCH_TAGS; ++i) {
+        uint8_t pub_key[ELERIUM_URL_VERIFY_PUB_KEY_SIZE];
+
+        tags[i].key = bench_key(pub_key);
+        (void)snprintf(tags[i].name, sizeof(tags[i].name), "%024zx", i);
+
+        if ((tags[i].key == NULL)
+            || (elerium_url_verifier_add_key(verifier, tags[i].name, pub_key) != 0)) {
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < BENCH_URLS; ++i) {
+        const struct bench_tag* tag = &tags[i % BENCH_TAGS];
+        char* url = &urls[i * BENCH_URL_MAX_LEN];
+
+        jobs[i].tag = tag->name;
+        jobs[i].url = url;
+        jobs[i].url_len = bench_url(tag, (uint32_t)i, url);
+    }
+
+    printf("%d URLs, %d tags, %ld cores\n", BENCH_URLS, BENCH_TAGS, cores);
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        const double start = now_s();
+
+        (void)elerium_url_verify_batch(verifier, jobs, BENCH_URLS, threads);
+
+        const double elapsed = now_s() - start;
+
+        size_t failed = 0;
+        for (size_t i = 0; i < BENCH_URLS; ++i) {
+            failed += (jobs[i].rc != 0) ? 1 : 0;
+        }
+
+        const double rate = BENCH_URLS / elapsed;
+        const double per_core = rate / (double)((threads < cores) ? threads : cores);
+
+        printf("threads %2u: %9.0f verify/s, %9.0f verify/s/core, %zu failed\n",
+               threads,
+               rate,
+               per_core,
+               failed);
+    }
+
+    // A tampered counter has to be rejected
+    ((char*)jobs[0].url)[BENCH_TAMPER_OFFSET] = '9';
+    printf("tampered: %d\n",
+           elerium_url_verify(verifier, jobs[0].tag, jobs[0].url, jobs[0].url_len, NULL));
+
+    for (size_t i = 0; i < BENCH_TAGS; ++i) {
+        EVP_PKEY_free(tags[i].key);
+    }
+
+    elerium_url_verifier_destroy(verifier);
+    free(tags);
+    free(jobs);
+    free(urls);
+
+    return 0;
+}
+
+//***************************************************************************//
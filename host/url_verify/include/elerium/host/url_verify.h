@@ -0,0 +1,92 @@
+#ifndef ELERIUM_HOST_URL_VERIFY_H_
+#define ELERIUM_HOST_URL_VERIFY_H_
+
+//***************************************************************************//
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//***************************************************************************//
+
+#define ELERIUM_URL_VERIFY_PUB_KEY_SIZE 64
+#define ELERIUM_URL_VERIFY_SIG_SIZE 64
+#define ELERIUM_URL_VERIFY_TAG_MAX_LEN 32
+
+//***************************************************************************//
+
+struct elerium_url_verifier;
+
+struct elerium_url_verifier_config {
+    // Number of tags whose keys are kept decoded
+    size_t capacity;
+
+    // URL template as programmed into the tags, without the scheme. A template with
+    // placeholders names its format in the v parameter, a plain URL accepts the default query of
+    // either format. Literal text right after {uid}, {ctr} or a decimal {rnd} must not start
+    // with a character that field can hold.
+    const char* template;
+};
+
+/// @brief Signed URL split around the signature value, the message is head then tail
+struct elerium_url_fields {
+    const char* head;
+    size_t head_len;
+    const char* tail;
+    size_t tail_len;
+
+    // 1 for hex and decimal fields, 2 for base64url
+    uint8_t version;
+    uint8_t sig[ELERIUM_URL_VERIFY_SIG_SIZE];
+
+    const char* uid;
+    size_t uid_len;
+
+    bool has_ctr;
+    uint32_t ctr;
+};
+
+struct elerium_url_verify_job {
+    const char* tag;
+    const char* url;
+    size_t url_len;
+
+    // Filled by the batch
+    int rc;
+    struct elerium_url_fields fields;
+};
+
+//***************************************************************************//
+
+struct elerium_url_verifier*
+elerium_url_verifier_create(const struct elerium_url_verifier_config* config);
+
+void elerium_url_verifier_destroy(struct elerium_url_verifier* verifier);
+
+/// @brief Decodes and validates the raw X || Y key read from the tag once, replaces an older key
+int elerium_url_verifier_add_key(struct elerium_url_verifier* verifier,
+                                 const char* tag,
+                                 const uint8_t pub_key[ELERIUM_URL_VERIFY_PUB_KEY_SIZE]);
+
+/// @brief Matches the URL against the template, an https:// prefix is not part of the message
+int elerium_url_parse(const struct elerium_url_verifier* verifier,
+                      const char* url,
+                      size_t url_len,
+                      struct elerium_url_fields* fields);
+
+/// @brief Returns 0, -EINVAL off the template, -ENOENT for unknown tags, -EACCES for bad signatures
+int elerium_url_verify(const struct elerium_url_verifier* verifier,
+                       const char* tag,
+                       const char* url,
+                       size_t url_len,
+                       struct elerium_url_fields* fields);
+
+/// @brief Splits the jobs over threads, each job gets its own rc
+int elerium_url_verify_batch(const struct elerium_url_verifier* verifier,
+                             struct elerium_url_verify_job* jobs,
+                             size_t count,
+                             unsigned threads);
+
+//***************************************************************************//
+
+#endif // ELERIUM_HOST_URL_VERIFY_H_
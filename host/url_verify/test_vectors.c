@@ -0,0 +1,101 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "elerium/host/url_verify.h"
+#include "url_sign_vectors.h"
+
+//***************************************************************************//
+
+#define TEST_URL_MAX_LEN 256
+
+#define TEST_EXPECT(cond)                                                                       \
+    do {                                                                                        \
+        if (!(cond)) {                                                                          \
+            printf("%s:%d: vector %zu: %s\n", __FILE__, __LINE__, i, #cond);                   \
+            ++failed;                                                                           \
+        }                                                                                       \
+    } while (0)
+
+//***************************************************************************//
+
+// The tag prepends the scheme, so the backend receives it with every URL
+static size_t test_url(const char* url, char* out) {
+    return (size_t)snprintf(out, TEST_URL_MAX_LEN, "https://%s", url);
+}
+
+int main(void) {
+    int failed = 0;
+
+    for (size_t i = 0; i < (sizeof(url_sign_vectors) / sizeof(url_sign_vectors[0])); ++i) {
+        const struct url_sign_vector* vector = &url_sign_vectors[i];
+
+        const struct elerium_url_verifier_config config = {
+            .capacity = 1,
+            .template = vector->template,
+        };
+
+        struct elerium_url_verifier* verifier = elerium_url_verifier_create(&config);
+        struct elerium_url_fields fields;
+        char url[TEST_URL_MAX_LEN];
+
+        TEST_EXPECT(verifier != NULL);
+
+        if (verifier == NULL) {
+            continue;
+        }
+
+        TEST_EXPECT(elerium_url_verifier_add_key(verifier, vector->uid, url_sign_vector_pub_key)
+                    == 0);
+
+        size_t len = test_url(vector->url, url);
+
+        TEST_EXPECT(elerium_url_verify(verifier, vector->uid, url, len, &fields) == 0);
+        TEST_EXPECT(fields.version == vector->version);
+        TEST_EXPECT(fields.has_ctr && (fields.ctr == vector->ctr));
+        TEST_EXPECT(memcmp(fields.sig, vector->sig, sizeof(fields.sig)) == 0);
+        TEST_EXPECT((fields.uid_len == 0)
+                    || ((fields.uid_len == strlen(vector->uid))
+                        && (memcmp(fields.uid, vector->uid, fields.uid_len) == 0)));
+
+        // Without the scheme the message is the same
+        len = strlen(vector->url);
+
+        TEST_EXPECT(elerium_url_verify(verifier, vector->uid, vector->url, len, NULL) == 0);
+
+        len = test_url(vector->url, url);
+
+        TEST_EXPECT(elerium_url_verify(verifier, "other", url, len, NULL) == -ENOENT);
+
+        // Only the exact scheme the tag renders is stripped
+        len = (size_t)snprintf(url, sizeof(url), "http://%s", vector->url);
+
+        TEST_EXPECT(elerium_url_verify(verifier, vector->uid, url, len, NULL) == -EINVAL);
+
+        // A changed nonce keeps the URL on the template but breaks the signature
+        len = test_url(vector->url, url);
+
+        char* const rnd = strstr(url, "rnd=") + strlen("rnd=");
+        *rnd = (*rnd == '9') ? '8' : '9';
+
+        TEST_EXPECT(elerium_url_verify(verifier, vector->uid, url, len, NULL) == -EACCES);
+
+        // The other version's encoding does not fit this template
+        len = test_url(vector->url, url);
+
+        char* const version = strstr(url, "v=") + strlen("v=");
+        *version = (*version == '1') ? '2' : '1';
+
+        TEST_EXPECT(elerium_url_verify(verifier, vector->uid, url, len, NULL) == -EINVAL);
+
+        elerium_url_verifier_destroy(verifier);
+    }
+
+    printf("%s\n", (failed == 0) ? "PASS" : "FAIL");
+
+    return (failed == 0) ? 0 : 1;
+}
+
+//***************************************************************************//
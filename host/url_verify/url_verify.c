@@ -0,0 +1,760 @@
+//***************************************************************************//
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include "elerium/host/url_verify.h"
+
+//***************************************************************************//
+
+#define SIG_HEX_LEN (ELERIUM_URL_VERIFY_SIG_SIZE * 2)
+#define SIG_BASE64URL_LEN (((ELERIUM_URL_VERIFY_SIG_SIZE * 4) + 2) / 3)
+#define RND_BASE64URL_LEN (((sizeof(uint64_t) * 4) + 2) / 3)
+#define RND_DEC_MAX_LEN (sizeof("18446744073709551615") - 1)
+#define CTR_MAX_LEN (sizeof("4294967295") - 1)
+
+// Same limits as the firmware's compiled templates
+#define TEMPLATE_MAX_SEGMENTS 16
+#define TEMPLATE_MAX_LEN 256
+#define TEMPLATE_VERSIONS 2
+
+// The tag stores https:// as an NDEF prefix code, so it is not signed
+#define URL_SCHEME "https://"
+
+//***************************************************************************//
+
+enum url_segment_type {
+    URL_SEGMENT_TEXT,
+    URL_SEGMENT_UID,
+    URL_SEGMENT_CTR,
+    URL_SEGMENT_RND,
+    URL_SEGMENT_SIG,
+};
+
+struct url_segment {
+    enum url_segment_type type;
+    size_t offset;
+    size_t len;
+};
+
+/// @brief URL as rendered by the firmware, literal text segments point into text
+struct url_template {
+    // Zero for a format the template does not accept
+    uint8_t version;
+    size_t count;
+    size_t text_len;
+    struct url_segment segments[TEMPLATE_MAX_SEGMENTS];
+    char text[TEMPLATE_MAX_LEN];
+};
+
+struct key_entry {
+    char tag[ELERIUM_URL_VERIFY_TAG_MAX_LEN + 1];
+    EVP_PKEY* key;
+};
+
+struct elerium_url_verifier {
+    pthread_rwlock_t lock;
+
+    // Indexed by version minus one
+    struct url_template templates[TEMPLATE_VERSIONS];
+
+    // Open addressing, at most half full so probes stay short
+    size_t mask;
+    size_t count;
+    struct key_entry* entries;
+};
+
+struct batch_slice {
+    const struct elerium_url_verifier* verifier;
+    struct elerium_url_verify_job* jobs;
+    size_t count;
+};
+
+// SubjectPublicKeyInfo of a P-256 key up to the uncompressed point
+static const uint8_t p256_spki_header[] = {
+    0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01,
+    0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04,
+};
+
+//***************************************************************************//
+
+static int template_compile(const char* url, struct elerium_url_verifier* verifier);
+static int template_match(const struct url_template* template,
+                          const char* url,
+                          const char* end,
+                          struct elerium_url_fields* fields);
+static size_t tag_hash(const char* tag);
+static struct key_entry* key_find(const struct elerium_url_verifier* verifier, const char* tag);
+static int hex_value(char c);
+static int base64url_value(char c);
+static int sig_decode(uint8_t version, const char* text, size_t len, uint8_t* sig);
+static int sig_verify(EVP_PKEY* key, const struct elerium_url_fields* fields);
+
+//***************************************************************************//
+
+struct elerium_url_verifier*
+elerium_url_verifier_create(const struct elerium_url_verifier_config* config) {
+
+    if ((config == NULL) || (config->capacity == 0) || (config->template == NULL)) {
+        return NULL;
+    }
+
+    struct elerium_url_verifier* verifier = calloc(1, sizeof(*verifier));
+    if (verifier == NULL) {
+        return NULL;
+    }
+
+    size_t slots = 2;
+    while (slots < (config->capacity * 2)) {
+        slots *= 2;
+    }
+
+    verifier->entries = calloc(slots, sizeof(verifier->entries[0]));
+    if (verifier->entries == NULL) {
+        free(verifier);
+        return NULL;
+    }
+
+    if (template_compile(config->template, verifier) != 0) {
+        free(verifier->entries);
+        free(verifier);
+        return NULL;
+    }
+
+    verifier->mask = slots - 1;
+
+    (void)pthread_rwlock_init(&verifier->lock, NULL);
+
+    return verifier;
+}
+
+void elerium_url_verifier_destroy(struct elerium_url_verifier* verifier) {
+
+    if (verifier == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i <= verifier->mask; ++i) {
+        EVP_PKEY_free(verifier->entries[i].key);
+    }
+
+    (void)pthread_rwlock_destroy(&verifier->lock);
+
+    free(verifier->entries);
+    free(verifier);
+}
+
+int elerium_url_verifier_add_key(struct elerium_url_verifier* verifier,
+                                 const char* tag,
+                                 const uint8_t pub_key[ELERIUM_URL_VERIFY_PUB_KEY_SIZE]) {
+    int rc = 0;
+
+    if ((verifier == NULL) || (tag == NULL) || (pub_key == NULL)
+        || (strlen(tag) > ELERIUM_URL_VERIFY_TAG_MAX_LEN)) {
+        return -EINVAL;
+    }
+
+    // Uncompressed SEC1 point, checked against the curve here and never again per URL
+    uint8_t spki[sizeof(p256_spki_header) + ELERIUM_URL_VERIFY_PUB_KEY_SIZE];
+    (void)memcpy(spki, p256_spki_header, sizeof(p256_spki_header));
+    (void)memcpy(&spki[sizeof(p256_spki_header)], pub_key, ELERIUM_URL_VERIFY_PUB_KEY_SIZE);
+
+    const unsigned char* data = spki;
+    EVP_PKEY* key = d2i_PUBKEY(NULL, &data, sizeof(spki));
+    EVP_PKEY_CTX* check = (key != NULL) ? EVP_PKEY_CTX_new(key, NULL) : NULL;
+    const bool valid = (check != NULL) && (EVP_PKEY_public_check(check) == 1);
+
+    EVP_PKEY_CTX_free(check);
+
+    if (!valid) {
+        EVP_PKEY_free(key);
+        return -EINVAL;
+    }
+
+    (void)pthread_rwlock_wrlock(&verifier->lock);
+
+    struct key_entry* entry = key_find(verifier, tag);
+
+    if (entry->key == NULL) {
+        if (((verifier->count + 1) * 2) > (verifier->mask + 1)) {
+            rc = -ENOSPC;
+        } else {
+            ++verifier->count;
+            (void)strcpy(entry->tag, tag);
+        }
+    }
+
+    if (rc == 0) {
+        EVP_PKEY_free(entry->key);
+        entry->key = key;
+    }
+
+    (void)pthread_rwlock_unlock(&verifier->lock);
+
+    if (rc != 0) {
+        EVP_PKEY_free(key);
+    }
+
+    return rc;
+}
+
+int elerium_url_parse(const struct elerium_url_verifier* verifier,
+                      const char* url,
+                      size_t url_len,
+                      struct elerium_url_fields* fields) {
+    int rc = -EINVAL;
+
+    if ((verifier == NULL) || (url == NULL) || (fields == NULL)) {
+        return -EINVAL;
+    }
+
+    const char* const end = url + url_len;
+    const size_t scheme_len = strlen(URL_SCHEME);
+
+    if ((url_len >= scheme_len) && (memcmp(url, URL_SCHEME, scheme_len) == 0)) {
+        url += scheme_len;
+    }
+
+    // The templates of the two versions differ in their v parameter, so at most one matches
+    for (size_t i = 0; (rc != 0) && (i < TEMPLATE_VERSIONS); ++i) {
+        if (verifier->templates[i].version != 0) {
+            rc = template_match(&verifier->templates[i], url, end, fields);
+        }
+    }
+
+    return rc;
+}
+
+int elerium_url_verify(const struct elerium_url_verifier* verifier,
+                       const char* tag,
+                       const char* url,
+                       size_t url_len,
+                       struct elerium_url_fields* fields) {
+    int rc;
+
+    struct elerium_url_fields parsed;
+
+    if (fields == NULL) {
+        fields = &parsed;
+    }
+
+    if (tag == NULL) {
+        return -EINVAL;
+    }
+
+    rc = elerium_url_parse(verifier, url, url_len, fields);
+
+    if (rc == 0) {
+        (void)pthread_rwlock_rdlock((pthread_rwlock_t*)&verifier->lock);
+
+        const struct key_entry* entry = key_find(verifier, tag);
+
+        rc = (entry->key != NULL) ? sig_verify(entry->key, fields) : -ENOENT;
+
+        (void)pthread_rwlock_unlock((pthread_rwlock_t*)&verifier->lock);
+    }
+
+    return rc;
+}
+
+static void* batch_run(void* arg) {
+    struct batch_slice* slice = arg;
+
+    for (size_t i = 0; i < slice->count; ++i) {
+        struct elerium_url_verify_job* job = &slice->jobs[i];
+
+        job->rc =
+            elerium_url_verify(slice->verifier, job->tag, job->url, job->url_len, &job->fields);
+    }
+
+    return NULL;
+}
+
+int elerium_url_verify_batch(const struct elerium_url_verifier* verifier,
+                             struct elerium_url_verify_job* jobs,
+                             size_t count,
+                             unsigned threads) {
+
+    if ((verifier == NULL) || ((jobs == NULL) && (count > 0))) {
+        return -EINVAL;
+    }
+
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    if (threads > count) {
+        threads = (count > 0) ? (unsigned)count : 1;
+    }
+
+    pthread_t* ids = calloc(threads, sizeof(ids[0]));
+    struct batch_slice* slices = calloc(threads, sizeof(slices[0]));
+    bool* started = calloc(threads, sizeof(started[0]));
+
+    if ((ids == NULL) || (slices == NULL) || (started == NULL)) {
+        free(ids);
+        free(slices);
+        free(started);
+        return -ENOMEM;
+    }
+
+    // Contiguous slices keep each thread on its own cache lines of the job array
+    size_t offset = 0;
+    for (unsigned i = 0; i < threads; ++i) {
+        const size_t share = (count / threads) + ((i < (count % threads)) ? 1 : 0);
+
+        slices[i].verifier = verifier;
+        slices[i].jobs = &jobs[offset];
+        slices[i].count = share;
+        offset += share;
+
+        // The calling thread takes the first slice, and any slice a thread could not start
+        if (i > 0) {
+            started[i] = (pthread_create(&ids[i], NULL, batch_run, &slices[i]) == 0);
+        }
+    }
+
+    for (unsigned i = 0; i < threads; ++i) {
+        if (!started[i]) {
+            (void)batch_run(&slices[i]);
+        }
+    }
+
+    for (unsigned i = 0; i < threads; ++i) {
+        if (started[i]) {
+            (void)pthread_join(ids[i], NULL);
+        }
+    }
+
+    free(ids);
+    free(slices);
+    free(started);
+
+    return 0;
+}
+
+//***************************************************************************//
+
+static int template_add(struct url_template* template,
+                        enum url_segment_type type,
+                        const char* text,
+                        size_t len) {
+
+    if ((type == URL_SEGMENT_TEXT) && (len == 0)) {
+        return 0;
+    }
+
+    if (template->count >= TEMPLATE_MAX_SEGMENTS) {
+        return -ENOMEM;
+    }
+
+    struct url_segment* segment = &template->segments[template->count];
+
+    segment->type = type;
+    segment->offset = template->text_len;
+    segment->len = 0;
+
+    if (type == URL_SEGMENT_TEXT) {
+        if (len > (sizeof(template->text) - template->text_len)) {
+            return -ENOMEM;
+        }
+
+        // Merge adjacent literals
+        if ((template->count > 0) && (segment[-1].type == URL_SEGMENT_TEXT)) {
+            --segment;
+        } else {
+            ++template->count;
+        }
+
+        (void)memcpy(&template->text[template->text_len], text, len);
+        template->text_len += len;
+        segment->len += len;
+
+    } else {
+        ++template->count;
+    }
+
+    return 0;
+}
+
+// Same placeholders as the firmware, which rejects any other brace
+static int template_parse(const char* url, struct url_template* template) {
+    static const struct {
+        const char* name;
+        enum url_segment_type type;
+    } fields[] = {
+        { "{uid}", URL_SEGMENT_UID },
+        { "{ctr}", URL_SEGMENT_CTR },
+        { "{rnd}", URL_SEGMENT_RND },
+        { "{sig}", URL_SEGMENT_SIG },
+    };
+
+    int rc = 0;
+
+    const char* text = url;
+
+    while ((rc == 0) && (*url != '\0')) {
+        if (*url != '{') {
+            ++url;
+            continue;
+        }
+
+        size_t i;
+        for (i = 0; i < (sizeof(fields) / sizeof(fields[0])); ++i) {
+            if (strncmp(url, fields[i].name, strlen(fields[i].name)) == 0) {
+                break;
+            }
+        }
+
+        if (i == (sizeof(fields) / sizeof(fields[0]))) {
+            return -EINVAL;
+        }
+
+        rc = template_add(template, URL_SEGMENT_TEXT, text, url - text);
+
+        if (rc == 0) {
+            rc = template_add(template, fields[i].type, NULL, 0);
+        }
+
+        url += strlen(fields[i].name);
+        text = url;
+    }
+
+    if (rc == 0) {
+        rc = template_add(template, URL_SEGMENT_TEXT, text, url - text);
+    }
+
+    return rc;
+}
+
+// Value of the v parameter in the query, zero when it is missing or unknown
+static uint8_t template_version(const char* url) {
+    for (const char* p = strchr(url, '?'); p != NULL; p = strchr(p + 1, '&')) {
+        if ((strncmp(p + 1, "v=", 2) == 0) && (p[3] >= '1')
+            && (p[3] <= ('0' + TEMPLATE_VERSIONS)) && ((p[4] == '&') || (p[4] == '\0'))) {
+            return (uint8_t)(p[3] - '0');
+        }
+    }
+
+    return 0;
+}
+
+// A plain URL is rendered with the default query of the format the firmware was built with
+int template_compile(const char* url, struct elerium_url_verifier* verifier) {
+    static const char* const default_queries[TEMPLATE_VERSIONS] = {
+        "?v=1&ctr={ctr}&rnd={rnd}&sign={sig}",
+        "?v=2&ctr={ctr}&rnd={rnd}&sign={sig}",
+    };
+
+    int rc = -EINVAL;
+
+    const bool plain = (strchr(url, '{') == NULL);
+    const uint8_t version = template_version(url);
+
+    for (uint8_t i = 0; i < TEMPLATE_VERSIONS; ++i) {
+        struct url_template* template = &verifier->templates[i];
+
+        if (!plain && (version != (i + 1))) {
+            continue;
+        }
+
+        template->version = i + 1;
+        rc = template_parse(url, template);
+
+        if ((rc == 0) && plain) {
+            rc = template_parse(default_queries[i], template);
+        }
+
+        if (rc != 0) {
+            break;
+        }
+    }
+
+    size_t sig_count = 0;
+
+    for (size_t i = 0; (rc == 0) && (i < TEMPLATE_VERSIONS); ++i) {
+        for (size_t j = 0; j < verifier->templates[i].count; ++j) {
+            sig_count += (verifier->templates[i].segments[j].type == URL_SEGMENT_SIG) ? 1 : 0;
+        }
+    }
+
+    // One signature per accepted format, as the firmware requires
+    if ((rc == 0) && (sig_count != (plain ? TEMPLATE_VERSIONS : 1))) {
+        rc = -EINVAL;
+    }
+
+    return rc;
+}
+
+static size_t span(const char* text, const char* end, size_t max_len, int (*value)(char c)) {
+    size_t len = 0;
+
+    while ((len < max_len) && (&text[len] < end) && (value(text[len]) >= 0)) {
+        ++len;
+    }
+
+    return len;
+}
+
+static int dec_value(char c) {
+    return ((c >= '0') && (c <= '9')) ? (c - '0') : -1;
+}
+
+// Fields have the firmware's alphabets and lengths, a URL that leaves any text over is rejected
+int template_match(const struct url_template* template,
+                   const char* url,
+                   const char* end,
+                   struct elerium_url_fields* fields) {
+    const bool base64url = (template->version == 2);
+    const char* const start = url;
+    const char* sig = NULL;
+    size_t sig_len = 0;
+
+    fields->version = template->version;
+    fields->uid = NULL;
+    fields->uid_len = 0;
+    fields->has_ctr = false;
+    fields->ctr = 0;
+
+    for (size_t i = 0; i < template->count; ++i) {
+        const struct url_segment* segment = &template->segments[i];
+        size_t len;
+
+        switch (segment->type) {
+        case URL_SEGMENT_TEXT:
+            len = segment->len;
+
+            if (((size_t)(end - url) < len)
+                || (memcmp(url, &template->text[segment->offset], len) != 0)) {
+                return -EINVAL;
+            }
+            break;
+
+        case URL_SEGMENT_UID:
+            len = span(url, end, (size_t)(end - url), hex_value);
+
+            // Every occurrence renders the same ID
+            if ((len == 0) || ((len % 2) != 0)
+                || ((fields->uid != NULL)
+                    && ((len != fields->uid_len) || (memcmp(url, fields->uid, len) != 0)))) {
+                return -EINVAL;
+            }
+
+            fields->uid = url;
+            fields->uid_len = len;
+            break;
+
+        case URL_SEGMENT_CTR: {
+            uint64_t value = 0;
+
+            len = span(url, end, CTR_MAX_LEN, dec_value);
+
+            for (size_t j = 0; j < len; ++j) {
+                value = (value * 10) + (uint64_t)dec_value(url[j]);
+            }
+
+            if ((len == 0) || (value > UINT32_MAX)
+                || (fields->has_ctr && (fields->ctr != (uint32_t)value))) {
+                return -EINVAL;
+            }
+
+            fields->has_ctr = true;
+            fields->ctr = (uint32_t)value;
+            break;
+        }
+
+        case URL_SEGMENT_RND:
+            len = base64url ? span(url, end, RND_BASE64URL_LEN, base64url_value)
+                            : span(url, end, RND_DEC_MAX_LEN, dec_value);
+
+            if ((len == 0) || (base64url && (len != RND_BASE64URL_LEN))) {
+                return -EINVAL;
+            }
+            break;
+
+        case URL_SEGMENT_SIG:
+            sig_len = base64url ? SIG_BASE64URL_LEN : SIG_HEX_LEN;
+            len = span(url, end, sig_len, base64url ? base64url_value : hex_value);
+
+            if (len != sig_len) {
+                return -EINVAL;
+            }
+
+            sig = url;
+            break;
+
+        default:
+            return -EINVAL;
+        }
+
+        url += len;
+    }
+
+    if ((url != end) || (sig == NULL)) {
+        return -EINVAL;
+    }
+
+    fields->head = start;
+    fields->head_len = sig - start;
+    fields->tail = sig + sig_len;
+    fields->tail_len = end - fields->tail;
+
+    return sig_decode(template->version, sig, sig_len, fields->sig);
+}
+
+// FNV-1a
+size_t tag_hash(const char* tag) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    while (*tag != '\0') {
+        hash = (hash ^ (uint8_t)*tag++) * 0x100000001B3ull;
+    }
+
+    return (size_t)hash;
+}
+
+// Returns the entry holding tag, or the free slot it would go to
+struct key_entry* key_find(const struct elerium_url_verifier* verifier, const char* tag) {
+    size_t slot = tag_hash(tag) & verifier->mask;
+
+    while ((verifier->entries[slot].key != NULL)
+           && (strcmp(verifier->entries[slot].tag, tag) != 0)) {
+        slot = (slot + 1) & verifier->mask;
+    }
+
+    return &verifier->entries[slot];
+}
+
+int hex_value(char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+
+    if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+
+    if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+int base64url_value(char c) {
+    if ((c >= 'A') && (c <= 'Z')) {
+        return c - 'A';
+    }
+
+    if ((c >= 'a') && (c <= 'z')) {
+        return c - 'a' + 26;
+    }
+
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0' + 52;
+    }
+
+    if (c == '-') {
+        return 62;
+    }
+
+    if (c == '_') {
+        return 63;
+    }
+
+    return -1;
+}
+
+int sig_decode(uint8_t version, const char* text, size_t len, uint8_t* sig) {
+
+    if ((version == 1) && (len == SIG_HEX_LEN)) {
+        for (size_t i = 0; i < ELERIUM_URL_VERIFY_SIG_SIZE; ++i) {
+            const int hi = hex_value(text[2 * i]);
+            const int lo = hex_value(text[(2 * i) + 1]);
+
+            if ((hi < 0) || (lo < 0)) {
+                return -EINVAL;
+            }
+
+            sig[i] = (uint8_t)((hi << 4) | lo);
+        }
+
+        return 0;
+    }
+
+    if ((version == 2) && (len == SIG_BASE64URL_LEN)) {
+        uint32_t group = 0;
+        size_t bits = 0;
+        size_t pos = 0;
+
+        for (size_t i = 0; i < len; ++i) {
+            const int value = base64url_value(text[i]);
+
+            if (value < 0) {
+                return -EINVAL;
+            }
+
+            group = (group << 6) | (uint32_t)value;
+            bits += 6;
+
+            if (bits >= 8) {
+                bits -= 8;
+                sig[pos++] = (uint8_t)(group >> bits);
+            }
+        }
+
+        return (pos == ELERIUM_URL_VERIFY_SIG_SIZE) ? 0 : -EINVAL;
+    }
+
+    return -EINVAL;
+}
+
+// Signatures are raw r || s over the SHA-256 of the message, OpenSSL takes them DER encoded
+int sig_verify(EVP_PKEY* key, const struct elerium_url_fields* fields) {
+    int rc = -ENOMEM;
+
+    const size_t half = ELERIUM_URL_VERIFY_SIG_SIZE / 2;
+
+    unsigned char* der = NULL;
+    int der_len = 0;
+
+    ECDSA_SIG* ecdsa_sig = ECDSA_SIG_new();
+    BIGNUM* r = BN_bin2bn(fields->sig, half, NULL);
+    BIGNUM* s = BN_bin2bn(&fields->sig[half], half, NULL);
+
+    if ((ecdsa_sig != NULL) && (r != NULL) && (s != NULL)
+        && (ECDSA_SIG_set0(ecdsa_sig, r, s) == 1)) {
+        // Owned by the signature from here on
+        r = NULL;
+        s = NULL;
+
+        der_len = i2d_ECDSA_SIG(ecdsa_sig, &der);
+    }
+
+    EVP_MD_CTX* ctx = (der_len > 0) ? EVP_MD_CTX_new() : NULL;
+
+    // The firmware signs the message with the signature value left empty
+    if ((ctx != NULL) && (EVP_DigestVerifyInit(ctx, NULL, EVP_sha256(), NULL, key) == 1)
+        && (EVP_DigestVerifyUpdate(ctx, fields->head, fields->head_len) == 1)
+        && (EVP_DigestVerifyUpdate(ctx, fields->tail, fields->tail_len) == 1)) {
+        const int valid = EVP_DigestVerifyFinal(ctx, der, (size_t)der_len);
+        rc = (valid == 1) ? 0 : -EACCES;
+    }
+
+    EVP_MD_CTX_free(ctx);
+    OPENSSL_free(der);
+    BN_free(r);
+    BN_free(s);
+    ECDSA_SIG_free(ecdsa_sig);
+
+    return rc;
+}
+
+//***************************************************************************//
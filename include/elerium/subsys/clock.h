@@ -0,0 +1,34 @@
+#ifndef ELERIUM_SUBSYS_CLOCK_H_
+#define ELERIUM_SUBSYS_CLOCK_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+//***************************************************************************//
+
+enum elerium_clock_level {
+    ELERIUM_CLOCK_LEVEL_LOW,
+    ELERIUM_CLOCK_LEVEL_BOOST,
+};
+
+struct elerium_clock_stats {
+    uint32_t boosts;
+    // Boost requests refused for a low supply
+    uint32_t denied;
+    uint32_t failed;
+    uint32_t boost_ms;
+};
+
+//***************************************************************************//
+
+/// @brief Run the core at the boost clock until the matching end, calls nest across threads
+void elerium_clock_boost_begin(void);
+
+void elerium_clock_boost_end(void);
+
+int elerium_clock_stats(struct elerium_clock_stats* stats);
+
+//***************************************************************************//
+
+#endif // ELERIUM_SUBSYS_CLOCK_H_
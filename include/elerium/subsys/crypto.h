@@ -10,6 +10,11 @@
 
 //***************************************************************************//
 
+enum elerium_crypto_curve {
+    ELERIUM_CRYPTO_CURVE_SECP256R1,
+    ELERIUM_CRYPTO_CURVE_SECP256K1,
+};
+
 struct elerium_signature {
     uint8_t data[64];
 };
@@ -31,6 +36,40 @@ struct elerium_key_pair {
     struct elerium_pub_key pub;
 };
 
+/// @brief Running SHA-256 state, layout compatible with the backend state
+struct elerium_sha256_ctx {
+    uint32_t iv[8];
+    uint64_t bits_hashed;
+    uint8_t leftover[64];
+    size_t leftover_offset;
+};
+
+/// @brief Fixed-layout SHA-256 midstate, safe to persist in storage
+struct elerium_sha256_midstate {
+    uint32_t iv[8];
+    uint64_t bits_hashed;
+    uint8_t leftover[64];
+    uint8_t leftover_len;
+};
+
+/// @brief One signature of a batch, result is set by the batch and 0 for a valid signature
+struct elerium_crypto_verify_item {
+    const struct elerium_pub_key* pub_key;
+    const void* hash;
+    size_t hash_len;
+    const struct elerium_signature* sign;
+    int result;
+};
+
+struct elerium_crypto_drbg_stats {
+    uint32_t reseeds;
+    uint32_t health_failures;
+    // Requests that found the pool empty and generated inline
+    uint32_t pool_misses;
+    uint64_t bytes_generated;
+    uint64_t bytes_since_reseed;
+};
+
 //***************************************************************************//
 
 int elerium_crypto_generate(struct elerium_priv_key* priv_key, struct elerium_pub_key* pub_key);
@@ -47,7 +86,54 @@ int elerium_crypto_verify(struct elerium_pub_key* pub_key,
 
 int elerium_crypto_sha256(const void* data, size_t data_len, struct elerium_hash* hash);
 
-uint64_t elerium_crypto_random(void);
+int elerium_crypto_sha256_init(struct elerium_sha256_ctx* ctx);
+
+int elerium_crypto_sha256_update(struct elerium_sha256_ctx* ctx,
+                                 const void* data,
+                                 size_t data_len);
+
+int elerium_crypto_sha256_final(struct elerium_sha256_ctx* ctx, struct elerium_hash* hash);
+
+void elerium_crypto_sha256_clone(struct elerium_sha256_ctx* dst,
+                                 const struct elerium_sha256_ctx* src);
+
+int elerium_crypto_sha256_export(const struct elerium_sha256_ctx* ctx,
+                                 struct elerium_sha256_midstate* midstate);
+
+int elerium_crypto_sha256_import(struct elerium_sha256_ctx* ctx,
+                                 const struct elerium_sha256_midstate* midstate);
+
+int elerium_crypto_random(uint64_t* value);
+
+int elerium_crypto_random_fill(void* data, size_t len);
+
+void elerium_crypto_random_stats(struct elerium_crypto_drbg_stats* stats);
+
+int elerium_crypto_secp256k1_generate(struct elerium_priv_key* priv_key);
+
+int elerium_crypto_secp256k1_get_pub(const struct elerium_priv_key* priv_key,
+                                     struct elerium_pub_key* pub_key);
+
+int elerium_crypto_secp256k1_sign(const struct elerium_priv_key* priv_key,
+                                  const void* hash,
+                                  size_t hash_len,
+                                  struct elerium_signature* sign);
+
+int elerium_crypto_secp256k1_sign_taproot(const struct elerium_priv_key* priv_key,
+                                          const void* hash,
+                                          size_t hash_len,
+                                          struct elerium_signature* sign);
+
+int elerium_crypto_secp256k1_taproot_key(const uint8_t* internal_key, uint8_t* output_key);
+
+int elerium_crypto_secp256k1_verify(const struct elerium_pub_key* pub_key,
+                                    const void* hash,
+                                    size_t hash_len,
+                                    const struct elerium_signature* sign);
+
+/// @brief Verifies every item, items sharing a public key parse it once
+/// @return 0 when every signature is valid, -EFAULT otherwise
+int elerium_crypto_secp256k1_verify_batch(struct elerium_crypto_verify_item* items, size_t count);
 
 //***************************************************************************//
 
@@ -0,0 +1,54 @@
+#ifndef ELERIUM_SUBSYS_ENERGY_H_
+#define ELERIUM_SUBSYS_ENERGY_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+//***************************************************************************//
+
+/// @brief Background job classes, each needs a minimum supply voltage to start
+enum elerium_energy_cost {
+    // Sector copy and erase
+    ELERIUM_ENERGY_COST_FLASH,
+    // One signature
+    ELERIUM_ENERGY_COST_SIGN,
+    // Key generation and its save
+    ELERIUM_ENERGY_COST_KEYGEN,
+    // Nonce pool refill and DRBG reseed
+    ELERIUM_ENERGY_COST_DRBG,
+    ELERIUM_ENERGY_COST_COUNT,
+};
+
+struct elerium_energy_stats {
+    // Last samples in mV, 0 when no sensor is available
+    uint16_t supply_mv;
+    uint16_t min_supply_mv;
+    // Only sampled by elerium_energy_vbat_mv
+    uint16_t vbat_mv;
+    uint32_t samples;
+    uint32_t admitted;
+    uint32_t deferred;
+    // Admitted below the threshold after too many deferrals
+    uint32_t forced;
+};
+
+//***************************************************************************//
+
+/// @brief Supply voltage in mV, sampled at most once per sample interval, 0 when unknown
+uint16_t elerium_energy_supply_mv(void);
+
+/// @brief Samples vbat now, for diagnostics only since each sample powers the vbat bridge
+uint16_t elerium_energy_vbat_mv(void);
+
+/// @brief 0 when a job of this cost may start now, -EAGAIN when it should wait for more headroom
+int elerium_energy_admit(enum elerium_energy_cost cost);
+
+/// @brief For worker jobs: true when the job was rescheduled on the worker and must return now
+bool elerium_energy_defer(struct k_work_delayable* work, enum elerium_energy_cost cost);
+
+int elerium_energy_stats(struct elerium_energy_stats* stats);
+
+//***************************************************************************//
+
+#endif // ELERIUM_SUBSYS_ENERGY_H_
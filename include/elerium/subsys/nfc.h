@@ -12,14 +12,21 @@
 #define ELERIUM_NFC_HEADER_SIZE (4 + 4)
 #define ELERIUM_NFC_MESSAGE_SIZE (ELERIUM_NFC_SRAM_SIZE - ELERIUM_NFC_HEADER_SIZE)
 
+// Longest URL with a one byte NDEF TLV length, see NTAG5_NDEF_URI_MAX_LEN
+#define ELERIUM_NFC_NDEF_URL_MAX_LEN 249
+
 #define ELERIUM_NFC_MESSAGE_FLAG_OK BIT(0)
 #define ELERIUM_NFC_MESSAGE_FLAG_ERR BIT(1)
+#define ELERIUM_NFC_MESSAGE_FLAG_NOT_READY BIT(2)
 
 //***************************************************************************//
 
+/// @brief NDEF means the record was read during the session that just ended or went quiet
 enum elerium_nfc_message_type {
     ELERIUM_NFC_MESSAGE_TYPE_COMM,
     ELERIUM_NFC_MESSAGE_TYPE_NDEF,
+    ELERIUM_NFC_MESSAGE_TYPE_SESSION_START,
+    ELERIUM_NFC_MESSAGE_TYPE_SESSION_END,
 };
 
 struct elerium_nfc_message {
@@ -30,12 +37,25 @@ struct elerium_nfc_message {
 
 //***************************************************************************//
 
+/// @brief Called once through elerium_subsys_require
+int elerium_nfc_init(void);
+
 int elerium_nfc_read_message(struct elerium_nfc_message* message, k_timeout_t timeout);
 
+/// @brief Wait for the next tap without holding a buffer, take a COMM payload afterwards
+int elerium_nfc_wait_message(enum elerium_nfc_message_type* type, k_timeout_t timeout);
+
+int elerium_nfc_take_message(struct elerium_nfc_message* message);
+
 int elerium_nfc_write_message(uint8_t flags, const struct elerium_nfc_message* message);
 
 int elerium_nfc_set_ndef_url(const char* url, size_t url_len);
 
+/// @brief Stream an NDEF URL of url_len bytes in pieces, end must follow a successful begin
+int elerium_nfc_ndef_url_begin(size_t url_len);
+int elerium_nfc_ndef_url_append(const char* data, size_t len);
+int elerium_nfc_ndef_url_end(void);
+
 //***************************************************************************//
 
 #endif // ELERIUM_SUBSYS_NFC_H_
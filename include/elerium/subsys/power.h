@@ -0,0 +1,48 @@
+#ifndef ELERIUM_SUBSYS_POWER_H_
+#define ELERIUM_SUBSYS_POWER_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+//***************************************************************************//
+
+// Stop 0 to 2, indexed by the power state substate minus one
+#define ELERIUM_POWER_STOP_MODES 3
+
+//***************************************************************************//
+
+struct elerium_power_stop_stats {
+    uint32_t entries;
+    uint32_t residency_ms;
+};
+
+struct elerium_power_stats {
+    struct elerium_power_stop_stats stop[ELERIUM_POWER_STOP_MODES];
+    // Tag events that woke the SoC from a stop mode
+    uint32_t wakes;
+    // From the ED interrupt to the event handler, the hardware exit before the interrupt is the
+    // devicetree exit latency and is not part of it
+    uint32_t wake_us_last;
+    uint32_t wake_us_max;
+    uint32_t wake_budget_us;
+    // Handled later than the budget minus the exit latency of the mode left
+    uint32_t over_budget;
+};
+
+//***************************************************************************//
+
+/// @brief Keep the SoC out of stop modes until the matching put, calls nest
+void elerium_power_stop_lock_get(void);
+
+void elerium_power_stop_lock_put(void);
+
+/// @brief Called when a tag event is handled with the cycle count of its interrupt, measures the
+/// wake-up if it ended a stop mode
+void elerium_power_wake_event(uint32_t irq_cycle);
+
+int elerium_power_stats(struct elerium_power_stats* stats);
+
+//***************************************************************************//
+
+#endif // ELERIUM_SUBSYS_POWER_H_
@@ -0,0 +1,31 @@
+#ifndef ELERIUM_SUBSYS_PSBT_H_
+#define ELERIUM_SUBSYS_PSBT_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+#include "elerium/subsys/crypto.h"
+
+//***************************************************************************//
+
+struct elerium_psbt_signature {
+    uint32_t input;
+    struct elerium_signature sign;
+};
+
+//***************************************************************************//
+
+int elerium_psbt_begin(void);
+
+int elerium_psbt_feed(const uint8_t* data, size_t len);
+
+int elerium_psbt_pop_signature(struct elerium_psbt_signature* signature);
+
+int elerium_psbt_finish(void);
+
+void elerium_psbt_abort(void);
+
+//***************************************************************************//
+
+#endif // ELERIUM_SUBSYS_PSBT_H_
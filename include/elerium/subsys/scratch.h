@@ -0,0 +1,33 @@
+#ifndef ELERIUM_SUBSYS_SCRATCH_H_
+#define ELERIUM_SUBSYS_SCRATCH_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+//***************************************************************************//
+
+#define ELERIUM_SCRATCH_SIZE CONFIG_BEECHAT_ELERIUM_SCRATCH_SIZE
+#define ELERIUM_SCRATCH_ALIGN 8
+
+/// @brief Arena bytes taken by an allocation, for compile-time worst-case asserts
+#define ELERIUM_SCRATCH_ROUND(size) ROUND_UP(size, ELERIUM_SCRATCH_ALIGN)
+
+//***************************************************************************//
+
+/// @brief Claims the arena for the calling thread, take it before any subsystem lock
+size_t elerium_scratch_begin(void);
+
+/// @brief Zeroed memory valid until the matching end, NULL when the arena is exhausted
+void* elerium_scratch_alloc(size_t size);
+
+/// @brief Zeroizes everything allocated since begin returned mark and releases the claim
+void elerium_scratch_end(size_t mark);
+
+/// @brief Highest arena use since boot
+size_t elerium_scratch_peak(void);
+
+//***************************************************************************//
+
+#endif // ELERIUM_SUBSYS_SCRATCH_H_
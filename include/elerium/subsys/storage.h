@@ -8,12 +8,53 @@
 
 //***************************************************************************//
 
+struct elerium_storage_stats {
+    uint32_t writes;
+    uint32_t max_write_us;
+    uint32_t idle_gc;
+    uint32_t foreground_gc;
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+};
+
+//***************************************************************************//
+
+/// @brief Called once through elerium_subsys_require
+int elerium_storage_init(void);
+
 int elerium_storage_load(uint16_t key, void* data, size_t len);
 
 int elerium_storage_save(uint16_t key, const void* data, size_t len);
 
 int elerium_storage_delete(uint16_t key);
 
+/// @brief Record prefixed with a layout version byte, so a new layout can migrate the old one
+int elerium_storage_save_record(uint16_t key, uint8_t version, const void* data, size_t len);
+
+/// @brief Returns the payload length and stores the layout version the record was saved with
+ssize_t elerium_storage_load_record(uint16_t key, uint8_t* version, void* data, size_t cap);
+
+/// @brief Monotonic value, kept in the counter partition when the board has one, 0 if never saved
+int elerium_storage_counter_load(uint16_t key, uint32_t* value);
+
+/// @brief Raises the value, programming one flash word instead of writing the record under key
+int elerium_storage_counter_save(uint16_t key, uint32_t value);
+
+/// @brief Opens a transaction, storage is held by the calling thread until commit or abort
+int elerium_storage_txn_begin(void);
+
+int elerium_storage_txn_put(uint16_t key, const void* data, size_t len);
+
+int elerium_storage_txn_delete(uint16_t key);
+
+/// @brief Applies every put and delete, or none of them if power is lost before the journal write
+int elerium_storage_txn_commit(void);
+
+void elerium_storage_txn_abort(void);
+
+/// @brief Write and cache counters, max_write_us is the slowest foreground write since boot
+int elerium_storage_stats(struct elerium_storage_stats* stats);
+
 //***************************************************************************//
 
 #endif // ELERIUM_SUBSYS_STORAGE_H_
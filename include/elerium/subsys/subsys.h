@@ -0,0 +1,51 @@
+
+#ifndef ELERIUM_SUBSYS_SUBSYS_H_
+#define ELERIUM_SUBSYS_SUBSYS_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+//***************************************************************************//
+
+enum elerium_subsys {
+    ELERIUM_SUBSYS_STORAGE,
+    ELERIUM_SUBSYS_NFC,
+    ELERIUM_SUBSYS_URL_SIGN,
+    ELERIUM_SUBSYS_WALLET,
+    ELERIUM_SUBSYS_COUNT,
+};
+
+enum elerium_subsys_state {
+    ELERIUM_SUBSYS_STATE_DISABLED,
+    ELERIUM_SUBSYS_STATE_PENDING,
+    ELERIUM_SUBSYS_STATE_RUNNING,
+    ELERIUM_SUBSYS_STATE_READY,
+    ELERIUM_SUBSYS_STATE_FAILED,
+};
+
+struct elerium_subsys_profile {
+    enum elerium_subsys_state state;
+    int rc;
+    uint32_t start_us;
+    uint32_t init_us;
+    // Key generation and save moved out of init onto the worker, 0 when nothing was generated
+    uint32_t provision_us;
+};
+
+//***************************************************************************//
+
+/// @brief Initialize a subsystem and its dependencies on first use, later calls return the result
+int elerium_subsys_require(enum elerium_subsys subsys);
+
+int elerium_subsys_profile(enum elerium_subsys subsys, struct elerium_subsys_profile* profile);
+
+/// @brief Uptime in microseconds when the eager subsystems finished initializing
+uint32_t elerium_subsys_boot_us(void);
+
+/// @brief Records the time background provisioning took, init would have taken it before NFC
+void elerium_subsys_provisioned(enum elerium_subsys subsys, uint32_t us);
+
+//***************************************************************************//
+
+#endif // ELERIUM_SUBSYS_SUBSYS_H_
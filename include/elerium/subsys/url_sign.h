@@ -10,6 +10,9 @@
 
 //***************************************************************************//
 
+/// @brief Called once through elerium_subsys_require
+int elerium_url_sign_init(void);
+
 int elerium_url_sign_get_pub(struct elerium_pub_key* pub_key);
 int elerium_url_sign_get_pub_raw(uint8_t* data, size_t cap);
 
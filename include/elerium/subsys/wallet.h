@@ -6,14 +6,25 @@
 
 #include <zephyr/kernel.h>
 
+#include "elerium/subsys/crypto.h"
+
 //***************************************************************************//
 
+#define ELERIUM_WALLET_BIP32_MAX_DEPTH 8
+#define ELERIUM_WALLET_BIP32_HARDENED BIT(31)
+#define ELERIUM_WALLET_FINGERPRINT_SIZE 4
+#define ELERIUM_WALLET_PUB_KEY_SIZE 33
+#define ELERIUM_WALLET_HASH160_SIZE 20
+
 //***************************************************************************//
 
 struct elerium_wallet;
 
 //***************************************************************************//
 
+/// @brief Called once through elerium_subsys_require
+int elerium_wallet_init(void);
+
 int elerium_wallet_create(const uint8_t* passcode, uint8_t* seed);
 
 int elerium_wallet_seed(const uint8_t* passcode, uint8_t* seed);
@@ -23,10 +34,37 @@ int elerium_wallet_destroy(void);
 struct elerium_wallet* elerium_wallet_get(const uint8_t* passcode);
 
 int elerium_wallet_sign(const struct elerium_wallet* wallet,
+                        enum elerium_crypto_curve curve,
                         const uint8_t* hash,
                         size_t hash_length,
                         uint8_t* signature);
 
+int elerium_wallet_sign_path(const struct elerium_wallet* wallet,
+                             const uint32_t* path,
+                             size_t depth,
+                             const uint8_t* hash,
+                             size_t hash_length,
+                             uint8_t* signature);
+
+int elerium_wallet_sign_path_taproot(const struct elerium_wallet* wallet,
+                                     const uint32_t* path,
+                                     size_t depth,
+                                     const uint8_t* hash,
+                                     size_t hash_length,
+                                     uint8_t* signature);
+
+/// @brief First bytes of the HASH160 of the BIP32 master public key
+int elerium_wallet_fingerprint(const struct elerium_wallet* wallet, uint8_t* fingerprint);
+
+/// @brief Compressed public key at the path and its HASH160, hash160 may be NULL
+int elerium_wallet_path_pub(const struct elerium_wallet* wallet,
+                            const uint32_t* path,
+                            size_t depth,
+                            uint8_t* pub_key,
+                            uint8_t* hash160);
+
+void elerium_wallet_cache_wipe(void);
+
 //***************************************************************************//
 
 #endif // ELERIUM_SUBSYS_WALLET_H_
@@ -0,0 +1,19 @@
+
+#ifndef ELERIUM_SUBSYS_WORKER_H_
+#define ELERIUM_SUBSYS_WORKER_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+//***************************************************************************//
+
+/// @brief Schedule slow background jobs below the NFC handling priority
+int elerium_worker_schedule(struct k_work_delayable* work, k_timeout_t delay);
+
+/// @brief Like elerium_worker_schedule, but restarts the delay of an already scheduled job
+int elerium_worker_reschedule(struct k_work_delayable* work, k_timeout_t delay);
+
+//***************************************************************************//
+
+#endif // ELERIUM_SUBSYS_WORKER_H_
@@ -0,0 +1,112 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include "elerium/subsys/clock.h"
+#include "elerium/subsys/energy.h"
+
+#include "clock_backend.h"
+
+//***************************************************************************//
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_CLOCK_BOOST)
+#define CLOCK_BOOST_MIN_MV CONFIG_BEECHAT_ELERIUM_CLOCK_BOOST_MV
+#else
+#define CLOCK_BOOST_MIN_MV 0
+#endif
+
+//***************************************************************************//
+
+static int clock_init(void);
+static int clock_switch(enum elerium_clock_level level);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(clock_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+// Module
+static struct {
+    struct k_mutex mut;
+    uint32_t depth;
+    bool boosted;
+    int64_t boost_start;
+    struct elerium_clock_stats stats;
+} mod;
+
+//***************************************************************************//
+
+// Overlapping bursts share one boost, a refused boost is not retried before the last burst ends
+void elerium_clock_boost_begin(void) {
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    if ((mod.depth++ == 0) && IS_ENABLED(CONFIG_BEECHAT_ELERIUM_CLOCK_BOOST)) {
+        const uint16_t mv = elerium_energy_supply_mv();
+
+        // The faster clock draws more current than a weak field can supply
+        if ((mv != 0) && (mv < CLOCK_BOOST_MIN_MV)) {
+            ++mod.stats.denied;
+        } else if (clock_switch(ELERIUM_CLOCK_LEVEL_BOOST) == 0) {
+            mod.boosted = true;
+            mod.boost_start = k_uptime_get();
+            ++mod.stats.boosts;
+        } else {
+            ++mod.stats.failed;
+        }
+    }
+
+    k_mutex_unlock(&mod.mut);
+}
+
+void elerium_clock_boost_end(void) {
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    __ASSERT_NO_MSG(mod.depth > 0);
+
+    if ((mod.depth > 0) && (--mod.depth == 0) && mod.boosted) {
+        if (clock_switch(ELERIUM_CLOCK_LEVEL_LOW) != 0) {
+            ++mod.stats.failed;
+        }
+
+        mod.boosted = false;
+        mod.stats.boost_ms += (uint32_t)(k_uptime_get() - mod.boost_start);
+    }
+
+    k_mutex_unlock(&mod.mut);
+}
+
+int elerium_clock_stats(struct elerium_clock_stats* stats) {
+
+    __ASSERT_NO_MSG(stats != NULL);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    (void)memcpy(stats, &mod.stats, sizeof(*stats));
+
+    k_mutex_unlock(&mod.mut);
+
+    return 0;
+}
+
+//***************************************************************************//
+
+// Without a backend the governor only tracks the burst depth
+int clock_switch(enum elerium_clock_level level) {
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_CLOCK_BOOST)
+    return clock_backend_set(level);
+#else
+    ARG_UNUSED(level);
+
+    return -ENOTSUP;
+#endif
+}
+
+int clock_init(void) {
+    k_mutex_init(&mod.mut);
+
+    return 0;
+}
+
+//***************************************************************************//
@@ -0,0 +1,19 @@
+#ifndef ELERIUM_LIB_SUBSYS_CLOCK_BACKEND_H_
+#define ELERIUM_LIB_SUBSYS_CLOCK_BACKEND_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+#include "elerium/subsys/clock.h"
+
+//***************************************************************************//
+
+/// @brief Implemented by the SoC clock tree, the policy in clock.c stays hardware independent
+
+/// @brief Switch the core clock, returns once the new clock runs and SystemCoreClock follows it
+int clock_backend_set(enum elerium_clock_level level);
+
+//***************************************************************************//
+
+#endif // ELERIUM_LIB_SUBSYS_CLOCK_BACKEND_H_
@@ -0,0 +1,110 @@
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <soc.h>
+#include <stm32_ll_rcc.h>
+#include <stm32_ll_utils.h>
+
+#include "clock_backend.h"
+
+//***************************************************************************//
+
+// MSI as set up from the devicetree is the low level, the boost level stays within the voltage
+// range the clock driver selected for it
+#define CLOCK_BOOST_HZ MHZ(16)
+
+#if defined(CONFIG_SOC_SERIES_STM32L4X)
+#define MSI_RANGE_BOOST LL_RCC_MSIRANGE_8
+#define msi_get_range() LL_RCC_MSI_GetRange()
+#define msi_set_range(range) LL_RCC_MSI_SetRange(range)
+#define msi_is_ready() LL_RCC_MSI_IsReady()
+#define sysclk_is_msi() (LL_RCC_GetSysClkSource() == LL_RCC_SYS_CLKSOURCE_STATUS_MSI)
+#elif defined(CONFIG_SOC_SERIES_STM32U5X)
+#define MSI_RANGE_BOOST LL_RCC_MSISRANGE_2
+#define msi_get_range() LL_RCC_MSIS_GetRange()
+#define msi_set_range(range) LL_RCC_MSIS_SetRange(range)
+#define msi_is_ready() LL_RCC_MSIS_IsReady()
+#define sysclk_is_msi() (LL_RCC_GetSysClkSource() == LL_RCC_SYS_CLKSOURCE_STATUS_MSIS)
+#else
+#error "Clock boost is not supported on this SoC series"
+#endif
+
+//***************************************************************************//
+
+static int clock_stm32_init(void);
+static void msi_switch(uint32_t range);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(clock_stm32_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+// Module
+static struct {
+    bool supported;
+    uint32_t low_range;
+    uint32_t low_hz;
+} mod;
+
+//***************************************************************************//
+
+// The kernel tick runs from LPTIM and I2C from its own kernel clock, so only the core, the
+// buses and SystemCoreClock follow the switch
+int clock_backend_set(enum elerium_clock_level level) {
+
+    if (!mod.supported) {
+        return -ENOTSUP;
+    }
+
+    if (level == ELERIUM_CLOCK_LEVEL_BOOST) {
+        // Wait states go up before the clock does
+        if (LL_SetFlashLatency(CLOCK_BOOST_HZ) != SUCCESS) {
+            return -EIO;
+        }
+
+        msi_switch(MSI_RANGE_BOOST);
+    } else {
+        msi_switch(mod.low_range);
+
+        (void)LL_SetFlashLatency(mod.low_hz);
+    }
+
+    return 0;
+}
+
+//***************************************************************************//
+
+// MSI may change range while it drives SYSCLK, it only has to be ready before and after
+void msi_switch(uint32_t range) {
+    const unsigned int key = irq_lock();
+
+    while (!msi_is_ready()) {
+    }
+
+    msi_set_range(range);
+
+    while (!msi_is_ready()) {
+    }
+
+    // Only for code that reads it after the switch, drivers that cached a bus rate at init keep it,
+    // which is why the timer and I2C run from kernel clocks that don't follow SYSCLK
+    SystemCoreClockUpdate();
+
+    irq_unlock(key);
+}
+
+int clock_stm32_init(void) {
+    mod.low_range = msi_get_range();
+    mod.low_hz = SystemCoreClock;
+
+    // A board already running fast or from another oscillator keeps its clock
+    mod.supported = sysclk_is_msi() && (mod.low_hz < CLOCK_BOOST_HZ);
+
+    LL_RCC_MSI_EnableRangeSelection();
+
+    return 0;
+}
+
+//***************************************************************************//
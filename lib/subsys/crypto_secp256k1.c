@@ -0,0 +1,462 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include <secp256k1.h>
+#include <secp256k1_extrakeys.h>
+#include <secp256k1_schnorrsig.h>
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+#include <wally_core.h>
+#endif
+
+#include "elerium/subsys/clock.h"
+#include "elerium/subsys/crypto.h"
+
+//***************************************************************************//
+
+#define CONTEXT_BUFFER_SIZE 256
+
+#define XONLY_KEY_SIZE 32
+
+// Distinct public keys kept parsed during one batch, co-signer sets repeat a handful of keys
+#define VERIFY_KEY_CACHE_SIZE 4
+
+//***************************************************************************//
+
+static int crypto_secp256k1_init(void);
+static int context_init(void);
+static int pubkey_parse(const struct elerium_pub_key* pub_key, secp256k1_pubkey* pubkey);
+static void taproot_tweak_hash(const uint8_t* internal_key, uint8_t* tweak);
+static int verify_parsed(const secp256k1_pubkey* pubkey,
+                         const void* hash,
+                         size_t hash_len,
+                         const struct elerium_signature* sign);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(crypto_secp256k1_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+// Static Data
+static const char taptweak_tag[] = "TapTweak";
+
+// Module
+static struct {
+    struct k_mutex mut;
+    bool ready;
+    secp256k1_context* ctx;
+    uint8_t ctx_buffer[CONTEXT_BUFFER_SIZE] __aligned(16);
+} mod;
+
+//***************************************************************************//
+
+// Called by libsecp256k1 on API misuse and internal failures
+void secp256k1_default_illegal_callback_fn(const char* str, void* data) {
+    ARG_UNUSED(data);
+
+    __ASSERT(false, "secp256k1: %s", str);
+    k_panic();
+}
+
+void secp256k1_default_error_callback_fn(const char* str, void* data) {
+    ARG_UNUSED(data);
+
+    __ASSERT(false, "secp256k1: %s", str);
+    k_panic();
+}
+
+//***************************************************************************//
+
+int elerium_crypto_secp256k1_generate(struct elerium_priv_key* priv_key) {
+
+    __ASSERT_NO_MSG(priv_key != NULL);
+
+    int rc;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = context_init();
+
+    // Redraw the rare values that are zero or not below the group order
+    while (rc == 0) {
+        rc = elerium_crypto_random_fill(priv_key->data, sizeof(priv_key->data));
+
+        if ((rc == 0) && secp256k1_ec_seckey_verify(mod.ctx, priv_key->data)) {
+            break;
+        }
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    if (rc != 0) {
+        (void)memset(priv_key, 0x00, sizeof(*priv_key));
+    }
+
+    return rc;
+}
+
+int elerium_crypto_secp256k1_get_pub(const struct elerium_priv_key* priv_key,
+                                     struct elerium_pub_key* pub_key) {
+
+    __ASSERT_NO_MSG(priv_key != NULL);
+    __ASSERT_NO_MSG(pub_key != NULL);
+
+    int rc;
+
+    secp256k1_pubkey pubkey;
+    uint8_t serialized[1 + sizeof(pub_key->data)];
+    size_t serialized_len = sizeof(serialized);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = context_init();
+
+    if (rc == 0) {
+        elerium_clock_boost_begin();
+        rc = secp256k1_ec_pubkey_create(mod.ctx, &pubkey, priv_key->data) ? 0 : -EINVAL;
+        elerium_clock_boost_end();
+    }
+
+    if (rc == 0) {
+        (void)secp256k1_ec_pubkey_serialize(
+            mod.ctx, serialized, &serialized_len, &pubkey, SECP256K1_EC_UNCOMPRESSED);
+
+        // Drop the 0x04 prefix to match the uECC raw X||Y layout
+        (void)memcpy(pub_key->data, &serialized[1], sizeof(pub_key->data));
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+int elerium_crypto_secp256k1_sign(const struct elerium_priv_key* priv_key,
+                                  const void* hash,
+                                  size_t hash_len,
+                                  struct elerium_signature* sign) {
+
+    __ASSERT_NO_MSG(priv_key != NULL);
+    __ASSERT_NO_MSG(hash != NULL);
+    __ASSERT_NO_MSG(sign != NULL);
+
+    int rc = 0;
+
+    secp256k1_ecdsa_signature sig;
+
+    if (hash_len != sizeof(struct elerium_hash)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = context_init();
+
+    if (rc == 0) {
+        // RFC 6979 nonce, output is already low-S normalized
+        elerium_clock_boost_begin();
+        rc = secp256k1_ecdsa_sign(mod.ctx, &sig, hash, priv_key->data, NULL, NULL) ? 0 : -EFAULT;
+        elerium_clock_boost_end();
+    }
+
+    if (rc == 0) {
+        (void)secp256k1_ecdsa_signature_serialize_compact(mod.ctx, sign->data, &sig);
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+// BIP340 signature by the BIP86 output key of priv_key, a key path spend of a P2TR output
+int elerium_crypto_secp256k1_sign_taproot(const struct elerium_priv_key* priv_key,
+                                          const void* hash,
+                                          size_t hash_len,
+                                          struct elerium_signature* sign) {
+
+    __ASSERT_NO_MSG(priv_key != NULL);
+    __ASSERT_NO_MSG(hash != NULL);
+    __ASSERT_NO_MSG(sign != NULL);
+
+    int rc;
+
+    secp256k1_keypair keypair;
+    secp256k1_xonly_pubkey xonly;
+    uint8_t internal_key[XONLY_KEY_SIZE];
+    uint8_t tweak[32];
+    uint8_t aux_rand[32];
+
+    if (hash_len != sizeof(struct elerium_hash)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = context_init();
+
+    if (rc == 0) {
+        rc = elerium_crypto_random_fill(aux_rand, sizeof(aux_rand));
+    }
+
+    if (rc == 0) {
+        elerium_clock_boost_begin();
+
+        rc = secp256k1_keypair_create(mod.ctx, &keypair, priv_key->data) ? 0 : -EINVAL;
+
+        if (rc == 0) {
+            (void)secp256k1_keypair_xonly_pub(mod.ctx, &xonly, NULL, &keypair);
+            (void)secp256k1_xonly_pubkey_serialize(mod.ctx, internal_key, &xonly);
+
+            taproot_tweak_hash(internal_key, tweak);
+
+            rc = secp256k1_keypair_xonly_tweak_add(mod.ctx, &keypair, tweak) ? 0 : -EINVAL;
+        }
+
+        if (rc == 0) {
+            rc = secp256k1_schnorrsig_sign32(mod.ctx, sign->data, hash, &keypair, aux_rand)
+                ? 0
+                : -EFAULT;
+        }
+
+        elerium_clock_boost_end();
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    (void)memset(&keypair, 0x00, sizeof(keypair));
+    (void)memset(aux_rand, 0x00, sizeof(aux_rand));
+
+    return rc;
+}
+
+// BIP86 output key of an x-only internal key, the witness program of its P2TR output
+int elerium_crypto_secp256k1_taproot_key(const uint8_t* internal_key, uint8_t* output_key) {
+
+    __ASSERT_NO_MSG(internal_key != NULL);
+    __ASSERT_NO_MSG(output_key != NULL);
+
+    int rc;
+
+    secp256k1_xonly_pubkey xonly;
+    secp256k1_pubkey tweaked;
+    uint8_t tweak[32];
+
+    if (!secp256k1_xonly_pubkey_parse(secp256k1_context_static, &xonly, internal_key)) {
+        return -EINVAL;
+    }
+
+    taproot_tweak_hash(internal_key, tweak);
+
+    elerium_clock_boost_begin();
+
+    rc = secp256k1_xonly_pubkey_tweak_add(secp256k1_context_static, &tweaked, &xonly, tweak)
+        ? 0
+        : -EINVAL;
+
+    elerium_clock_boost_end();
+
+    if (rc == 0) {
+        (void)secp256k1_xonly_pubkey_from_pubkey(secp256k1_context_static, &xonly, NULL, &tweaked);
+        (void)secp256k1_xonly_pubkey_serialize(secp256k1_context_static, output_key, &xonly);
+    }
+
+    return rc;
+}
+
+int elerium_crypto_secp256k1_verify(const struct elerium_pub_key* pub_key,
+                                    const void* hash,
+                                    size_t hash_len,
+                                    const struct elerium_signature* sign) {
+
+    __ASSERT_NO_MSG(pub_key != NULL);
+    __ASSERT_NO_MSG(hash != NULL);
+    __ASSERT_NO_MSG(sign != NULL);
+
+    int rc;
+
+    secp256k1_pubkey pubkey;
+
+    rc = pubkey_parse(pub_key, &pubkey);
+
+    if (rc == 0) {
+        elerium_clock_boost_begin();
+        rc = verify_parsed(&pubkey, hash, hash_len, sign);
+        elerium_clock_boost_end();
+    }
+
+    return rc;
+}
+
+int elerium_crypto_secp256k1_verify_batch(struct elerium_crypto_verify_item* items, size_t count) {
+    int rc = 0;
+
+    __ASSERT_NO_MSG((items != NULL) || (count == 0));
+
+    struct {
+        const struct elerium_pub_key* pub_key;
+        secp256k1_pubkey pubkey;
+        int rc;
+    } cache[VERIFY_KEY_CACHE_SIZE];
+
+    size_t cached = 0;
+
+    // One boost for the whole batch instead of a switch pair per item
+    elerium_clock_boost_begin();
+
+    for (size_t i = 0; i < count; ++i) {
+        struct elerium_crypto_verify_item* item = &items[i];
+
+        __ASSERT_NO_MSG(item->pub_key != NULL);
+        __ASSERT_NO_MSG(item->hash != NULL);
+        __ASSERT_NO_MSG(item->sign != NULL);
+
+        size_t slot = 0;
+
+        while ((slot < MIN(cached, VERIFY_KEY_CACHE_SIZE))
+               && (memcmp(cache[slot].pub_key, item->pub_key, sizeof(*item->pub_key)) != 0)) {
+            ++slot;
+        }
+
+        // Parse on a miss, the oldest key makes room
+        if (slot == MIN(cached, VERIFY_KEY_CACHE_SIZE)) {
+            slot = cached % VERIFY_KEY_CACHE_SIZE;
+            ++cached;
+
+            cache[slot].pub_key = item->pub_key;
+            cache[slot].rc = pubkey_parse(item->pub_key, &cache[slot].pubkey);
+        }
+
+        const secp256k1_pubkey* pubkey = &cache[slot].pubkey;
+
+        item->result = cache[slot].rc;
+
+        if (item->result == 0) {
+            item->result = verify_parsed(pubkey, item->hash, item->hash_len, item->sign);
+        }
+
+        if (item->result != 0) {
+            rc = -EFAULT;
+        }
+    }
+
+    elerium_clock_boost_end();
+
+    return rc;
+}
+
+//***************************************************************************//
+
+// No script tree, the key path is the only way to spend the output
+void taproot_tweak_hash(const uint8_t* internal_key, uint8_t* tweak) {
+    (void)secp256k1_tagged_sha256(secp256k1_context_static,
+                                  tweak,
+                                  (const uint8_t*)taptweak_tag,
+                                  sizeof(taptweak_tag) - 1,
+                                  internal_key,
+                                  XONLY_KEY_SIZE);
+}
+
+// Verification needs no generator tables, the static context is enough
+int pubkey_parse(const struct elerium_pub_key* pub_key, secp256k1_pubkey* pubkey) {
+    uint8_t serialized[1 + sizeof(pub_key->data)];
+
+    serialized[0] = 0x04;
+    (void)memcpy(&serialized[1], pub_key->data, sizeof(pub_key->data));
+
+    if (!secp256k1_ec_pubkey_parse(
+            secp256k1_context_static, pubkey, serialized, sizeof(serialized))) {
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+int verify_parsed(const secp256k1_pubkey* pubkey,
+                  const void* hash,
+                  size_t hash_len,
+                  const struct elerium_signature* sign) {
+
+    secp256k1_ecdsa_signature sig;
+
+    if (hash_len != sizeof(struct elerium_hash)) {
+        return -EINVAL;
+    }
+
+    if (!secp256k1_ecdsa_signature_parse_compact(secp256k1_context_static, &sig, sign->data)) {
+        return -EINVAL;
+    }
+
+    return secp256k1_ecdsa_verify(secp256k1_context_static, &sig, hash, pubkey) ? 0 : -EFAULT;
+}
+
+int context_init(void) {
+    int rc = 0;
+
+    uint8_t seed[32];
+
+    if (mod.ready) {
+        return 0;
+    }
+
+    // Generator tables are const and live in flash, only the blinding state is in RAM
+    if (secp256k1_context_preallocated_size(SECP256K1_CONTEXT_NONE) > sizeof(mod.ctx_buffer)) {
+        return -ENOMEM;
+    }
+
+    mod.ctx = secp256k1_context_preallocated_create(mod.ctx_buffer, SECP256K1_CONTEXT_NONE);
+    if (mod.ctx == NULL) {
+        return -EFAULT;
+    }
+
+    rc = elerium_crypto_random_fill(seed, sizeof(seed));
+
+    if (rc == 0) {
+        rc = secp256k1_context_randomize(mod.ctx, seed) ? 0 : -EFAULT;
+    }
+
+    (void)memset(seed, 0x00, sizeof(seed));
+
+    mod.ready = (rc == 0);
+
+    return rc;
+}
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+// Lets libwally-core share the static context instead of allocating its own
+static struct secp256k1_context_struct* wally_secp_context(void) {
+    int rc;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = context_init();
+
+    k_mutex_unlock(&mod.mut);
+
+    return (rc == 0) ? mod.ctx : NULL;
+}
+#endif
+
+int crypto_secp256k1_init(void) {
+    int rc = 0;
+
+    k_mutex_init(&mod.mut);
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    struct wally_operations ops = { .struct_size = sizeof(ops) };
+
+    rc = wally_get_operations(&ops);
+
+    if (rc == WALLY_OK) {
+        ops.secp_context_fn = &wally_secp_context;
+        rc = wally_set_operations(&ops);
+    }
+
+    rc = (rc == WALLY_OK) ? 0 : -EFAULT;
+#endif
+
+    return rc;
+}
+
+//***************************************************************************//
@@ -1,8 +1,11 @@
 
 //***************************************************************************//
 
+#include <string.h>
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/entropy.h>
 #include <zephyr/kernel.h>
-#include <zephyr/random/random.h>
 
 #include <tinycrypt/constants.h>
 #include <tinycrypt/ctr_prng.h>
@@ -12,28 +15,75 @@
 #include <tinycrypt/sha256.h>
 #include <tinycrypt/utils.h>
 
+#include "elerium/subsys/clock.h"
 #include "elerium/subsys/crypto.h"
+#include "elerium/subsys/energy.h"
+#include "elerium/subsys/worker.h"
+
+//***************************************************************************//
+
+// The public context mirrors the TinyCrypt state so it can live on caller stacks
+BUILD_ASSERT(sizeof(struct elerium_sha256_ctx) == sizeof(struct tc_sha256_state_struct));
+BUILD_ASSERT(offsetof(struct elerium_sha256_ctx, bits_hashed)
+             == offsetof(struct tc_sha256_state_struct, bits_hashed));
+BUILD_ASSERT(offsetof(struct elerium_sha256_ctx, leftover)
+             == offsetof(struct tc_sha256_state_struct, leftover));
+BUILD_ASSERT(offsetof(struct elerium_sha256_ctx, leftover_offset)
+             == offsetof(struct tc_sha256_state_struct, leftover_offset));
+
+#define to_tc_sha256(ctx) ((struct tc_sha256_state_struct*)(ctx))
+
+#define SHA256_BOOST_MIN_LEN TC_SHA256_BLOCK_SIZE
+
+#define DRBG_POOL_SIZE CONFIG_BEECHAT_ELERIUM_CRYPTO_DRBG_POOL_SIZE
+#define DRBG_RESEED_BYTES CONFIG_BEECHAT_ELERIUM_CRYPTO_DRBG_RESEED_BYTES
+#define DRBG_RESEED_INTERVAL_MS CONFIG_BEECHAT_ELERIUM_CRYPTO_DRBG_RESEED_INTERVAL_MS
+
+//***************************************************************************//
+
+static int crypto_init(void);
+static bool drbg_reseed_required(void);
+static int drbg_reseed(void);
+static int drbg_generate(uint8_t* out, size_t len);
+static int drbg_refill(void);
+static void drbg_refill_work(struct k_work* work);
 
 //***************************************************************************//
 
+// Kernel, seeded before anything at the default priority can draw
+SYS_INIT(crypto_init, POST_KERNEL, CONFIG_BEECHAT_ELERIUM_CRYPTO_INIT_PRIORITY);
+
+// Devices
+static const struct device* const entropy_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_entropy));
+
 static const char personalize[] = "beechat:elerium:crypto";
 
 // Module
-struct {
+static struct {
+    struct k_mutex mut;
     uint8_t entropy[TC_AES_KEY_SIZE + TC_AES_BLOCK_SIZE];
+    uint8_t last_entropy[TC_AES_KEY_SIZE + TC_AES_BLOCK_SIZE];
     TCCtrPrng_t prng;
+    bool seeded;
+    uint32_t reseed_time;
+    size_t pool_avail;
+    uint8_t pool[DRBG_POOL_SIZE];
+    struct k_work_delayable refill_work;
+    struct elerium_crypto_drbg_stats stats;
 } mod;
 
 //***************************************************************************//
 
 int default_CSPRNG(uint8_t* dest, unsigned int size) {
-    sys_rand_get(dest, size);
-    return TC_CRYPTO_SUCCESS;
+    const int rc = elerium_crypto_random_fill(dest, size);
+    return (rc == 0) ? TC_CRYPTO_SUCCESS : TC_CRYPTO_FAIL;
 }
 
 int elerium_crypto_generate(struct elerium_priv_key* priv_key, struct elerium_pub_key* pub_key) {
     uECC_set_rng(&default_CSPRNG);
+    elerium_clock_boost_begin();
     const int rc = uECC_make_key(pub_key->data, priv_key->data, uECC_secp256r1());
+    elerium_clock_boost_end();
     return (rc == TC_CRYPTO_SUCCESS) ? 0 : -EFAULT;
 }
 
@@ -46,8 +96,12 @@ int elerium_crypto_sign(struct elerium_priv_key* priv_key,
     __ASSERT_NO_MSG(hash != NULL);
     __ASSERT_NO_MSG(sign != NULL);
 
+    elerium_clock_boost_begin();
+
     const int rc = uECC_sign(priv_key->data, hash, hash_len, sign->data, uECC_secp256r1());
 
+    elerium_clock_boost_end();
+
     return (rc == TC_CRYPTO_SUCCESS) ? 0 : -EFAULT;
 }
 
@@ -60,57 +114,332 @@ int elerium_crypto_verify(struct elerium_pub_key* pub_key,
     __ASSERT_NO_MSG(hash != NULL);
     __ASSERT_NO_MSG(sign != NULL);
 
+    elerium_clock_boost_begin();
+
     const int rc = uECC_verify(pub_key->data, hash, hash_len, sign->data, uECC_secp256r1());
 
+    elerium_clock_boost_end();
+
     return (rc == TC_CRYPTO_SUCCESS) ? 0 : -EFAULT;
 }
 
 int elerium_crypto_sha256(const void* data, size_t data_len, struct elerium_hash* hash) {
+    int rc;
+
+    struct elerium_sha256_ctx ctx;
+
+    rc = elerium_crypto_sha256_init(&ctx);
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256_update(&ctx, data, data_len);
+    }
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256_final(&ctx, hash);
+    }
+
+    return rc;
+}
+
+int elerium_crypto_sha256_init(struct elerium_sha256_ctx* ctx) {
+
+    __ASSERT_NO_MSG(ctx != NULL);
+
+    const int rc = tc_sha256_init(to_tc_sha256(ctx));
+
+    return (rc == TC_CRYPTO_SUCCESS) ? 0 : -EINVAL;
+}
+
+int elerium_crypto_sha256_update(struct elerium_sha256_ctx* ctx,
+                                 const void* data,
+                                 size_t data_len) {
+
+    __ASSERT_NO_MSG(ctx != NULL);
+
+    if (data_len == 0) {
+        return 0;
+    }
+
+    // Switching costs less than hashing a block at the low clock
+    const bool boost = (data_len >= SHA256_BOOST_MIN_LEN);
+
+    if (boost) {
+        elerium_clock_boost_begin();
+    }
+
+    const int rc = tc_sha256_update(to_tc_sha256(ctx), data, data_len);
+
+    if (boost) {
+        elerium_clock_boost_end();
+    }
+
+    return (rc == TC_CRYPTO_SUCCESS) ? 0 : -EINVAL;
+}
+
+int elerium_crypto_sha256_final(struct elerium_sha256_ctx* ctx, struct elerium_hash* hash) {
+
+    __ASSERT_NO_MSG(ctx != NULL);
+    __ASSERT_NO_MSG(hash != NULL);
+
+    const int rc = tc_sha256_final(hash->data, to_tc_sha256(ctx));
+
+    return (rc == TC_CRYPTO_SUCCESS) ? 0 : -EINVAL;
+}
+
+void elerium_crypto_sha256_clone(struct elerium_sha256_ctx* dst,
+                                 const struct elerium_sha256_ctx* src) {
+
+    __ASSERT_NO_MSG(dst != NULL);
+    __ASSERT_NO_MSG(src != NULL);
+
+    (void)memcpy(dst, src, sizeof(*dst));
+}
+
+int elerium_crypto_sha256_export(const struct elerium_sha256_ctx* ctx,
+                                 struct elerium_sha256_midstate* midstate) {
+
+    __ASSERT_NO_MSG(ctx != NULL);
+    __ASSERT_NO_MSG(midstate != NULL);
+
+    if (ctx->leftover_offset >= sizeof(ctx->leftover)) {
+        return -EINVAL;
+    }
+
+    (void)memset(midstate, 0x00, sizeof(*midstate));
+    (void)memcpy(midstate->iv, ctx->iv, sizeof(midstate->iv));
+    midstate->bits_hashed = ctx->bits_hashed;
+    (void)memcpy(midstate->leftover, ctx->leftover, ctx->leftover_offset);
+    midstate->leftover_len = (uint8_t)ctx->leftover_offset;
+
+    return 0;
+}
+
+int elerium_crypto_sha256_import(struct elerium_sha256_ctx* ctx,
+                                 const struct elerium_sha256_midstate* midstate) {
+
+    __ASSERT_NO_MSG(ctx != NULL);
+    __ASSERT_NO_MSG(midstate != NULL);
+
+    if (midstate->leftover_len >= sizeof(midstate->leftover)) {
+        return -EINVAL;
+    }
+
+    (void)memset(ctx, 0x00, sizeof(*ctx));
+    (void)memcpy(ctx->iv, midstate->iv, sizeof(ctx->iv));
+    ctx->bits_hashed = midstate->bits_hashed;
+    (void)memcpy(ctx->leftover, midstate->leftover, midstate->leftover_len);
+    ctx->leftover_offset = midstate->leftover_len;
+
+    return 0;
+}
+
+int elerium_crypto_random(uint64_t* value) {
+
+    __ASSERT_NO_MSG(value != NULL);
+
+    return elerium_crypto_random_fill(value, sizeof(*value));
+}
+
+// Only copies on the signing path, reseeding and refilling the pool run on the workqueue
+int elerium_crypto_random_fill(void* data, size_t len) {
     int rc = 0;
 
-    struct tc_sha256_state_struct sha256_ctx = { 0 };
+    __ASSERT_NO_MSG(data != NULL);
+
+    uint8_t* out = data;
 
-    if (tc_sha256_init(&sha256_ctx) != TC_CRYPTO_SUCCESS) {
-        rc = -EINVAL;
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    // Nothing can be served before the first seed, later reseeds never block a caller
+    if (!mod.seeded) {
+        rc = drbg_reseed();
+    }
+
+    // Serve from the tail of the pool and wipe what was handed out
+    const size_t chunk = (rc == 0) ? MIN(len, mod.pool_avail) : 0;
+    mod.pool_avail -= chunk;
+
+    (void)memcpy(out, &mod.pool[mod.pool_avail], chunk);
+    (void)memset(&mod.pool[mod.pool_avail], 0x00, chunk);
+
+    // The pool ran dry, the rest comes straight from the DRBG
+    if ((rc == 0) && (len > chunk)) {
+        ++mod.stats.pool_misses;
+        rc = drbg_generate(&out[chunk], len - chunk);
+    }
+
+    const bool refill = (mod.pool_avail < (DRBG_POOL_SIZE / 2)) || drbg_reseed_required();
+
+    k_mutex_unlock(&mod.mut);
+
+    if (refill) {
+        (void)elerium_worker_schedule(&mod.refill_work, K_NO_WAIT);
+    }
+
+    return rc;
+}
+
+void elerium_crypto_random_stats(struct elerium_crypto_drbg_stats* stats) {
+
+    __ASSERT_NO_MSG(stats != NULL);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    (void)memcpy(stats, &mod.stats, sizeof(*stats));
+
+    k_mutex_unlock(&mod.mut);
+}
+
+//***************************************************************************//
+
+static int drbg_collect_entropy(void) {
+    int rc;
+
+    if (!device_is_ready(entropy_dev)) {
+        return -ENODEV;
+    }
+
+    rc = entropy_get_entropy(entropy_dev, mod.entropy, sizeof(mod.entropy));
+    if (rc != 0) {
+        return -EIO;
+    }
+
+    // Repetition test, a stuck source returns the same block twice
+    const bool repeated = (memcmp(mod.entropy, mod.last_entropy, sizeof(mod.entropy)) == 0);
+    (void)memcpy(mod.last_entropy, mod.entropy, sizeof(mod.entropy));
+
+    if (repeated) {
+        ++mod.stats.health_failures;
+        return -EIO;
     }
 
+    return 0;
+}
+
+bool drbg_reseed_required(void) {
+    if (!mod.seeded) {
+        return true;
+    }
+
+    if (mod.stats.bytes_since_reseed >= DRBG_RESEED_BYTES) {
+        return true;
+    }
+
+    return (k_uptime_get_32() - mod.reseed_time) >= DRBG_RESEED_INTERVAL_MS;
+}
+
+int drbg_reseed(void) {
+    int rc;
+
+    rc = drbg_collect_entropy();
+
     if (rc == 0) {
-        if (tc_sha256_update(&sha256_ctx, data, data_len) != TC_CRYPTO_SUCCESS) {
-            rc = -EINVAL;
+        if (mod.seeded) {
+            rc = tc_ctr_prng_reseed(&mod.prng, mod.entropy, sizeof(mod.entropy), NULL, 0);
+        } else {
+            rc = tc_ctr_prng_init(&mod.prng,
+                                  mod.entropy,
+                                  sizeof(mod.entropy),
+                                  (const uint8_t*)personalize,
+                                  sizeof(personalize));
         }
+
+        rc = (rc == TC_CRYPTO_SUCCESS) ? 0 : -EFAULT;
     }
 
+    (void)memset(mod.entropy, 0x00, sizeof(mod.entropy));
+
     if (rc == 0) {
-        if (tc_sha256_final(hash->data, &sha256_ctx) != TC_CRYPTO_SUCCESS) {
-            rc = -EINVAL;
-        }
+        mod.seeded = true;
+        mod.reseed_time = k_uptime_get_32();
+        mod.stats.bytes_since_reseed = 0;
+        ++mod.stats.reseeds;
+
+        // Drop output generated from the previous state
+        (void)memset(mod.pool, 0x00, sizeof(mod.pool));
+        mod.pool_avail = 0;
     }
 
     return rc;
 }
 
-uint64_t elerium_crypto_random(void) {
-    uint64_t result = 0;
+int drbg_generate(uint8_t* out, size_t len) {
+    int rc;
+
+    rc = tc_ctr_prng_generate(&mod.prng, NULL, 0, out, len);
+
+    // Only hit after 2^48 requests, there is no state left to serve from
+    if (rc == TC_CTR_PRNG_RESEED_REQ) {
+        rc = drbg_reseed();
 
-    sys_rand_get(&result, sizeof(result));
+        if (rc == 0) {
+            rc = tc_ctr_prng_generate(&mod.prng, NULL, 0, out, len);
+        }
+    }
 
-    return result;
+    if (rc != TC_CRYPTO_SUCCESS) {
+        return -EFAULT;
+    }
+
+    mod.stats.bytes_since_reseed += len;
+    mod.stats.bytes_generated += len;
+
+    return 0;
 }
 
-//***************************************************************************//
+// Unread bytes stay at the bottom of the pool, fresh output goes on top
+int drbg_refill(void) {
+    int rc = 0;
+
+    if (mod.pool_avail < DRBG_POOL_SIZE) {
+        rc = drbg_generate(&mod.pool[mod.pool_avail], DRBG_POOL_SIZE - mod.pool_avail);
+    }
+
+    if (rc == 0) {
+        mod.pool_avail = DRBG_POOL_SIZE;
+    }
+
+    return rc;
+}
+
+// A failed reseed keeps the current state, the pool keeps serving and the next request retries.
+// On a weak supply callers draw straight from the DRBG until the refill is admitted
+void drbg_refill_work(struct k_work* work) {
+    ARG_UNUSED(work);
+
+    if (elerium_energy_defer(&mod.refill_work, ELERIUM_ENERGY_COST_DRBG)) {
+        return;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    if (drbg_reseed_required()) {
+        (void)drbg_reseed();
+    }
+
+    (void)drbg_refill();
+
+    k_mutex_unlock(&mod.mut);
+}
 
 int crypto_init(void) {
     int rc;
 
-    sys_rand_get(mod.entropy, sizeof(mod.entropy));
+    k_mutex_init(&mod.mut);
+    k_work_init_delayable(&mod.refill_work, &drbg_refill_work);
 
-    rc = tc_ctr_prng_init(
-        &mod.prng, mod.entropy, sizeof(mod.entropy), personalize, sizeof(personalize));
+    uECC_set_rng(&default_CSPRNG);
 
-    if (rc == TC_CRYPTO_SUCCESS) {
-        rc = 0;
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = drbg_reseed();
+
+    if (rc == 0) {
+        rc = drbg_refill();
     }
 
+    k_mutex_unlock(&mod.mut);
+
     return rc;
 }
 
@@ -0,0 +1,194 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "elerium/subsys/energy.h"
+#include "elerium/subsys/worker.h"
+
+//***************************************************************************//
+
+#define ENERGY_SAMPLE_INTERVAL_MS CONFIG_BEECHAT_ELERIUM_ENERGY_SAMPLE_INTERVAL_MS
+#define ENERGY_DEFER_DELAY K_MSEC(CONFIG_BEECHAT_ELERIUM_ENERGY_DEFER_DELAY_MS)
+#define ENERGY_MAX_DEFERS CONFIG_BEECHAT_ELERIUM_ENERGY_MAX_DEFERS
+
+//***************************************************************************//
+
+static int energy_init(void);
+static uint16_t supply_mv(void);
+static uint16_t vbat_mv(void);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(energy_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_ENERGY)
+// Devices
+static const struct device* const vref_dev = DEVICE_DT_GET_OR_NULL(DT_ALIAS(vref));
+static const struct device* const vbat_dev = DEVICE_DT_GET_OR_NULL(DT_ALIAS(vbat));
+
+// Static Data
+static const uint16_t cost_min_mv[ELERIUM_ENERGY_COST_COUNT] = {
+    [ELERIUM_ENERGY_COST_FLASH] = CONFIG_BEECHAT_ELERIUM_ENERGY_FLASH_MV,
+    [ELERIUM_ENERGY_COST_SIGN] = CONFIG_BEECHAT_ELERIUM_ENERGY_SIGN_MV,
+    [ELERIUM_ENERGY_COST_KEYGEN] = CONFIG_BEECHAT_ELERIUM_ENERGY_KEYGEN_MV,
+    [ELERIUM_ENERGY_COST_DRBG] = CONFIG_BEECHAT_ELERIUM_ENERGY_DRBG_MV,
+};
+#endif
+
+// Module
+static struct {
+    struct k_mutex mut;
+    int64_t sample_time;
+    uint8_t defers[ELERIUM_ENERGY_COST_COUNT];
+    struct elerium_energy_stats stats;
+} mod;
+
+//***************************************************************************//
+
+uint16_t elerium_energy_supply_mv(void) {
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    const uint16_t mv = supply_mv();
+
+    k_mutex_unlock(&mod.mut);
+
+    return mv;
+}
+
+uint16_t elerium_energy_vbat_mv(void) {
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    const uint16_t mv = vbat_mv();
+
+    k_mutex_unlock(&mod.mut);
+
+    return mv;
+}
+
+int elerium_energy_admit(enum elerium_energy_cost cost) {
+    int rc = 0;
+
+    __ASSERT_NO_MSG(cost < ELERIUM_ENERGY_COST_COUNT);
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_ENERGY)
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    const uint16_t mv = supply_mv();
+
+    // An unknown supply admits everything; a job starved for too long runs anyway, since a
+    // brownout only repeats it on the next boot
+    if ((mv != 0) && (mv < cost_min_mv[cost])) {
+        if (mod.defers[cost] < ENERGY_MAX_DEFERS) {
+            ++mod.defers[cost];
+            ++mod.stats.deferred;
+            rc = -EAGAIN;
+        } else {
+            ++mod.stats.forced;
+        }
+    }
+
+    if (rc == 0) {
+        mod.defers[cost] = 0;
+        ++mod.stats.admitted;
+    }
+
+    k_mutex_unlock(&mod.mut);
+#endif
+
+    return rc;
+}
+
+bool elerium_energy_defer(struct k_work_delayable* work, enum elerium_energy_cost cost) {
+    if (elerium_energy_admit(cost) == 0) {
+        return false;
+    }
+
+    (void)elerium_worker_schedule(work, ENERGY_DEFER_DELAY);
+
+    return true;
+}
+
+int elerium_energy_stats(struct elerium_energy_stats* stats) {
+
+    __ASSERT_NO_MSG(stats != NULL);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    (void)memcpy(stats, &mod.stats, sizeof(*stats));
+
+    k_mutex_unlock(&mod.mut);
+
+    return 0;
+}
+
+//***************************************************************************//
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_ENERGY)
+
+static uint16_t sample_mv(const struct device* dev) {
+    struct sensor_value value;
+
+    if ((dev == NULL) || !device_is_ready(dev)) {
+        return 0;
+    }
+
+    if ((sensor_sample_fetch(dev) != 0)
+        || (sensor_channel_get(dev, SENSOR_CHAN_VOLTAGE, &value) != 0)) {
+        return 0;
+    }
+
+    return (uint16_t)CLAMP((value.val1 * 1000) + (value.val2 / 1000), 0, UINT16_MAX);
+}
+
+// Each sample is an ADC conversion, so jobs started back to back share one
+uint16_t supply_mv(void) {
+    const int64_t now = k_uptime_get();
+
+    if ((mod.stats.samples == 0) || ((now - mod.sample_time) >= ENERGY_SAMPLE_INTERVAL_MS)) {
+        mod.sample_time = now;
+        ++mod.stats.samples;
+
+        mod.stats.supply_mv = sample_mv(vref_dev);
+
+        const uint16_t mv = mod.stats.supply_mv;
+
+        if ((mv != 0) && ((mod.stats.min_supply_mv == 0) || (mv < mod.stats.min_supply_mv))) {
+            mod.stats.min_supply_mv = mv;
+        }
+    }
+
+    return mod.stats.supply_mv;
+}
+
+// The supply check only needs vref, the bridge stays off until diagnostics ask
+uint16_t vbat_mv(void) {
+    mod.stats.vbat_mv = sample_mv(vbat_dev);
+
+    return mod.stats.vbat_mv;
+}
+
+#else
+
+uint16_t supply_mv(void) {
+    return 0;
+}
+
+uint16_t vbat_mv(void) {
+    return 0;
+}
+
+#endif
+
+int energy_init(void) {
+    k_mutex_init(&mod.mut);
+
+    return 0;
+}
+
+//***************************************************************************//
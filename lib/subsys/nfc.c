@@ -11,6 +11,7 @@
 
 #include "elerium/subsys/crypto.h"
 #include "elerium/subsys/nfc.h"
+#include "elerium/subsys/power.h"
 
 //***************************************************************************//
 
@@ -18,26 +19,27 @@
 #define NFC_SRAM_END_ADDR (0x203E)
 #define NFC_SRAM_SIZE (256)
 #define NFC_MESSAGE_PAGE_COUNT (ELERIUM_NFC_MESSAGE_SIZE / NTAG5_MEMORY_BLOCK_SIZE)
+#define NFC_QUEUE_DEPTH 4
+#define NFC_SESSION_TIMEOUT K_MSEC(CONFIG_BEECHAT_ELERIUM_NFC_SESSION_IDLE_MS)
 
 //***************************************************************************//
 
-static int nfc_init(void);
 static void nfc_ed_callback(void);
+static void nfc_session_work(struct k_work* work);
+static void nfc_comm_work(struct k_work* work);
 static uint32_t nfc_crc32(uint32_t initial, const uint8_t* data, size_t length);
 static int nfc_control_switch(void);
 static int parse_message(struct elerium_nfc_message* message);
 
 //***************************************************************************//
 
-// Kernel
-SYS_INIT(nfc_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
-
 // Devices
 static const struct device* const ntag_dev = DEVICE_DT_GET(DT_ALIAS(ntag));
 
 // Static Data
 static const uint8_t magic_pattern[] = { 0xE1, 0xED };
-static uint8_t message_queue_buffer[sizeof(struct elerium_nfc_message) * 4] = { 0 };
+// Only event types are queued, a COMM payload waits in the single message slot
+static enum elerium_nfc_message_type message_queue_buffer[NFC_QUEUE_DEPTH] = { 0 };
 
 // NTAG Configuration
 static const struct ntag5_block_spec ntag_config_blocks[] = {
@@ -56,7 +58,7 @@ static const struct ntag5_block_spec ntag_config_blocks[] = {
     },
     {
         .addr = 0x1038,
-        // SYNCH_DATA_BLOCK
+        // SYNCH_DATA_BLOCK - Last SRAM block, pass-through hands over on its read
         .block = (struct ntag5_block) { .data = { 0x3F, 0x00, 0x00, 0x00 } },
     },
     {
@@ -80,18 +82,65 @@ static const struct ntag5_block_spec ntag_config_blocks[] = {
     },
 };
 
+BUILD_ASSERT(ELERIUM_NFC_NDEF_URL_MAX_LEN <= NTAG5_NDEF_URI_MAX_LEN);
+
+enum nfc_session_state {
+    NFC_SESSION_IDLE,
+    NFC_SESSION_ACTIVE,
+};
+
 // Module
 static struct {
     struct k_mutex mut;
     struct elerium_nfc_message message;
+    struct k_sem message_free;
     struct k_msgq queue;
-    uint32_t last_ed_time;
+    struct ntag5_ndef_writer ndef_writer;
+
+    // Field session, kept from the last STATUS read
+    enum nfc_session_state session;
+    uint8_t status;
+    bool ndef_read;
+    bool pass_through;
+    struct k_work_delayable session_work;
+
+    // A request that arrived while main still held the previous one
+    atomic_t comm_pending;
+    struct k_work comm_work;
 } mod;
 
 //***************************************************************************//
 
 int elerium_nfc_read_message(struct elerium_nfc_message* message, k_timeout_t timeout) {
-    return k_msgq_get(&mod.queue, message, timeout);
+    int rc;
+
+    rc = elerium_nfc_wait_message(&message->type, timeout);
+
+    if ((rc == 0) && (message->type == ELERIUM_NFC_MESSAGE_TYPE_COMM)) {
+        rc = elerium_nfc_take_message(message);
+    }
+
+    return rc;
+}
+
+int elerium_nfc_wait_message(enum elerium_nfc_message_type* type, k_timeout_t timeout) {
+    return k_msgq_get(&mod.queue, type, timeout);
+}
+
+int elerium_nfc_take_message(struct elerium_nfc_message* message) {
+
+    if (k_sem_count_get(&mod.message_free) != 0) {
+        return -ENOMSG;
+    }
+
+    (void)memcpy(message, &mod.message, sizeof(*message));
+    k_sem_give(&mod.message_free);
+
+    if (atomic_get(&mod.comm_pending)) {
+        (void)k_work_submit(&mod.comm_work);
+    }
+
+    return 0;
 }
 
 int elerium_nfc_write_message(uint8_t flags, const struct elerium_nfc_message* message) {
@@ -156,61 +205,174 @@ int elerium_nfc_set_ndef_url(const char* url, size_t url_len) {
 
     int rc;
 
+    rc = elerium_nfc_ndef_url_begin(url_len);
+
+    if (rc == 0) {
+        rc = elerium_nfc_ndef_url_append(url, url_len);
+
+        const int end_rc = elerium_nfc_ndef_url_end();
+        if (rc == 0) {
+            rc = end_rc;
+        }
+    }
+
+    return rc;
+}
+
+int elerium_nfc_ndef_url_begin(size_t url_len) {
+
+    int rc;
+
+    if (url_len > ELERIUM_NFC_NDEF_URL_MAX_LEN) {
+        return -EMSGSIZE;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    // PT_TRANSFER_DIR = 0, Data transfer direction is I2C to NFC
     rc = ntag5_write_session_reg(
         ntag_dev, NTAG5_SESSION_REG_CONFIG, NTAG5_SESSION_REG_BYTE_1, 0x01, 0x00);
 
     if (rc == 0) {
-        rc = ntag5_write_ndef_uri_record(ntag_dev, NTAG5_URI_PREFIX_4, url, url_len);
+        rc = ntag5_ndef_uri_begin(ntag_dev, &mod.ndef_writer, NTAG5_URI_PREFIX_4, url_len);
     }
 
+    if (rc != 0) {
+        (void)ntag5_write_session_reg(
+            ntag_dev, NTAG5_SESSION_REG_CONFIG, NTAG5_SESSION_REG_BYTE_1, 0x01, 0x01);
+
+        k_mutex_unlock(&mod.mut);
+    }
+
+    return rc;
+}
+
+int elerium_nfc_ndef_url_append(const char* data, size_t len) {
+    return ntag5_ndef_uri_append(ntag_dev, &mod.ndef_writer, (const uint8_t*)data, len);
+}
+
+int elerium_nfc_ndef_url_end(void) {
+
+    int rc;
+
+    rc = ntag5_ndef_uri_end(ntag_dev, &mod.ndef_writer);
+
+    // PT_TRANSFER_DIR = 1, Data transfer direction is NFC to I2C
     rc += ntag5_write_session_reg(
         ntag_dev, NTAG5_SESSION_REG_CONFIG, NTAG5_SESSION_REG_BYTE_1, 0x01, 0x01);
 
+    k_mutex_unlock(&mod.mut);
+
     return rc;
 }
 
 //***************************************************************************//
 
+// Events run on the system workqueue, none of them waits for main
+static void nfc_post(enum elerium_nfc_message_type type) {
+    (void)k_msgq_put(&mod.queue, &type, K_NO_WAIT);
+}
+
+// Taking the previous request resubmits a pending one, the flag is raised before the slot is
+// tried so a release in between is never missed
+void nfc_comm_work(struct k_work* work) {
+    ARG_UNUSED(work);
+
+    int rc;
+
+    atomic_set(&mod.comm_pending, 1);
+
+    if (k_sem_take(&mod.message_free, K_NO_WAIT) != 0) {
+        return;
+    }
+
+    atomic_set(&mod.comm_pending, 0);
+
+    rc = parse_message(&mod.message);
+
+    if (rc == 0) {
+        mod.message.type = ELERIUM_NFC_MESSAGE_TYPE_COMM;
+        rc = k_msgq_put(&mod.queue, &mod.message.type, K_NO_WAIT);
+    }
+
+    if (rc != 0) {
+        k_sem_give(&mod.message_free);
+        nfc_control_switch();
+    }
+}
+
+// Every event keeps the session open, it ends once events stop and the field is gone
 void nfc_ed_callback(void) {
+    int rc;
 
-    uint8_t ed_config = 0;
-    (void)ntag5_read_session_reg(
-        ntag_dev, NTAG5_SESSION_REG_ED_CONFIG, NTAG5_SESSION_REG_BYTE_0, &ed_config);
+    elerium_power_wake_event(ntag5_ed_cycle(ntag_dev));
 
-    ed_config = ed_config & 0x0F;
-    if (ed_config != 0x04) {
+    rc = ntag5_read_session_reg(
+        ntag_dev, NTAG5_SESSION_REG_STATUS, NTAG5_SESSION_REG_BYTE_0, &mod.status);
 
-        if ((k_uptime_get_32() - mod.last_ed_time) > 2000) {
+    // Stop modes stay allowed in a session, the MCU of a harvesting tag only runs in the field
+    if (mod.session == NFC_SESSION_IDLE) {
+        mod.session = NFC_SESSION_ACTIVE;
+        nfc_post(ELERIUM_NFC_MESSAGE_TYPE_SESSION_START);
+    }
 
-            mod.last_ed_time = k_uptime_get_32();
+    (void)k_work_reschedule(&mod.session_work, NFC_SESSION_TIMEOUT);
 
-            memset(&mod.message, 0x00, sizeof(mod.message));
-            mod.message.type = ELERIUM_NFC_MESSAGE_TYPE_NDEF;
+    if (rc != 0) {
+        return;
+    }
 
-            k_msgq_put(&mod.queue, &mod.message, K_MSEC(250));
-        }
+    if ((mod.status & NTAG5_STATUS_0_SRAM_DATA_READY) != 0) {
+        nfc_comm_work(&mod.comm_work);
+    }
 
+    // The synch block belongs to pass-through, so a read of the NDEF message has no status bit.
+    // Any other event is the reader on the record, as for a plain tap
+    if ((mod.status & (NTAG5_STATUS_0_SRAM_DATA_READY | NTAG5_STATUS_0_SYNCH_BLOCK_READ)) != 0) {
+        mod.pass_through = true;
     } else {
-        int rc;
+        mod.ndef_read = true;
+    }
+}
 
-        rc = parse_message(&mod.message);
+// Reads went quiet, so the reader is done with the record and the next one can be written
+void nfc_session_work(struct k_work* work) {
+    ARG_UNUSED(work);
 
-        if (rc == 0) {
-            mod.message.type = ELERIUM_NFC_MESSAGE_TYPE_COMM;
-            rc = k_msgq_put(&mod.queue, &mod.message, K_MSEC(1000));
-        }
+    int rc;
 
-        if (rc != 0) {
-            nfc_control_switch();
-        }
+    rc = ntag5_read_session_reg(
+        ntag_dev, NTAG5_SESSION_REG_STATUS, NTAG5_SESSION_REG_BYTE_0, &mod.status);
+
+    // A host exchange reads the record too, only a quiet period without one is a tap
+    if (mod.ndef_read && !mod.pass_through) {
+        nfc_post(ELERIUM_NFC_MESSAGE_TYPE_NDEF);
+    }
+
+    mod.ndef_read = false;
+    mod.pass_through = false;
+
+    // A reader left on the tag keeps its session, a failed read ends it so secrets get wiped
+    if ((rc == 0) && ((mod.status & NTAG5_STATUS_0_NFC_FIELD_OK) != 0)) {
+        (void)k_work_reschedule(&mod.session_work, NFC_SESSION_TIMEOUT);
+    } else {
+        mod.session = NFC_SESSION_IDLE;
+        atomic_set(&mod.comm_pending, 0);
+        nfc_post(ELERIUM_NFC_MESSAGE_TYPE_SESSION_END);
     }
 }
 
-int nfc_init(void) {
+int elerium_nfc_init(void) {
     int rc = -ENODEV;
 
     k_mutex_init(&mod.mut);
-    k_msgq_init(&mod.queue, message_queue_buffer, sizeof(struct elerium_nfc_message), 4);
+    k_sem_init(&mod.message_free, 1, 1);
+    k_work_init_delayable(&mod.session_work, &nfc_session_work);
+    k_work_init(&mod.comm_work, &nfc_comm_work);
+    k_msgq_init(&mod.queue,
+                (char*)message_queue_buffer,
+                sizeof(message_queue_buffer[0]),
+                ARRAY_SIZE(message_queue_buffer));
 
     if (device_is_ready(ntag_dev)) {
         ntag5_set_callback(ntag_dev, nfc_ed_callback);
@@ -0,0 +1,155 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/pm/pm.h>
+#include <zephyr/pm/policy.h>
+#include <zephyr/pm/state.h>
+#include <zephyr/sys/util.h>
+
+#include "elerium/subsys/power.h"
+
+//***************************************************************************//
+
+#define POWER_WAKE_BUDGET_US CONFIG_BEECHAT_ELERIUM_POWER_WAKE_BUDGET_US
+
+//***************************************************************************//
+
+static int power_init(void);
+
+#if IS_ENABLED(CONFIG_PM)
+static void power_state_entry(enum pm_state state);
+static void power_state_exit(enum pm_state state);
+#endif
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(power_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+// Module
+// The notifier runs in the idle thread with interrupts locked, readers lock interrupts too
+static struct {
+    bool stopped;
+    bool wake_pending;
+    size_t mode;
+    uint32_t entry_cycle;
+    uint32_t wake_cycle;
+    uint32_t exit_latency_us;
+    uint64_t residency_us[ELERIUM_POWER_STOP_MODES];
+    struct elerium_power_stats stats;
+#if IS_ENABLED(CONFIG_PM)
+    struct pm_notifier notifier;
+    struct pm_policy_latency_request latency;
+#endif
+} mod;
+
+//***************************************************************************//
+
+void elerium_power_stop_lock_get(void) {
+#if IS_ENABLED(CONFIG_PM)
+    pm_policy_state_lock_get(PM_STATE_SUSPEND_TO_IDLE, PM_ALL_SUBSTATES);
+#endif
+}
+
+void elerium_power_stop_lock_put(void) {
+#if IS_ENABLED(CONFIG_PM)
+    pm_policy_state_lock_put(PM_STATE_SUSPEND_TO_IDLE, PM_ALL_SUBSTATES);
+#endif
+}
+
+// A timer wake-up that is still busy when the tag event arrives is counted too. The cycle
+// counter runs from LPTIM, so the figure has LSI resolution
+void elerium_power_wake_event(uint32_t irq_cycle) {
+    const unsigned int key = irq_lock();
+
+    if (mod.wake_pending) {
+        const uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - irq_cycle);
+
+        mod.wake_pending = false;
+
+        ++mod.stats.wakes;
+        mod.stats.wake_us_last = us;
+        mod.stats.wake_us_max = MAX(mod.stats.wake_us_max, us);
+
+        // The policy already keeps the exit latency within the budget, the handler gets the rest
+        if ((mod.exit_latency_us + us) > POWER_WAKE_BUDGET_US) {
+            ++mod.stats.over_budget;
+        }
+    }
+
+    irq_unlock(key);
+}
+
+int elerium_power_stats(struct elerium_power_stats* stats) {
+
+    __ASSERT_NO_MSG(stats != NULL);
+
+    const unsigned int key = irq_lock();
+
+    (void)memcpy(stats, &mod.stats, sizeof(*stats));
+
+    for (size_t i = 0; i < ELERIUM_POWER_STOP_MODES; ++i) {
+        stats->stop[i].residency_ms = (uint32_t)(mod.residency_us[i] / USEC_PER_MSEC);
+    }
+
+    irq_unlock(key);
+
+    return 0;
+}
+
+//***************************************************************************//
+
+#if IS_ENABLED(CONFIG_PM)
+
+void power_state_entry(enum pm_state state) {
+    const struct pm_state_info* info = pm_state_next_get(0);
+
+    mod.stopped = (state == PM_STATE_SUSPEND_TO_IDLE) && (info != NULL);
+    mod.wake_pending = false;
+
+    if (mod.stopped) {
+        mod.mode = CLAMP(info->substate_id, 1, ELERIUM_POWER_STOP_MODES) - 1;
+        mod.exit_latency_us = info->exit_latency_us;
+        mod.entry_cycle = k_cycle_get_32();
+    }
+}
+
+// Runs once clocks are restored, the kernel tick keeps counting through stop modes
+void power_state_exit(enum pm_state state) {
+    ARG_UNUSED(state);
+
+    if (!mod.stopped) {
+        return;
+    }
+
+    const uint32_t now = k_cycle_get_32();
+
+    ++mod.stats.stop[mod.mode].entries;
+    mod.residency_us[mod.mode] += k_cyc_to_us_floor32(now - mod.entry_cycle);
+
+    mod.stopped = false;
+    mod.wake_pending = true;
+    mod.wake_cycle = now;
+}
+
+#endif
+
+int power_init(void) {
+    mod.stats.wake_budget_us = POWER_WAKE_BUDGET_US;
+
+#if IS_ENABLED(CONFIG_PM)
+    mod.notifier.state_entry = power_state_entry;
+    mod.notifier.state_exit = power_state_exit;
+
+    pm_notifier_register(&mod.notifier);
+
+    // The policy skips stop modes that take longer than the budget to exit
+    pm_policy_latency_request_add(&mod.latency, POWER_WAKE_BUDGET_US);
+#endif
+
+    return 0;
+}
+
+//***************************************************************************//
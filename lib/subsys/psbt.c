@@ -0,0 +1,1009 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "elerium/subsys/crypto.h"
+#include "elerium/subsys/psbt.h"
+#include "elerium/subsys/wallet.h"
+
+//***************************************************************************//
+
+#define PSBT_MAX_INPUTS CONFIG_BEECHAT_ELERIUM_WALLET_PSBT_MAX_INPUTS
+#define PSBT_QUEUE_SIZE 8
+
+#define PSBT_GLOBAL_UNSIGNED_TX 0x00
+#define PSBT_IN_WITNESS_UTXO 0x01
+#define PSBT_IN_SIGHASH_TYPE 0x03
+#define PSBT_IN_BIP32_DERIVATION 0x06
+#define PSBT_IN_TAP_BIP32_DERIVATION 0x16
+
+#define SIGHASH_DEFAULT 0x00
+#define SIGHASH_ALL 0x01
+
+#define OUTPOINT_SIZE 36
+#define SEQUENCE_SIZE 4
+#define AMOUNT_SIZE 8
+#define P2WPKH_PROGRAM_SIZE 20
+#define P2TR_PROGRAM_SIZE 32
+#define XONLY_KEY_SIZE 32
+
+#define OP_0 0x00
+#define OP_1 0x51
+
+// amount + script length + version + push + program
+#define WITNESS_UTXO_SIZE(program) (AMOUNT_SIZE + 1 + 2 + (program))
+// fingerprint + path
+#define DERIVATION_MAX_SIZE                                                                      \
+    (ELERIUM_WALLET_FINGERPRINT_SIZE + (ELERIUM_WALLET_BIP32_MAX_DEPTH * sizeof(uint32_t)))
+// no leaf hashes + fingerprint + path, only key path spends are signed
+#define TAP_DERIVATION_MAX_SIZE (1 + DERIVATION_MAX_SIZE)
+
+#define FIELD_SIZE MAX(WITNESS_UTXO_SIZE(P2TR_PROGRAM_SIZE), TAP_DERIVATION_MAX_SIZE)
+// key type + compressed public key
+#define KEY_SIZE (1 + ELERIUM_WALLET_PUB_KEY_SIZE)
+
+// epoch + hash type + version + locktime + 5 hashes + spend type + input index
+#define TAP_SIGHASH_SIZE (1 + 1 + 4 + 4 + (5 * 32) + 1 + 4)
+
+//***************************************************************************//
+
+enum psbt_state {
+    PSBT_STATE_MAGIC,
+    PSBT_STATE_KEY_LEN,
+    PSBT_STATE_KEY,
+    PSBT_STATE_VALUE_LEN,
+    PSBT_STATE_VALUE,
+    PSBT_STATE_DONE,
+};
+
+enum psbt_map {
+    PSBT_MAP_GLOBAL,
+    PSBT_MAP_INPUT,
+    PSBT_MAP_OUTPUT,
+};
+
+enum tx_state {
+    TX_STATE_VERSION,
+    TX_STATE_VIN_COUNT,
+    TX_STATE_VIN_OUTPOINT,
+    TX_STATE_VIN_SCRIPT_LEN,
+    TX_STATE_VIN_SCRIPT,
+    TX_STATE_VIN_SEQUENCE,
+    TX_STATE_VOUT_COUNT,
+    TX_STATE_VOUT_AMOUNT,
+    TX_STATE_VOUT_SCRIPT_LEN,
+    TX_STATE_VOUT_SCRIPT,
+    TX_STATE_LOCKTIME,
+    TX_STATE_DONE,
+};
+
+enum psbt_script {
+    PSBT_SCRIPT_OTHER,
+    PSBT_SCRIPT_P2WPKH,
+    PSBT_SCRIPT_P2TR,
+};
+
+struct varint {
+    uint8_t need;
+    uint8_t have;
+    uint64_t value;
+};
+
+struct psbt_input {
+    uint8_t outpoint[OUTPOINT_SIZE];
+    uint8_t sequence[SEQUENCE_SIZE];
+};
+
+// Signing data collected from the current input map
+struct psbt_input_map {
+    bool has_utxo;
+    bool has_sighash;
+    // Script of the spent output, and the script the matched derivation pays to
+    enum psbt_script script;
+    enum psbt_script path_script;
+    uint8_t amount[AMOUNT_SIZE];
+    uint8_t program[P2TR_PROGRAM_SIZE];
+    uint8_t path_program[P2TR_PROGRAM_SIZE];
+    uint32_t sighash_type;
+    uint32_t path[ELERIUM_WALLET_BIP32_MAX_DEPTH];
+    size_t depth;
+};
+
+// Taproot input waiting for the amounts and scripts of every input
+struct psbt_taproot {
+    uint8_t input;
+    uint8_t sighash_type;
+    uint8_t depth;
+    uint32_t path[ELERIUM_WALLET_BIP32_MAX_DEPTH];
+};
+
+//***************************************************************************//
+
+static int psbt_init(void);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(psbt_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+// Static Data
+static const uint8_t magic_pattern[] = { 'p', 's', 'b', 't', 0xFF };
+static const char tap_sighash_tag[] = "TapSighash";
+
+// Module
+static struct psbt_module {
+    struct k_mutex mut;
+    bool active;
+
+    // Key-value map layer
+    enum psbt_state state;
+    enum psbt_map map;
+    size_t map_index;
+    size_t pos;
+    struct varint varint;
+    uint64_t remaining;
+    uint64_t value_len;
+    uint8_t key[KEY_SIZE];
+    size_t key_len;
+    uint8_t field[FIELD_SIZE];
+    size_t field_len;
+    uint8_t fingerprint[ELERIUM_WALLET_FINGERPRINT_SIZE];
+    struct psbt_input_map input_map;
+
+    // Unsigned transaction layer
+    enum tx_state tx_state;
+    size_t tx_pos;
+    size_t tx_index;
+    uint64_t tx_remaining;
+    struct varint tx_varint;
+    size_t vin_count;
+    size_t vout_count;
+    uint8_t version[4];
+    uint8_t locktime[4];
+    struct psbt_input inputs[PSBT_MAX_INPUTS];
+    struct elerium_sha256_ctx prevouts_ctx;
+    struct elerium_sha256_ctx sequence_ctx;
+    struct elerium_sha256_ctx outputs_ctx;
+    // Single SHA-256 for BIP341, hashed again for BIP143
+    struct elerium_hash sha_prevouts;
+    struct elerium_hash sha_sequence;
+    struct elerium_hash sha_outputs;
+    struct elerium_hash hash_prevouts;
+    struct elerium_hash hash_sequence;
+    struct elerium_hash hash_outputs;
+
+    // Spent outputs of every input, BIP341 commits to all of them
+    struct elerium_sha256_ctx amounts_ctx;
+    struct elerium_sha256_ctx scripts_ctx;
+    size_t utxo_count;
+    struct psbt_taproot taproot[PSBT_QUEUE_SIZE];
+    size_t taproot_count;
+
+    // Signatures waiting to be collected
+    struct elerium_psbt_signature queue[PSBT_QUEUE_SIZE];
+    size_t queue_head;
+    size_t queue_count;
+} mod;
+
+//***************************************************************************//
+
+static void reset(void) {
+    // Everything after the mutex is per-session state
+    const size_t start = offsetof(struct psbt_module, active);
+
+    (void)memset((uint8_t*)&mod + start, 0x00, sizeof(mod) - start);
+}
+
+static bool varint_feed(struct varint* varint, uint8_t byte) {
+
+    if (varint->need == 0) {
+        varint->have = 0;
+        varint->value = 0;
+
+        switch (byte) {
+            case 0xFD:
+                varint->need = 2;
+                return false;
+            case 0xFE:
+                varint->need = 4;
+                return false;
+            case 0xFF:
+                varint->need = 8;
+                return false;
+            default:
+                varint->value = byte;
+                return true;
+        }
+    }
+
+    varint->value |= (uint64_t)byte << (8 * varint->have++);
+
+    if (varint->have == varint->need) {
+        varint->need = 0;
+        return true;
+    }
+
+    return false;
+}
+
+static int double_sha256_final(struct elerium_sha256_ctx* ctx,
+                               struct elerium_hash* first,
+                               struct elerium_hash* hash) {
+    int rc;
+
+    rc = elerium_crypto_sha256_final(ctx, first);
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256(first->data, sizeof(first->data), hash);
+    }
+
+    return rc;
+}
+
+// BIP340 tagged hash, SHA-256(SHA-256(tag) || SHA-256(tag) || data)
+static int tagged_hash(const char* tag, const void* data, size_t len, struct elerium_hash* hash) {
+    int rc;
+
+    struct elerium_sha256_ctx ctx;
+    struct elerium_hash tag_hash;
+
+    rc = elerium_crypto_sha256(tag, strlen(tag), &tag_hash);
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256_init(&ctx);
+    }
+
+    for (size_t i = 0; (rc == 0) && (i < 2); ++i) {
+        rc = elerium_crypto_sha256_update(&ctx, tag_hash.data, sizeof(tag_hash.data));
+    }
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256_update(&ctx, data, len);
+    }
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256_final(&ctx, hash);
+    }
+
+    return rc;
+}
+
+//***************************************************************************//
+
+static int tx_next_output(void) {
+    int rc = 0;
+
+    ++mod.tx_index;
+
+    if (mod.tx_index < mod.vout_count) {
+        mod.tx_state = TX_STATE_VOUT_AMOUNT;
+    } else {
+        mod.tx_state = TX_STATE_LOCKTIME;
+        rc = double_sha256_final(&mod.outputs_ctx, &mod.sha_outputs, &mod.hash_outputs);
+    }
+
+    return rc;
+}
+
+static int tx_byte(uint8_t byte) {
+    int rc = 0;
+
+    switch (mod.tx_state) {
+        case TX_STATE_VERSION:
+            mod.version[mod.tx_pos++] = byte;
+            if (mod.tx_pos == sizeof(mod.version)) {
+                mod.tx_pos = 0;
+                mod.tx_state = TX_STATE_VIN_COUNT;
+            }
+            break;
+
+        case TX_STATE_VIN_COUNT:
+            if (varint_feed(&mod.tx_varint, byte)) {
+                // Zero would be a segwit marker, PSBT carries the legacy serialization
+                if (mod.tx_varint.value == 0) {
+                    rc = -EINVAL;
+                } else if (mod.tx_varint.value > PSBT_MAX_INPUTS) {
+                    rc = -E2BIG;
+                } else {
+                    mod.vin_count = mod.tx_varint.value;
+                    mod.tx_index = 0;
+                    mod.tx_state = TX_STATE_VIN_OUTPOINT;
+                }
+            }
+            break;
+
+        case TX_STATE_VIN_OUTPOINT:
+            mod.inputs[mod.tx_index].outpoint[mod.tx_pos++] = byte;
+            rc = elerium_crypto_sha256_update(&mod.prevouts_ctx, &byte, 1);
+            if (mod.tx_pos == OUTPOINT_SIZE) {
+                mod.tx_pos = 0;
+                mod.tx_state = TX_STATE_VIN_SCRIPT_LEN;
+            }
+            break;
+
+        case TX_STATE_VIN_SCRIPT_LEN:
+            if (varint_feed(&mod.tx_varint, byte)) {
+                mod.tx_remaining = mod.tx_varint.value;
+                mod.tx_state = (mod.tx_remaining > 0) ? TX_STATE_VIN_SCRIPT : TX_STATE_VIN_SEQUENCE;
+            }
+            break;
+
+        case TX_STATE_VIN_SCRIPT:
+            if (--mod.tx_remaining == 0) {
+                mod.tx_state = TX_STATE_VIN_SEQUENCE;
+            }
+            break;
+
+        case TX_STATE_VIN_SEQUENCE:
+            mod.inputs[mod.tx_index].sequence[mod.tx_pos++] = byte;
+            rc = elerium_crypto_sha256_update(&mod.sequence_ctx, &byte, 1);
+            if (mod.tx_pos == SEQUENCE_SIZE) {
+                mod.tx_pos = 0;
+                ++mod.tx_index;
+                mod.tx_state = (mod.tx_index < mod.vin_count) ? TX_STATE_VIN_OUTPOINT
+                                                              : TX_STATE_VOUT_COUNT;
+            }
+            break;
+
+        case TX_STATE_VOUT_COUNT:
+            if (varint_feed(&mod.tx_varint, byte)) {
+                rc = double_sha256_final(&mod.prevouts_ctx, &mod.sha_prevouts, &mod.hash_prevouts);
+
+                if (rc == 0) {
+                    rc = double_sha256_final(
+                        &mod.sequence_ctx, &mod.sha_sequence, &mod.hash_sequence);
+                }
+
+                mod.vout_count = mod.tx_varint.value;
+                mod.tx_index = 0;
+
+                if (rc != 0) {
+                    break;
+                }
+
+                if (mod.vout_count > 0) {
+                    mod.tx_state = TX_STATE_VOUT_AMOUNT;
+                } else {
+                    mod.tx_state = TX_STATE_LOCKTIME;
+                    rc = double_sha256_final(
+                        &mod.outputs_ctx, &mod.sha_outputs, &mod.hash_outputs);
+                }
+            }
+            break;
+
+        case TX_STATE_VOUT_AMOUNT:
+            rc = elerium_crypto_sha256_update(&mod.outputs_ctx, &byte, 1);
+            if (++mod.tx_pos == AMOUNT_SIZE) {
+                mod.tx_pos = 0;
+                mod.tx_state = TX_STATE_VOUT_SCRIPT_LEN;
+            }
+            break;
+
+        case TX_STATE_VOUT_SCRIPT_LEN:
+            rc = elerium_crypto_sha256_update(&mod.outputs_ctx, &byte, 1);
+            if ((rc == 0) && varint_feed(&mod.tx_varint, byte)) {
+                mod.tx_remaining = mod.tx_varint.value;
+                if (mod.tx_remaining > 0) {
+                    mod.tx_state = TX_STATE_VOUT_SCRIPT;
+                } else {
+                    rc = tx_next_output();
+                }
+            }
+            break;
+
+        case TX_STATE_VOUT_SCRIPT:
+            rc = elerium_crypto_sha256_update(&mod.outputs_ctx, &byte, 1);
+            if ((rc == 0) && (--mod.tx_remaining == 0)) {
+                rc = tx_next_output();
+            }
+            break;
+
+        case TX_STATE_LOCKTIME:
+            mod.locktime[mod.tx_pos++] = byte;
+            if (mod.tx_pos == sizeof(mod.locktime)) {
+                mod.tx_pos = 0;
+                mod.tx_state = TX_STATE_DONE;
+            }
+            break;
+
+        case TX_STATE_DONE:
+        default:
+            rc = -EINVAL;
+            break;
+    }
+
+    return rc;
+}
+
+//***************************************************************************//
+
+static int sign_input(size_t index) {
+    int rc;
+
+    const struct psbt_input_map* map = &mod.input_map;
+    const struct psbt_input* input = &mod.inputs[index];
+
+    struct elerium_sha256_ctx ctx;
+    struct elerium_hash first;
+    struct elerium_hash sighash;
+
+    // P2WPKH script code: OP_DUP OP_HASH160 <program> OP_EQUALVERIFY OP_CHECKSIG
+    uint8_t script_code[4 + P2WPKH_PROGRAM_SIZE + 2] = { 0x19, 0x76, 0xA9, 0x14 };
+    (void)memcpy(&script_code[4], map->program, P2WPKH_PROGRAM_SIZE);
+    script_code[4 + P2WPKH_PROGRAM_SIZE] = 0x88;
+    script_code[4 + P2WPKH_PROGRAM_SIZE + 1] = 0xAC;
+
+    uint8_t sighash_type[4];
+    sys_put_le32(map->has_sighash ? map->sighash_type : SIGHASH_ALL, sighash_type);
+
+    if (map->has_sighash && (map->sighash_type != SIGHASH_ALL)) {
+        return -ENOTSUP;
+    }
+
+    if (mod.queue_count == ARRAY_SIZE(mod.queue)) {
+        return -ENOBUFS;
+    }
+
+    // BIP143 preimage
+    rc = elerium_crypto_sha256_init(&ctx);
+
+    const struct {
+        const void* data;
+        size_t len;
+    } parts[] = {
+        { mod.version, sizeof(mod.version) },
+        { mod.hash_prevouts.data, sizeof(mod.hash_prevouts.data) },
+        { mod.hash_sequence.data, sizeof(mod.hash_sequence.data) },
+        { input->outpoint, sizeof(input->outpoint) },
+        { script_code, sizeof(script_code) },
+        { map->amount, sizeof(map->amount) },
+        { input->sequence, sizeof(input->sequence) },
+        { mod.hash_outputs.data, sizeof(mod.hash_outputs.data) },
+        { mod.locktime, sizeof(mod.locktime) },
+        { sighash_type, sizeof(sighash_type) },
+    };
+
+    for (size_t i = 0; (rc == 0) && (i < ARRAY_SIZE(parts)); ++i) {
+        rc = elerium_crypto_sha256_update(&ctx, parts[i].data, parts[i].len);
+    }
+
+    if (rc == 0) {
+        rc = double_sha256_final(&ctx, &first, &sighash);
+    }
+
+    if (rc == 0) {
+        const size_t slot = (mod.queue_head + mod.queue_count) % ARRAY_SIZE(mod.queue);
+        struct elerium_psbt_signature* out = &mod.queue[slot];
+
+        out->input = index;
+        rc = elerium_wallet_sign_path(elerium_wallet_get(NULL),
+                                      map->path,
+                                      map->depth,
+                                      sighash.data,
+                                      sizeof(sighash.data),
+                                      out->sign.data);
+
+        if (rc == 0) {
+            ++mod.queue_count;
+        }
+    }
+
+    return rc;
+}
+
+// Keeps the path, the sighash needs the spent outputs of the input maps still to come
+static int defer_taproot(size_t index) {
+    const struct psbt_input_map* map = &mod.input_map;
+
+    const uint32_t sighash_type = map->has_sighash ? map->sighash_type : SIGHASH_DEFAULT;
+
+    if ((sighash_type != SIGHASH_DEFAULT) && (sighash_type != SIGHASH_ALL)) {
+        return -ENOTSUP;
+    }
+
+    if (mod.taproot_count == ARRAY_SIZE(mod.taproot)) {
+        return -ENOBUFS;
+    }
+
+    struct psbt_taproot* taproot = &mod.taproot[mod.taproot_count++];
+
+    taproot->input = index;
+    taproot->sighash_type = sighash_type;
+    taproot->depth = map->depth;
+    (void)memcpy(taproot->path, map->path, map->depth * sizeof(map->path[0]));
+
+    return 0;
+}
+
+// BIP341 key path sighash, no annex
+static int sign_taproot(const struct psbt_taproot* taproot,
+                        const struct elerium_hash* sha_amounts,
+                        const struct elerium_hash* sha_scripts) {
+    int rc;
+
+    struct elerium_hash sighash;
+
+    uint8_t msg[TAP_SIGHASH_SIZE];
+    size_t len = 0;
+
+    if (mod.queue_count == ARRAY_SIZE(mod.queue)) {
+        return -ENOBUFS;
+    }
+
+    // Epoch
+    msg[len++] = 0x00;
+    msg[len++] = taproot->sighash_type;
+
+    const struct {
+        const void* data;
+        size_t len;
+    } parts[] = {
+        { mod.version, sizeof(mod.version) },
+        { mod.locktime, sizeof(mod.locktime) },
+        { mod.sha_prevouts.data, sizeof(mod.sha_prevouts.data) },
+        { sha_amounts->data, sizeof(sha_amounts->data) },
+        { sha_scripts->data, sizeof(sha_scripts->data) },
+        { mod.sha_sequence.data, sizeof(mod.sha_sequence.data) },
+        { mod.sha_outputs.data, sizeof(mod.sha_outputs.data) },
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(parts); ++i) {
+        (void)memcpy(&msg[len], parts[i].data, parts[i].len);
+        len += parts[i].len;
+    }
+
+    // Spend type, key path without annex
+    msg[len++] = 0x00;
+    sys_put_le32(taproot->input, &msg[len]);
+    len += sizeof(uint32_t);
+
+    rc = tagged_hash(tap_sighash_tag, msg, len, &sighash);
+
+    if (rc == 0) {
+        const size_t slot = (mod.queue_head + mod.queue_count) % ARRAY_SIZE(mod.queue);
+        struct elerium_psbt_signature* out = &mod.queue[slot];
+
+        out->input = taproot->input;
+        rc = elerium_wallet_sign_path_taproot(elerium_wallet_get(NULL),
+                                              taproot->path,
+                                              taproot->depth,
+                                              sighash.data,
+                                              sizeof(sighash.data),
+                                              out->sign.data);
+
+        if (rc == 0) {
+            ++mod.queue_count;
+        }
+    }
+
+    return rc;
+}
+
+static int sign_taproot_inputs(void) {
+    int rc;
+
+    struct elerium_hash sha_amounts;
+    struct elerium_hash sha_scripts;
+
+    if (mod.taproot_count == 0) {
+        return 0;
+    }
+
+    // Without every spent output the sighash cannot be computed
+    if (mod.utxo_count != mod.vin_count) {
+        return -EINVAL;
+    }
+
+    rc = elerium_crypto_sha256_final(&mod.amounts_ctx, &sha_amounts);
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256_final(&mod.scripts_ctx, &sha_scripts);
+    }
+
+    for (size_t i = 0; (rc == 0) && (i < mod.taproot_count); ++i) {
+        rc = sign_taproot(&mod.taproot[i], &sha_amounts, &sha_scripts);
+    }
+
+    (void)memset(mod.taproot, 0x00, sizeof(mod.taproot));
+    mod.taproot_count = 0;
+
+    return rc;
+}
+
+// Streams the spent output into the BIP341 hashes, the field only keeps what fits
+static int utxo_byte(uint8_t byte) {
+    const bool amount = (mod.value_len - mod.remaining) < AMOUNT_SIZE;
+
+    struct elerium_sha256_ctx* ctx = amount ? &mod.amounts_ctx : &mod.scripts_ctx;
+
+    return elerium_crypto_sha256_update(ctx, &byte, 1);
+}
+
+static enum psbt_script utxo_script(void) {
+    const uint8_t* script = &mod.field[AMOUNT_SIZE];
+
+    if ((mod.value_len == WITNESS_UTXO_SIZE(P2WPKH_PROGRAM_SIZE))
+        && (script[0] == 2 + P2WPKH_PROGRAM_SIZE) && (script[1] == OP_0)
+        && (script[2] == P2WPKH_PROGRAM_SIZE)) {
+        return PSBT_SCRIPT_P2WPKH;
+    }
+
+    if ((mod.value_len == WITNESS_UTXO_SIZE(P2TR_PROGRAM_SIZE))
+        && (script[0] == 2 + P2TR_PROGRAM_SIZE) && (script[1] == OP_1)
+        && (script[2] == P2TR_PROGRAM_SIZE)) {
+        return PSBT_SCRIPT_P2TR;
+    }
+
+    return PSBT_SCRIPT_OTHER;
+}
+
+// Reads a derivation of this wallet, false for other signers and paths too deep to sign
+static bool derivation_read(const uint8_t* value, size_t len) {
+    struct psbt_input_map* map = &mod.input_map;
+
+    if ((len < ELERIUM_WALLET_FINGERPRINT_SIZE) || (len > DERIVATION_MAX_SIZE)
+        || ((len % sizeof(uint32_t)) != 0)) {
+        return false;
+    }
+
+    if (memcmp(value, mod.fingerprint, sizeof(mod.fingerprint)) != 0) {
+        return false;
+    }
+
+    map->depth = (len - ELERIUM_WALLET_FINGERPRINT_SIZE) / sizeof(uint32_t);
+
+    for (size_t i = 0; i < map->depth; ++i) {
+        map->path[i] =
+            sys_get_le32(&value[ELERIUM_WALLET_FINGERPRINT_SIZE + (i * sizeof(uint32_t))]);
+    }
+
+    return true;
+}
+
+// Takes the first derivation whose key the wallet derives, the key must match the path
+static int derivation_end(void) {
+    int rc;
+
+    struct psbt_input_map* map = &mod.input_map;
+
+    uint8_t pub_key[ELERIUM_WALLET_PUB_KEY_SIZE];
+    uint8_t hash160[ELERIUM_WALLET_HASH160_SIZE];
+
+    const bool taproot = (mod.key[0] == PSBT_IN_TAP_BIP32_DERIVATION);
+    const size_t key_size = taproot ? XONLY_KEY_SIZE : ELERIUM_WALLET_PUB_KEY_SIZE;
+
+    const uint8_t* value = mod.field;
+    size_t len = mod.value_len;
+
+    if ((map->path_script != PSBT_SCRIPT_OTHER) || (mod.key_len != (1 + key_size))
+        || (len > sizeof(mod.field))) {
+        return 0;
+    }
+
+    // Leaf hashes list the scripts the key signs for, only the key path is signed
+    if (taproot) {
+        if ((len == 0) || (value[0] != 0)) {
+            return 0;
+        }
+
+        ++value;
+        --len;
+    }
+
+    if (!derivation_read(value, len)) {
+        return 0;
+    }
+
+    rc = elerium_wallet_path_pub(elerium_wallet_get(NULL), map->path, map->depth, pub_key, hash160);
+    if (rc != 0) {
+        return rc;
+    }
+
+    // A taproot key is the x coordinate alone
+    const uint8_t* derived = taproot ? &pub_key[1] : pub_key;
+
+    if (memcmp(derived, &mod.key[1], key_size) != 0) {
+        return 0;
+    }
+
+    if (taproot) {
+        rc = elerium_crypto_secp256k1_taproot_key(&mod.key[1], map->path_program);
+        map->path_script = PSBT_SCRIPT_P2TR;
+    } else {
+        (void)memcpy(map->path_program, hash160, sizeof(hash160));
+        map->path_script = PSBT_SCRIPT_P2WPKH;
+    }
+
+    return rc;
+}
+
+static int value_end(void) {
+    int rc = 0;
+
+    struct psbt_input_map* map = &mod.input_map;
+
+    if (mod.map == PSBT_MAP_GLOBAL) {
+        if ((mod.key[0] == PSBT_GLOBAL_UNSIGNED_TX) && (mod.tx_state != TX_STATE_DONE)) {
+            rc = -EINVAL;
+        }
+    } else if (mod.map == PSBT_MAP_INPUT) {
+        switch (mod.key[0]) {
+            case PSBT_IN_WITNESS_UTXO:
+                // A second spent output would have been hashed twice
+                if (map->has_utxo || (mod.value_len < AMOUNT_SIZE)) {
+                    rc = -EINVAL;
+                    break;
+                }
+
+                map->has_utxo = true;
+                ++mod.utxo_count;
+
+                // Only native P2WPKH and P2TR outputs are signed
+                map->script = utxo_script();
+
+                if (map->script != PSBT_SCRIPT_OTHER) {
+                    (void)memcpy(map->amount, mod.field, sizeof(map->amount));
+                    (void)memcpy(map->program,
+                                 &mod.field[AMOUNT_SIZE + 3],
+                                 mod.value_len - (AMOUNT_SIZE + 3));
+                }
+                break;
+
+            case PSBT_IN_SIGHASH_TYPE:
+                if (mod.value_len == sizeof(uint32_t)) {
+                    map->sighash_type = sys_get_le32(mod.field);
+                    map->has_sighash = true;
+                } else {
+                    rc = -EINVAL;
+                }
+                break;
+
+            case PSBT_IN_BIP32_DERIVATION:
+            case PSBT_IN_TAP_BIP32_DERIVATION:
+                rc = derivation_end();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return rc;
+}
+
+static int map_end(void) {
+    int rc = 0;
+
+    switch (mod.map) {
+        case PSBT_MAP_GLOBAL:
+            if (mod.tx_state != TX_STATE_DONE) {
+                rc = -EINVAL;
+                break;
+            }
+
+            mod.map = PSBT_MAP_INPUT;
+            mod.map_index = 0;
+            break;
+
+        case PSBT_MAP_INPUT: {
+            const struct psbt_input_map* map = &mod.input_map;
+
+            // Signed only when the derivation pays to the very output being spent
+            const bool ours = (map->script != PSBT_SCRIPT_OTHER)
+                && (map->path_script == map->script)
+                && (memcmp(map->program, map->path_program, sizeof(map->program)) == 0);
+
+            if (ours && (map->script == PSBT_SCRIPT_P2TR)) {
+                rc = defer_taproot(mod.map_index);
+            } else if (ours) {
+                rc = sign_input(mod.map_index);
+            }
+
+            (void)memset(&mod.input_map, 0x00, sizeof(mod.input_map));
+
+            if ((rc == 0) && (++mod.map_index == mod.vin_count)) {
+                rc = sign_taproot_inputs();
+                mod.map = PSBT_MAP_OUTPUT;
+                mod.map_index = 0;
+            }
+        } break;
+
+        case PSBT_MAP_OUTPUT:
+            ++mod.map_index;
+            break;
+    }
+
+    if ((mod.map == PSBT_MAP_OUTPUT) && (mod.map_index == mod.vout_count)) {
+        mod.state = PSBT_STATE_DONE;
+    }
+
+    return rc;
+}
+
+static int psbt_byte(uint8_t byte) {
+    int rc = 0;
+
+    switch (mod.state) {
+        case PSBT_STATE_MAGIC:
+            if (byte != magic_pattern[mod.pos++]) {
+                rc = -EINVAL;
+            } else if (mod.pos == sizeof(magic_pattern)) {
+                mod.state = PSBT_STATE_KEY_LEN;
+            }
+            break;
+
+        case PSBT_STATE_KEY_LEN:
+            if (varint_feed(&mod.varint, byte)) {
+                if (mod.varint.value == 0) {
+                    rc = map_end();
+                } else {
+                    mod.remaining = mod.varint.value;
+                    mod.key_len = mod.varint.value;
+                    mod.pos = 0;
+                    mod.state = PSBT_STATE_KEY;
+                }
+            }
+            break;
+
+        case PSBT_STATE_KEY:
+            if (mod.pos < sizeof(mod.key)) {
+                mod.key[mod.pos] = byte;
+            }
+            ++mod.pos;
+            if (--mod.remaining == 0) {
+                mod.state = PSBT_STATE_VALUE_LEN;
+            }
+            break;
+
+        case PSBT_STATE_VALUE_LEN:
+            if (varint_feed(&mod.varint, byte)) {
+                mod.remaining = mod.varint.value;
+                mod.value_len = mod.varint.value;
+                mod.field_len = 0;
+
+                if (mod.remaining > 0) {
+                    mod.state = PSBT_STATE_VALUE;
+                } else {
+                    rc = value_end();
+                    mod.state = PSBT_STATE_KEY_LEN;
+                }
+            }
+            break;
+
+        case PSBT_STATE_VALUE:
+            if ((mod.map == PSBT_MAP_GLOBAL) && (mod.key[0] == PSBT_GLOBAL_UNSIGNED_TX)) {
+                rc = tx_byte(byte);
+            } else if (mod.field_len < sizeof(mod.field)) {
+                mod.field[mod.field_len++] = byte;
+            }
+
+            if ((mod.map == PSBT_MAP_INPUT) && (mod.key[0] == PSBT_IN_WITNESS_UTXO)) {
+                rc = utxo_byte(byte);
+            }
+
+            if ((rc == 0) && (--mod.remaining == 0)) {
+                rc = value_end();
+                mod.state = PSBT_STATE_KEY_LEN;
+            }
+            break;
+
+        case PSBT_STATE_DONE:
+        default:
+            rc = -EINVAL;
+            break;
+    }
+
+    return rc;
+}
+
+//***************************************************************************//
+
+int elerium_psbt_begin(void) {
+    int rc;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    reset();
+
+    // Derivations of other signers are skipped without deriving anything
+    rc = elerium_wallet_fingerprint(elerium_wallet_get(NULL), mod.fingerprint);
+
+    struct elerium_sha256_ctx* const ctxs[] = {
+        &mod.prevouts_ctx, &mod.sequence_ctx, &mod.outputs_ctx,
+        &mod.amounts_ctx,  &mod.scripts_ctx,
+    };
+
+    for (size_t i = 0; (rc == 0) && (i < ARRAY_SIZE(ctxs)); ++i) {
+        rc = elerium_crypto_sha256_init(ctxs[i]);
+    }
+
+    mod.active = (rc == 0);
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+int elerium_psbt_feed(const uint8_t* data, size_t len) {
+    int rc = 0;
+
+    __ASSERT_NO_MSG((data != NULL) || (len == 0));
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    if (!mod.active) {
+        rc = -EAGAIN;
+    }
+
+    for (size_t i = 0; (rc == 0) && (i < len); ++i) {
+        rc = psbt_byte(data[i]);
+    }
+
+    // A malformed stream cannot be resumed
+    if (rc != 0) {
+        mod.active = false;
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+int elerium_psbt_pop_signature(struct elerium_psbt_signature* signature) {
+    int rc = -ENOENT;
+
+    __ASSERT_NO_MSG(signature != NULL);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    if (mod.queue_count > 0) {
+        struct elerium_psbt_signature* head = &mod.queue[mod.queue_head];
+
+        (void)memcpy(signature, head, sizeof(*signature));
+        (void)memset(head, 0x00, sizeof(*head));
+
+        mod.queue_head = (mod.queue_head + 1) % ARRAY_SIZE(mod.queue);
+        --mod.queue_count;
+
+        rc = 0;
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+int elerium_psbt_finish(void) {
+    int rc;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = (mod.active && (mod.state == PSBT_STATE_DONE)) ? 0 : -EINVAL;
+
+    mod.active = false;
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+void elerium_psbt_abort(void) {
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    reset();
+
+    k_mutex_unlock(&mod.mut);
+}
+
+//***************************************************************************//
+
+int psbt_init(void) {
+    k_mutex_init(&mod.mut);
+
+    return 0;
+}
+
+//***************************************************************************//
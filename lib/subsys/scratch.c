@@ -0,0 +1,75 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include "elerium/subsys/scratch.h"
+
+//***************************************************************************//
+
+static int scratch_init(void);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(scratch_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+// Module
+static struct {
+    struct k_mutex mut;
+    size_t offset;
+    size_t peak;
+    uint8_t buffer[ELERIUM_SCRATCH_SIZE] __aligned(ELERIUM_SCRATCH_ALIGN);
+} mod;
+
+//***************************************************************************//
+
+// The mutex is recursive, so a nested begin on the same thread allocates after the outer one
+size_t elerium_scratch_begin(void) {
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    return mod.offset;
+}
+
+void* elerium_scratch_alloc(size_t size) {
+    void* data = NULL;
+
+    const size_t round = ELERIUM_SCRATCH_ROUND(size);
+
+    __ASSERT(round <= (sizeof(mod.buffer) - mod.offset), "scratch arena exhausted");
+
+    if (round <= (sizeof(mod.buffer) - mod.offset)) {
+        data = &mod.buffer[mod.offset];
+        mod.offset += round;
+        mod.peak = MAX(mod.peak, mod.offset);
+    }
+
+    return data;
+}
+
+void elerium_scratch_end(size_t mark) {
+
+    __ASSERT_NO_MSG(mark <= mod.offset);
+
+    // Requests carry seeds and signatures, nothing is left behind for the next one
+    (void)memset(&mod.buffer[mark], 0x00, mod.offset - mark);
+    mod.offset = mark;
+
+    k_mutex_unlock(&mod.mut);
+}
+
+size_t elerium_scratch_peak(void) {
+    return mod.peak;
+}
+
+//***************************************************************************//
+
+int scratch_init(void) {
+    k_mutex_init(&mod.mut);
+
+    return 0;
+}
+
+//***************************************************************************//
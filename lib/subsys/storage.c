@@ -3,94 +3,645 @@
 
 #include <string.h>
 
-#include <zephyr/drivers/flash.h>
-#include <zephyr/fs/nvs.h>
 #include <zephyr/kernel.h>
 #include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
 
+#include "elerium/subsys/energy.h"
+#include "elerium/subsys/power.h"
+#include "elerium/subsys/scratch.h"
 #include "elerium/subsys/storage.h"
+#include "elerium/subsys/worker.h"
+
+#include "storage_backend.h"
 
 //***************************************************************************//
 
-#define NVS_PARTITION storage_partition
-#define NVS_PARTITION_DEVICE FIXED_PARTITION_DEVICE(NVS_PARTITION)
-#define NVS_PARTITION_OFFSET FIXED_PARTITION_OFFSET(NVS_PARTITION)
+#define STORAGE_PARTITION storage_partition
+#define STORAGE_PARTITION_DEVICE FIXED_PARTITION_DEVICE(STORAGE_PARTITION)
+#define STORAGE_PARTITION_OFFSET FIXED_PARTITION_OFFSET(STORAGE_PARTITION)
+#define STORAGE_PARTITION_SIZE FIXED_PARTITION_SIZE(STORAGE_PARTITION)
 
-//***************************************************************************//
+#define GC_THRESHOLD CONFIG_BEECHAT_ELERIUM_STORAGE_GC_THRESHOLD
+#define GC_DELAY K_MSEC(CONFIG_BEECHAT_ELERIUM_STORAGE_GC_DELAY_MS)
+
+#define RECORD_HEADER_SIZE 1
+#define RECORD_SIZE CONFIG_BEECHAT_ELERIUM_STORAGE_RECORD_SIZE
+
+// The journal holds a whole transaction, its single write is the commit marker
+#define JOURNAL_ID 0xFFFE
+#define JOURNAL_SIZE CONFIG_BEECHAT_ELERIUM_STORAGE_TXN_SIZE
+#define JOURNAL_ENTRY_HEADER_SIZE 4
 
-static int storage_init(void);
+// The commit point is the journal write, it fits in the room housekeeping keeps free
+BUILD_ASSERT((JOURNAL_SIZE + STORAGE_BACKEND_WRITE_OVERHEAD) <= GC_THRESHOLD);
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_STORAGE_CACHE)
+#define CACHE_ENTRIES CONFIG_BEECHAT_ELERIUM_STORAGE_CACHE_ENTRIES
+#define CACHE_ENTRY_SIZE CONFIG_BEECHAT_ELERIUM_STORAGE_CACHE_ENTRY_SIZE
+#endif
 
 //***************************************************************************//
 
-// Kernel
-SYS_INIT(storage_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_STORAGE_CACHE)
+struct cache_entry {
+    bool valid;
+    uint16_t key;
+    uint16_t len;
+    uint32_t used;
+    uint8_t data[CACHE_ENTRY_SIZE];
+};
+#endif
+
+//***************************************************************************//
 
 // Module
 static struct {
     struct k_mutex mut;
-    struct nvs_fs fs;
+    struct k_work_delayable gc_work;
+    struct elerium_storage_stats stats;
+
+    // Open transaction, the mutex and the arena stay held by its thread until commit or abort
+    bool txn_open;
+    bool journal_pending;
+    int txn_rc;
+    size_t txn_mark;
+    size_t txn_len;
+    uint8_t* txn;
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_STORAGE_CACHE)
+    // Least recently used entry is replaced, records larger than an entry bypass the cache
+    uint32_t cache_tick;
+    struct cache_entry cache[CACHE_ENTRIES];
+#endif
 } mod;
 
 //***************************************************************************//
 
+static int journal_apply(const uint8_t* journal, size_t len);
+static int journal_replay(uint8_t* journal);
+static void journal_reserve(void);
+
+static ssize_t cache_read(uint16_t key, void* data, size_t len);
+static void cache_store(uint16_t key, const void* data, size_t len);
+static void cache_drop(uint16_t key);
+
+//***************************************************************************//
+
+// Records and journals are staged in the scratch arena, the static RAM is only used while a write
+// or a transaction is in progress
+BUILD_ASSERT(ELERIUM_SCRATCH_ROUND(RECORD_HEADER_SIZE + RECORD_SIZE) <= ELERIUM_SCRATCH_SIZE);
+BUILD_ASSERT(ELERIUM_SCRATCH_ROUND(JOURNAL_SIZE) <= ELERIUM_SCRATCH_SIZE);
+
+//***************************************************************************//
+
+// Same contract as the backend read, the stored length is returned even when it exceeds len
+static ssize_t storage_read(uint16_t key, void* data, size_t len) {
+    ssize_t size;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    size = cache_read(key, data, len);
+
+    if (size == -ENOENT) {
+        ++mod.stats.cache_misses;
+
+        size = storage_backend_read(key, data, len);
+
+        if ((size > 0) && (size <= len)) {
+            cache_store(key, data, size);
+        }
+    } else {
+        ++mod.stats.cache_hits;
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return size;
+}
+
 int elerium_storage_load(uint16_t key, void* data, size_t len) {
 
     __ASSERT_NO_MSG(data != NULL);
     __ASSERT_NO_MSG(len > 0);
 
-    const ssize_t size = nvs_read(&mod.fs, key, data, len);
+    const ssize_t size = storage_read(key, data, len);
     int rc = 0;
 
     if (size < 0) {
         rc = -ENOENT;
-    }
-
-    if (size != len) {
+    } else if (size != len) {
         rc = -E2BIG;
     }
 
     return rc;
 }
 
+// Foreground writes are timed, and a sector change during one is counted as a foreground GC
+static ssize_t storage_write(uint16_t key, const void* data, size_t len) {
+    ssize_t size;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    // A flash operation is never left half done in a stop mode
+    elerium_power_stop_lock_get();
+
+    const ssize_t free = storage_backend_sector_free();
+    const uint32_t start = k_cycle_get_32();
+
+    size = (len > 0) ? storage_backend_write(key, data, len) : storage_backend_delete(key);
+
+    const uint32_t elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    ++mod.stats.writes;
+    mod.stats.max_write_us = MAX(mod.stats.max_write_us, elapsed_us);
+
+    // Write-through, a failed write leaves the flash content unknown so the entry is dropped
+    if ((size >= 0) && (len > 0) && (key != JOURNAL_ID)) {
+        cache_store(key, data, len);
+    } else {
+        cache_drop(key);
+    }
+
+    if (storage_backend_sector_free() > free) {
+        ++mod.stats.foreground_gc;
+    }
+
+    elerium_power_stop_lock_put();
+
+    k_mutex_unlock(&mod.mut);
+
+    // Housekeeping waits for a quiet period so it never runs between two writes of a command
+    (void)elerium_worker_reschedule(&mod.gc_work, GC_DELAY);
+
+    return size;
+}
+
 int elerium_storage_save(uint16_t key, const void* data, size_t len) {
 
     __ASSERT_NO_MSG(data != NULL);
     __ASSERT_NO_MSG(len > 0);
+    __ASSERT_NO_MSG(len <= GC_THRESHOLD);
 
-    const ssize_t size = nvs_write(&mod.fs, key, data, len);
+    const ssize_t size = storage_write(key, data, len);
 
     return (size < 0) ? -EIO : 0;
 }
 
 int elerium_storage_delete(uint16_t key) {
-    return nvs_delete(&mod.fs, key);
+    return (int)storage_write(key, NULL, 0);
+}
+
+int elerium_storage_save_record(uint16_t key, uint8_t version, const void* data, size_t len) {
+    ssize_t size;
+
+    __ASSERT_NO_MSG(data != NULL);
+    __ASSERT_NO_MSG(len > 0);
+
+    if (len > RECORD_SIZE) {
+        return -E2BIG;
+    }
+
+    // The arena is zeroized on end, so no copy of the record outlives the write
+    const size_t mark = elerium_scratch_begin();
+
+    uint8_t* const record = elerium_scratch_alloc(RECORD_HEADER_SIZE + len);
+
+    if (record == NULL) {
+        elerium_scratch_end(mark);
+        return -ENOMEM;
+    }
+
+    record[0] = version;
+    (void)memcpy(&record[RECORD_HEADER_SIZE], data, len);
+
+    size = storage_write(key, record, RECORD_HEADER_SIZE + len);
+
+    elerium_scratch_end(mark);
+
+    return (size < 0) ? -EIO : 0;
+}
+
+ssize_t elerium_storage_load_record(uint16_t key, uint8_t* version, void* data, size_t cap) {
+    ssize_t size;
+
+    __ASSERT_NO_MSG(version != NULL);
+    __ASSERT_NO_MSG(data != NULL);
+
+    const size_t mark = elerium_scratch_begin();
+
+    uint8_t* const record = elerium_scratch_alloc(RECORD_HEADER_SIZE + RECORD_SIZE);
+
+    if (record == NULL) {
+        elerium_scratch_end(mark);
+        return -ENOMEM;
+    }
+
+    size = storage_read(key, record, RECORD_HEADER_SIZE + RECORD_SIZE);
+
+    if (size < 0) {
+        size = -ENOENT;
+    } else if ((size < RECORD_HEADER_SIZE) || (size > (RECORD_HEADER_SIZE + RECORD_SIZE))
+               || ((size - RECORD_HEADER_SIZE) > cap)) {
+        size = -E2BIG;
+    } else {
+        *version = record[0];
+        size -= RECORD_HEADER_SIZE;
+        (void)memcpy(data, &record[RECORD_HEADER_SIZE], size);
+    }
+
+    elerium_scratch_end(mark);
+
+    return size;
+}
+
+int elerium_storage_txn_begin(void) {
+    int rc = 0;
+    uint8_t* journal = NULL;
+
+    // The journal lives in the arena until commit or abort, claimed before the module lock
+    const size_t mark = elerium_scratch_begin();
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    // Transactions do not nest
+    if (mod.txn_open) {
+        rc = -EBUSY;
+    }
+
+    if (rc == 0) {
+        journal = elerium_scratch_alloc(JOURNAL_SIZE);
+        rc = (journal != NULL) ? 0 : -ENOMEM;
+    }
+
+    // An earlier commit that failed after its journal write has to finish before a new one
+    if ((rc == 0) && mod.journal_pending && (journal_replay(journal) != 0)) {
+        rc = -EIO;
+    }
+
+    if (rc != 0) {
+        k_mutex_unlock(&mod.mut);
+        elerium_scratch_end(mark);
+        return rc;
+    }
+
+    mod.txn_open = true;
+    mod.txn_rc = 0;
+    mod.txn_mark = mark;
+    mod.txn_len = 0;
+    mod.txn = journal;
+
+    return 0;
+}
+
+// A zero length entry deletes the key when the journal is applied
+static int txn_append(uint16_t key, const void* data, size_t len) {
+
+    __ASSERT_NO_MSG(mod.txn_open);
+
+    if (mod.txn_rc != 0) {
+        return mod.txn_rc;
+    }
+
+    if ((key == JOURNAL_ID) || (len > UINT16_MAX)) {
+        mod.txn_rc = -EINVAL;
+    } else if ((JOURNAL_ENTRY_HEADER_SIZE + len) > (JOURNAL_SIZE - mod.txn_len)) {
+        mod.txn_rc = -E2BIG;
+    } else {
+        sys_put_le16(key, &mod.txn[mod.txn_len]);
+        sys_put_le16((uint16_t)len, &mod.txn[mod.txn_len + 2]);
+        mod.txn_len += JOURNAL_ENTRY_HEADER_SIZE;
+
+        if (len > 0) {
+            (void)memcpy(&mod.txn[mod.txn_len], data, len);
+            mod.txn_len += len;
+        }
+    }
+
+    return mod.txn_rc;
+}
+
+int elerium_storage_txn_put(uint16_t key, const void* data, size_t len) {
+
+    __ASSERT_NO_MSG(data != NULL);
+    __ASSERT_NO_MSG(len > 0);
+
+    return txn_append(key, data, len);
+}
+
+int elerium_storage_txn_delete(uint16_t key) {
+    return txn_append(key, NULL, 0);
+}
+
+static void txn_close(void) {
+
+    const size_t mark = mod.txn_mark;
+
+    mod.txn = NULL;
+    mod.txn_len = 0;
+    mod.txn_open = false;
+
+    k_mutex_unlock(&mod.mut);
+
+    // Zeroizes the journal
+    elerium_scratch_end(mark);
+}
+
+int elerium_storage_txn_commit(void) {
+    int rc;
+
+    __ASSERT_NO_MSG(mod.txn_open);
+
+    rc = mod.txn_rc;
+
+    // Once the journal is written the transaction survives power loss and is replayed at init
+    if ((rc == 0) && (mod.txn_len > 0)) {
+        journal_reserve();
+
+        rc = (storage_write(JOURNAL_ID, mod.txn, mod.txn_len) < 0) ? -EIO : 0;
+
+        if (rc == 0) {
+            mod.journal_pending = true;
+            rc = journal_apply(mod.txn, mod.txn_len);
+        }
+
+        if (rc == 0) {
+            rc = (storage_write(JOURNAL_ID, NULL, 0) < 0) ? -EIO : 0;
+            mod.journal_pending = (rc != 0);
+        }
+    }
+
+    txn_close();
+
+    return rc;
+}
+
+void elerium_storage_txn_abort(void) {
+
+    __ASSERT_NO_MSG(mod.txn_open);
+
+    txn_close();
+}
+
+int elerium_storage_stats(struct elerium_storage_stats* stats) {
+
+    __ASSERT_NO_MSG(stats != NULL);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    (void)memcpy(stats, &mod.stats, sizeof(*stats));
+
+    k_mutex_unlock(&mod.mut);
+
+    return 0;
 }
 
 //***************************************************************************//
 
-int storage_init(void) {
+// Entries are written in order, so applying a journal twice leaves the same result
+static int journal_apply(const uint8_t* journal, size_t len) {
+    int rc = 0;
+    size_t pos = 0;
+
+    while ((rc == 0) && (pos < len)) {
+        if ((len - pos) < JOURNAL_ENTRY_HEADER_SIZE) {
+            rc = -EBADMSG;
+            break;
+        }
+
+        const uint16_t key = sys_get_le16(&journal[pos]);
+        const uint16_t size = sys_get_le16(&journal[pos + 2]);
+        pos += JOURNAL_ENTRY_HEADER_SIZE;
+
+        if ((len - pos) < size) {
+            rc = -EBADMSG;
+        } else if (size > 0) {
+            rc = (storage_write(key, &journal[pos], size) < 0) ? -EIO : 0;
+        } else {
+            rc = (storage_write(key, NULL, 0) < 0) ? -EIO : 0;
+        }
+
+        pos += size;
+    }
+
+    return rc;
+}
+
+// Moves to the next sector before the journal is written when the journal, the records it
+// applies and its delete do not fit. Only a transaction larger than the room left in a fresh
+// sector still collects between its writes, the journal is replayed if power fails there.
+static void journal_reserve(void) {
+    size_t need = mod.txn_len + (2 * STORAGE_BACKEND_WRITE_OVERHEAD);
+    size_t pos = 0;
+
+    while ((pos + JOURNAL_ENTRY_HEADER_SIZE) <= mod.txn_len) {
+        const uint16_t size = sys_get_le16(&mod.txn[pos + 2]);
+
+        need += size + STORAGE_BACKEND_WRITE_OVERHEAD;
+        pos += JOURNAL_ENTRY_HEADER_SIZE + size;
+    }
+
+    const ssize_t free = storage_backend_sector_free();
+
+    if ((free >= 0) && (free < need)) {
+        elerium_power_stop_lock_get();
+
+        if (storage_backend_sector_next() == 0) {
+            ++mod.stats.foreground_gc;
+        }
+
+        elerium_power_stop_lock_put();
+    }
+}
+
+// Finishes a transaction whose commit was interrupted after the journal reached flash
+static int journal_replay(uint8_t* journal) {
+    int rc = 0;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    const ssize_t size = storage_backend_read(JOURNAL_ID, journal, JOURNAL_SIZE);
+
+    if (size > JOURNAL_SIZE) {
+        rc = -E2BIG;
+    } else if (size > 0) {
+        rc = journal_apply(journal, size);
+    }
+
+    // A journal that cannot be parsed will never apply, so it is dropped instead of kept
+    if (rc == -EBADMSG) {
+        rc = 0;
+    }
+
+    if ((rc == 0) && (size > 0)) {
+        rc = (storage_write(JOURNAL_ID, NULL, 0) < 0) ? -EIO : 0;
+    }
+
+    mod.journal_pending = (rc != 0);
+
+    (void)memset(journal, 0x00, JOURNAL_SIZE);
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_STORAGE_CACHE)
+
+static struct cache_entry* cache_find(uint16_t key) {
+
+    for (size_t i = 0; i < ARRAY_SIZE(mod.cache); ++i) {
+        if (mod.cache[i].valid && (mod.cache[i].key == key)) {
+            return &mod.cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Entries may hold key material, so every entry is wiped when it leaves the cache
+static void cache_wipe(struct cache_entry* entry) {
+    (void)memset(entry, 0x00, sizeof(*entry));
+}
+
+static ssize_t cache_read(uint16_t key, void* data, size_t len) {
+
+    struct cache_entry* entry = cache_find(key);
+
+    if (entry == NULL) {
+        return -ENOENT;
+    }
+
+    entry->used = ++mod.cache_tick;
+    (void)memcpy(data, entry->data, MIN(len, entry->len));
+
+    return entry->len;
+}
+
+static void cache_store(uint16_t key, const void* data, size_t len) {
+
+    struct cache_entry* entry = cache_find(key);
+
+    if (len > CACHE_ENTRY_SIZE) {
+        if (entry != NULL) {
+            cache_wipe(entry);
+        }
+        return;
+    }
+
+    for (size_t i = 0; (entry == NULL) && (i < ARRAY_SIZE(mod.cache)); ++i) {
+        if (!mod.cache[i].valid) {
+            entry = &mod.cache[i];
+        }
+    }
+
+    if (entry == NULL) {
+        entry = &mod.cache[0];
+
+        for (size_t i = 1; i < ARRAY_SIZE(mod.cache); ++i) {
+            if ((mod.cache_tick - mod.cache[i].used) > (mod.cache_tick - entry->used)) {
+                entry = &mod.cache[i];
+            }
+        }
+    }
+
+    cache_wipe(entry);
+
+    entry->valid = true;
+    entry->key = key;
+    entry->len = len;
+    entry->used = ++mod.cache_tick;
+    (void)memcpy(entry->data, data, len);
+}
+
+static void cache_drop(uint16_t key) {
+
+    struct cache_entry* entry = cache_find(key);
+
+    if (entry != NULL) {
+        cache_wipe(entry);
+    }
+}
+
+#else
+
+static ssize_t cache_read(uint16_t key, void* data, size_t len) {
+    ARG_UNUSED(key);
+    ARG_UNUSED(data);
+    ARG_UNUSED(len);
+
+    return -ENOENT;
+}
+
+static void cache_store(uint16_t key, const void* data, size_t len) {
+    ARG_UNUSED(key);
+    ARG_UNUSED(data);
+    ARG_UNUSED(len);
+}
+
+static void cache_drop(uint16_t key) {
+    ARG_UNUSED(key);
+}
+
+#endif
+
+// Keeps room for the largest record in the active sector, so a save never has to erase
+static void gc_work(struct k_work* work) {
+    ARG_UNUSED(work);
+
+    if (elerium_energy_defer(&mod.gc_work, ELERIUM_ENERGY_COST_FLASH)) {
+        return;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    const ssize_t free = storage_backend_sector_free();
+
+    if ((free >= 0) && (free < GC_THRESHOLD)) {
+        elerium_power_stop_lock_get();
+
+        if (storage_backend_sector_next() == 0) {
+            ++mod.stats.idle_gc;
+        }
+
+        elerium_power_stop_lock_put();
+    }
+
+    k_mutex_unlock(&mod.mut);
+}
+
+int elerium_storage_init(void) {
     int rc;
 
-    struct flash_pages_info info;
+    const struct device* dev = STORAGE_PARTITION_DEVICE;
 
-    mod.fs.flash_device = NVS_PARTITION_DEVICE;
-    if (!device_is_ready(mod.fs.flash_device)) {
+    k_mutex_init(&mod.mut);
+    k_work_init_delayable(&mod.gc_work, &gc_work);
+
+    if (!device_is_ready(dev)) {
         return -EBADF;
     }
-    mod.fs.offset = NVS_PARTITION_OFFSET;
-    rc = flash_get_page_info_by_offs(mod.fs.flash_device, mod.fs.offset, &info);
+
+    rc = storage_backend_mount(dev, STORAGE_PARTITION_OFFSET, STORAGE_PARTITION_SIZE);
     if (rc != 0) {
         return -EBADF;
     }
 
-    mod.fs.sector_size = info.size;
-    mod.fs.sector_count = 2U;
+    const size_t mark = elerium_scratch_begin();
+
+    uint8_t* const journal = elerium_scratch_alloc(JOURNAL_SIZE);
+
+    rc = (journal != NULL) ? journal_replay(journal) : -ENOMEM;
+
+    elerium_scratch_end(mark);
 
-    rc = nvs_mount(&mod.fs);
     if (rc != 0) {
-        return -EBADF;
+        return rc;
     }
 
+    // A tag may lose power before any idle time, so also check once after boot
+    (void)elerium_worker_schedule(&mod.gc_work, GC_DELAY);
+
     return rc;
 }
 
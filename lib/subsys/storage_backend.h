@@ -0,0 +1,35 @@
+
+#ifndef ELERIUM_LIB_SUBSYS_STORAGE_BACKEND_H_
+#define ELERIUM_LIB_SUBSYS_STORAGE_BACKEND_H_
+
+//***************************************************************************//
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+
+//***************************************************************************//
+
+// Upper bound of the allocation entry and alignment padding either backend adds to a write
+#define STORAGE_BACKEND_WRITE_OVERHEAD 32
+
+//***************************************************************************//
+
+/// @brief Implemented by the flash file system selected in Kconfig
+
+int storage_backend_mount(const struct device* dev, off_t offset, size_t size);
+
+ssize_t storage_backend_read(uint16_t key, void* data, size_t len);
+
+ssize_t storage_backend_write(uint16_t key, const void* data, size_t len);
+
+int storage_backend_delete(uint16_t key);
+
+/// @brief Bytes left in the sector currently written to
+ssize_t storage_backend_sector_free(void);
+
+/// @brief Close the active sector now, running the garbage collection and erase it triggers
+int storage_backend_sector_next(void);
+
+//***************************************************************************//
+
+#endif // ELERIUM_LIB_SUBSYS_STORAGE_BACKEND_H_
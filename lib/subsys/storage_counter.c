@@ -0,0 +1,264 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/drivers/flash.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/util.h>
+
+#include "elerium/subsys/power.h"
+#include "elerium/subsys/storage.h"
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_STORAGE_FLASH_ECC)
+#include "storage_ecc.h"
+#endif
+
+//***************************************************************************//
+
+#define COUNTER_PARTITION counter_partition
+
+// Largest flash write block handled, 8 bytes on L4 and 16 on U5
+#define COUNTER_WORD_MAX 16
+
+// Words tried per increase, one that does not read back is left behind
+#define COUNTER_WRITE_ATTEMPTS 2
+
+//***************************************************************************//
+
+// Programmed once per increase into an erased word, the check tells it from a torn write
+struct counter_word {
+    uint32_t value;
+    uint32_t check;
+};
+
+//***************************************************************************//
+
+static int storage_counter_init(void);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(storage_counter_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+// Module
+static struct {
+    struct k_mutex mut;
+    bool scanned;
+    uint32_t value;
+#if FIXED_PARTITION_EXISTS(COUNTER_PARTITION)
+    const struct flash_area* fa;
+    size_t word_size;
+    off_t next;
+#endif
+} mod;
+
+//***************************************************************************//
+
+#if FIXED_PARTITION_EXISTS(COUNTER_PARTITION)
+
+// A torn word fails its ECC on L4 and U5, it reads as -EBADMSG instead of raising an NMI
+static int word_read(off_t offset, uint8_t* word) {
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_STORAGE_FLASH_ECC)
+    return storage_ecc_read(mod.fa, offset, word, mod.word_size);
+#else
+    return flash_area_read(mod.fa, offset, word, mod.word_size);
+#endif
+}
+
+static bool word_erased(const uint8_t* word) {
+    const uint8_t erased = flash_area_erased_val(mod.fa);
+
+    for (size_t i = 0; i < mod.word_size; ++i) {
+        if (word[i] != erased) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The value is the larger of the checkpoint record and the last word programmed in the page
+static int counter_scan(uint16_t key) {
+    int rc;
+
+    uint8_t word[COUNTER_WORD_MAX];
+    struct counter_word entry;
+    uint32_t checkpoint;
+
+    if (mod.scanned) {
+        return 0;
+    }
+
+    rc = flash_area_open(FIXED_PARTITION_ID(COUNTER_PARTITION), &mod.fa);
+
+    if (rc == 0) {
+        mod.word_size = flash_get_write_block_size(flash_area_get_device(mod.fa));
+
+        if ((mod.word_size < sizeof(entry)) || (mod.word_size > sizeof(word))) {
+            rc = -ENOTSUP;
+        }
+    }
+
+    mod.value = 0;
+
+    if ((rc == 0) && (elerium_storage_load(key, &checkpoint, sizeof(checkpoint)) == 0)) {
+        mod.value = checkpoint;
+    }
+
+    for (mod.next = 0; (rc == 0) && ((mod.next + mod.word_size) <= mod.fa->fa_size);
+         mod.next += mod.word_size) {
+        rc = word_read(mod.next, word);
+
+        // A word torn by a power cut is skipped, the next value goes after it
+        if (rc == -EBADMSG) {
+            rc = 0;
+            continue;
+        }
+
+        if ((rc != 0) || word_erased(word)) {
+            break;
+        }
+
+        (void)memcpy(&entry, word, sizeof(entry));
+
+        if (entry.check == ~entry.value) {
+            mod.value = MAX(mod.value, entry.value);
+        }
+    }
+
+    mod.scanned = (rc == 0);
+
+    return rc;
+}
+
+static int word_write(uint16_t key, uint32_t value) {
+    int rc = 0;
+
+    uint8_t word[COUNTER_WORD_MAX];
+    uint8_t readback[COUNTER_WORD_MAX];
+    const struct counter_word entry = { .value = value, .check = ~value };
+
+    // A full page is folded into the checkpoint record before it is erased, a power cut in
+    // between only leaves the same value in both
+    if ((mod.next + mod.word_size) > mod.fa->fa_size) {
+        rc = elerium_storage_save(key, &mod.value, sizeof(mod.value));
+
+        if (rc == 0) {
+            elerium_power_stop_lock_get();
+            rc = flash_area_erase(mod.fa, 0, mod.fa->fa_size);
+            elerium_power_stop_lock_put();
+        }
+
+        if (rc == 0) {
+            mod.next = 0;
+        }
+    }
+
+    if (rc == 0) {
+        (void)memset(word, flash_area_erased_val(mod.fa), sizeof(word));
+        (void)memcpy(word, &entry, sizeof(entry));
+
+        elerium_power_stop_lock_get();
+        rc = flash_area_write(mod.fa, mod.next, word, mod.word_size);
+        elerium_power_stop_lock_put();
+
+        // A word an earlier cut touched while it still read as erased takes the program but
+        // fails its ECC afterwards, the value would be lost at the next scan
+        if (rc == 0) {
+            rc = word_read(mod.next, readback);
+        }
+
+        if ((rc == 0) && (memcmp(readback, word, mod.word_size) != 0)) {
+            rc = -EIO;
+        }
+
+        // Even a failed program may have touched the word, so it is never reused
+        mod.next += mod.word_size;
+    }
+
+    return rc;
+}
+
+static int counter_write(uint16_t key, uint32_t value) {
+    int rc = -EIO;
+
+    for (size_t i = 0; (rc != 0) && (i < COUNTER_WRITE_ATTEMPTS); ++i) {
+        rc = word_write(key, value);
+    }
+
+    return rc;
+}
+
+#else
+
+// Without a counter partition every increase is a record write
+static int counter_scan(uint16_t key) {
+    if (!mod.scanned && (elerium_storage_load(key, &mod.value, sizeof(mod.value)) != 0)) {
+        mod.value = 0;
+    }
+
+    mod.scanned = true;
+
+    return 0;
+}
+
+static int counter_write(uint16_t key, uint32_t value) {
+    return elerium_storage_save(key, &value, sizeof(value));
+}
+
+#endif
+
+//***************************************************************************//
+
+int elerium_storage_counter_load(uint16_t key, uint32_t* value) {
+    int rc;
+
+    __ASSERT_NO_MSG(value != NULL);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = counter_scan(key);
+
+    if (rc == 0) {
+        *value = mod.value;
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
+}
+
+int elerium_storage_counter_save(uint16_t key, uint32_t value) {
+    int rc;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = counter_scan(key);
+
+    if ((rc == 0) && (value < mod.value)) {
+        rc = -EINVAL;
+    }
+
+    if ((rc == 0) && (value > mod.value)) {
+        rc = counter_write(key, value);
+    }
+
+    if (rc == 0) {
+        mod.value = value;
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return (rc == 0) ? 0 : -EIO;
+}
+
+//***************************************************************************//
+
+int storage_counter_init(void) {
+    k_mutex_init(&mod.mut);
+
+    return 0;
+}
+
+//***************************************************************************//
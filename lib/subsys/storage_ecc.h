@@ -0,0 +1,18 @@
+#ifndef ELERIUM_LIB_SUBSYS_STORAGE_ECC_H_
+#define ELERIUM_LIB_SUBSYS_STORAGE_ECC_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+
+//***************************************************************************//
+
+/// @brief Implemented by the SoC flash ECC, storage_counter.c stays hardware independent
+
+/// @brief Flash read that survives a double ECC error, -EBADMSG when the data was lost
+int storage_ecc_read(const struct flash_area* fa, off_t offset, void* data, size_t len);
+
+//***************************************************************************//
+
+#endif // ELERIUM_LIB_SUBSYS_STORAGE_ECC_H_
@@ -0,0 +1,87 @@
+//***************************************************************************//
+
+#include <zephyr/arch/arm/nmi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+
+#include <soc.h>
+
+#include "storage_ecc.h"
+
+//***************************************************************************//
+
+// Double errors are reported through the NMI, the flag is cleared by writing one
+#if defined(CONFIG_SOC_SERIES_STM32L4X)
+#define ECC_DOUBLE_REG (FLASH->ECCR)
+#define ECC_DOUBLE_FLAG FLASH_ECCR_ECCD
+#elif defined(CONFIG_SOC_SERIES_STM32U5X)
+#define ECC_DOUBLE_REG (FLASH->ECCDR)
+#define ECC_DOUBLE_FLAG FLASH_ECCDR_ECCD
+#else
+#error "Flash ECC is not supported on this SoC series"
+#endif
+
+//***************************************************************************//
+
+static int storage_ecc_stm32_init(void);
+static void ecc_nmi(void);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(storage_ecc_stm32_init, PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+// Module
+static struct {
+    volatile bool armed;
+    volatile bool caught;
+} mod;
+
+//***************************************************************************//
+
+// The read is the only flash access while armed, so a double error raised then is its own. The
+// NMI returns into the copy, which finishes with whatever the word held.
+int storage_ecc_read(const struct flash_area* fa, off_t offset, void* data, size_t len) {
+    int rc;
+
+    const unsigned int key = irq_lock();
+
+    mod.caught = false;
+    mod.armed = true;
+
+    rc = flash_area_read(fa, offset, data, len);
+
+    mod.armed = false;
+
+    irq_unlock(key);
+
+    if ((rc == 0) && mod.caught) {
+        rc = -EBADMSG;
+    }
+
+    return rc;
+}
+
+//***************************************************************************//
+
+// Any other NMI resets the core like the kernel's own handler
+void ecc_nmi(void) {
+    if (mod.armed && ((ECC_DOUBLE_REG & ECC_DOUBLE_FLAG) != 0)) {
+        ECC_DOUBLE_REG |= ECC_DOUBLE_FLAG;
+        mod.caught = true;
+        return;
+    }
+
+    NVIC_SystemReset();
+}
+
+int storage_ecc_stm32_init(void) {
+    // A double error left from before the reset is not one of ours
+    ECC_DOUBLE_REG |= ECC_DOUBLE_FLAG;
+
+    z_arm_nmi_set_handler(ecc_nmi);
+
+    return 0;
+}
+
+//***************************************************************************//
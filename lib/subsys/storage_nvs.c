@@ -0,0 +1,70 @@
+
+//***************************************************************************//
+
+#include <zephyr/drivers/flash.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/kernel.h>
+
+#include "storage_backend.h"
+
+//***************************************************************************//
+
+#define SECTOR_COUNT CONFIG_BEECHAT_ELERIUM_STORAGE_SECTOR_COUNT
+
+//***************************************************************************//
+
+// Module
+static struct {
+    struct nvs_fs fs;
+} mod;
+
+//***************************************************************************//
+
+int storage_backend_mount(const struct device* dev, off_t offset, size_t size) {
+    int rc;
+
+    struct flash_pages_info info;
+
+    rc = flash_get_page_info_by_offs(dev, offset, &info);
+    if (rc != 0) {
+        return rc;
+    }
+
+    // One sector per flash page, NVS needs at least two to garbage collect
+    const size_t pages = size / info.size;
+    const size_t count = (SECTOR_COUNT != 0) ? SECTOR_COUNT : pages;
+
+    if ((info.size > UINT16_MAX) || (count < 2) || (count > pages) || (count > UINT16_MAX)) {
+        return -EINVAL;
+    }
+
+    mod.fs.flash_device = dev;
+    mod.fs.offset = offset;
+    mod.fs.sector_size = info.size;
+    mod.fs.sector_count = count;
+
+    return nvs_mount(&mod.fs);
+}
+
+ssize_t storage_backend_read(uint16_t key, void* data, size_t len) {
+    return nvs_read(&mod.fs, key, data, len);
+}
+
+ssize_t storage_backend_write(uint16_t key, const void* data, size_t len) {
+    return nvs_write(&mod.fs, key, data, len);
+}
+
+int storage_backend_delete(uint16_t key) {
+    return nvs_delete(&mod.fs, key);
+}
+
+ssize_t storage_backend_sector_free(void) {
+    // Data grows up and allocation entries grow down within the active sector
+    return (ssize_t)(mod.fs.ate_wra - mod.fs.data_wra);
+}
+
+int storage_backend_sector_next(void) {
+    return nvs_sector_use_next(&mod.fs);
+}
+
+//***************************************************************************//
@@ -0,0 +1,69 @@
+
+//***************************************************************************//
+
+#include <zephyr/drivers/flash.h>
+#include <zephyr/fs/zms.h>
+#include <zephyr/kernel.h>
+
+#include "storage_backend.h"
+
+//***************************************************************************//
+
+#define SECTOR_COUNT CONFIG_BEECHAT_ELERIUM_STORAGE_SECTOR_COUNT
+
+//***************************************************************************//
+
+// Module
+static struct {
+    struct zms_fs fs;
+} mod;
+
+//***************************************************************************//
+
+int storage_backend_mount(const struct device* dev, off_t offset, size_t size) {
+    int rc;
+
+    struct flash_pages_info info;
+
+    rc = flash_get_page_info_by_offs(dev, offset, &info);
+    if (rc != 0) {
+        return rc;
+    }
+
+    // One sector per flash page, ZMS needs at least two to garbage collect
+    const size_t pages = size / info.size;
+    const size_t count = (SECTOR_COUNT != 0) ? SECTOR_COUNT : pages;
+
+    if ((count < 2) || (count > pages)) {
+        return -EINVAL;
+    }
+
+    mod.fs.flash_device = dev;
+    mod.fs.offset = offset;
+    mod.fs.sector_size = info.size;
+    mod.fs.sector_count = count;
+
+    return zms_mount(&mod.fs);
+}
+
+ssize_t storage_backend_read(uint16_t key, void* data, size_t len) {
+    return zms_read(&mod.fs, key, data, len);
+}
+
+ssize_t storage_backend_write(uint16_t key, const void* data, size_t len) {
+    return zms_write(&mod.fs, key, data, len);
+}
+
+int storage_backend_delete(uint16_t key) {
+    return zms_delete(&mod.fs, key);
+}
+
+ssize_t storage_backend_sector_free(void) {
+    return zms_active_sector_free_space(&mod.fs);
+}
+
+int storage_backend_sector_next(void) {
+    return zms_sector_use_next(&mod.fs);
+}
+
+//***************************************************************************//
@@ -0,0 +1,203 @@
+
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "elerium/subsys/nfc.h"
+#include "elerium/subsys/scratch.h"
+#include "elerium/subsys/storage.h"
+#include "elerium/subsys/subsys.h"
+#include "elerium/subsys/url_sign.h"
+#include "elerium/subsys/wallet.h"
+
+//***************************************************************************//
+
+struct subsys_entry {
+    int (*init)(void);
+    uint32_t deps;
+    bool lazy;
+};
+
+//***************************************************************************//
+
+static int subsys_init(void);
+static int subsys_start(enum elerium_subsys subsys);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(subsys_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+// Static Data
+static const struct subsys_entry entries[ELERIUM_SUBSYS_COUNT] = {
+    [ELERIUM_SUBSYS_STORAGE] = {
+        .init = elerium_storage_init,
+    },
+    [ELERIUM_SUBSYS_NFC] = {
+        .init = elerium_nfc_init,
+    },
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_URL_SIGN)
+    // Writes the first NDEF URL, needed before the reader looks at the tag
+    [ELERIUM_SUBSYS_URL_SIGN] = {
+        .init = elerium_url_sign_init,
+        .deps = BIT(ELERIUM_SUBSYS_STORAGE) | BIT(ELERIUM_SUBSYS_NFC),
+    },
+#endif
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET)
+    [ELERIUM_SUBSYS_WALLET] = {
+        .init = elerium_wallet_init,
+        .deps = BIT(ELERIUM_SUBSYS_STORAGE),
+        .lazy = IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_LAZY_INIT),
+    },
+#endif
+};
+
+// Module
+static struct {
+    struct k_mutex mut;
+    struct elerium_subsys_profile profile[ELERIUM_SUBSYS_COUNT];
+    uint32_t boot_us;
+} mod;
+
+//***************************************************************************//
+
+int elerium_subsys_require(enum elerium_subsys subsys) {
+    int rc;
+
+    if (subsys >= ELERIUM_SUBSYS_COUNT) {
+        return -EINVAL;
+    }
+
+    // Ready is final, skip the lock on the common path
+    if (mod.profile[subsys].state == ELERIUM_SUBSYS_STATE_READY) {
+        return 0;
+    }
+
+    // Init may stage storage records in the arena, claimed before the lock like everywhere else
+    const size_t mark = elerium_scratch_begin();
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    rc = subsys_start(subsys);
+
+    k_mutex_unlock(&mod.mut);
+
+    elerium_scratch_end(mark);
+
+    return rc;
+}
+
+int elerium_subsys_profile(enum elerium_subsys subsys, struct elerium_subsys_profile* profile) {
+
+    __ASSERT_NO_MSG(profile != NULL);
+
+    if (subsys >= ELERIUM_SUBSYS_COUNT) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    (void)memcpy(profile, &mod.profile[subsys], sizeof(*profile));
+
+    k_mutex_unlock(&mod.mut);
+
+    return 0;
+}
+
+uint32_t elerium_subsys_boot_us(void) {
+    return mod.boot_us;
+}
+
+void elerium_subsys_provisioned(enum elerium_subsys subsys, uint32_t us) {
+    if (subsys >= ELERIUM_SUBSYS_COUNT) {
+        return;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    mod.profile[subsys].provision_us = us;
+
+    k_mutex_unlock(&mod.mut);
+}
+
+//***************************************************************************//
+
+static uint32_t uptime_us(void) {
+    return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+int subsys_start(enum elerium_subsys subsys) {
+    int rc = 0;
+
+    struct elerium_subsys_profile* profile = &mod.profile[subsys];
+
+    switch (profile->state) {
+        case ELERIUM_SUBSYS_STATE_READY:
+            return 0;
+        case ELERIUM_SUBSYS_STATE_FAILED:
+            return profile->rc;
+        case ELERIUM_SUBSYS_STATE_DISABLED:
+            return -ENOTSUP;
+        case ELERIUM_SUBSYS_STATE_RUNNING:
+            // Dependency cycle
+            return -EDEADLK;
+        default:
+            break;
+    }
+
+    profile->state = ELERIUM_SUBSYS_STATE_RUNNING;
+
+    // The mutex is recursive, dependencies are started from the same thread
+    for (size_t i = 0; (rc == 0) && (i < ELERIUM_SUBSYS_COUNT); ++i) {
+        if ((entries[subsys].deps & BIT(i)) != 0) {
+            rc = subsys_start(i);
+        }
+    }
+
+    profile->start_us = uptime_us();
+
+    if (rc == 0) {
+        const uint32_t start = k_cycle_get_32();
+
+        rc = entries[subsys].init();
+
+        profile->init_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+    }
+
+    profile->rc = rc;
+    profile->state = (rc == 0) ? ELERIUM_SUBSYS_STATE_READY : ELERIUM_SUBSYS_STATE_FAILED;
+
+    return rc;
+}
+
+int subsys_init(void) {
+    int rc = 0;
+
+    k_mutex_init(&mod.mut);
+
+    for (size_t i = 0; i < ELERIUM_SUBSYS_COUNT; ++i) {
+        if (entries[i].init != NULL) {
+            mod.profile[i].state = ELERIUM_SUBSYS_STATE_PENDING;
+        }
+    }
+
+    // Lazy subsystems are started by their first elerium_subsys_require
+    for (size_t i = 0; i < ELERIUM_SUBSYS_COUNT; ++i) {
+        if ((entries[i].init != NULL) && !entries[i].lazy) {
+            const int subsys_rc = subsys_start(i);
+
+            if (rc == 0) {
+                rc = subsys_rc;
+            }
+        }
+    }
+
+    mod.boot_us = uptime_us();
+
+    return rc;
+}
+
+//***************************************************************************//
@@ -3,19 +3,59 @@
 
 #include <string.h>
 
+#include <zephyr/drivers/hwinfo.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/reboot.h>
 #include <zephyr/sys/util.h>
 
 #include "elerium/subsys/crypto.h"
+#include "elerium/subsys/energy.h"
 #include "elerium/subsys/nfc.h"
+#include "elerium/subsys/scratch.h"
+#include "elerium/subsys/subsys.h"
 #include "elerium/subsys/storage.h"
 #include "elerium/subsys/url_sign.h"
+#include "elerium/subsys/worker.h"
 
 //***************************************************************************//
 
 #define KEY_PAIR_ID 0x0B01
 #define URL_DATA_ID 0x0B02
+#define COUNTER_ID 0x0B03
+#define TEMPLATE_ID 0x0B04
+
+#define COUNTER_STEP CONFIG_BEECHAT_ELERIUM_URL_SIGN_COUNTER_STEP
+
+#define RING_DEPTH CONFIG_BEECHAT_ELERIUM_URL_SIGN_RING_DEPTH
+#define RING_REFILL_THRESHOLD CONFIG_BEECHAT_ELERIUM_URL_SIGN_RING_REFILL_THRESHOLD
+#define RING_REFILL_DELAY K_MSEC(CONFIG_BEECHAT_ELERIUM_URL_SIGN_RING_REFILL_DELAY_MS)
+
+#define PROVISION_RETRY K_MSEC(CONFIG_BEECHAT_ELERIUM_PROVISION_RETRY_MS)
+
+#define TEMPLATE_MAX_SEGMENTS 16
+#define UID_MAX_SIZE 16
+
+// The version names both the encoding and the signed message rule, URLs without one predate
+// URL-bound signatures and only covered the counter and nonce
+#define CTR_MAX_LEN (sizeof("4294967295") - 1)
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_URL_SIGN_FORMAT_BASE64URL)
+#define FORMAT_VERSION "2"
+#define RND_MAX_LEN (((sizeof(uint64_t) * 4) + 2) / 3)
+#define SIG_MAX_LEN (((sizeof(((struct elerium_signature*)0)->data) * 4) + 2) / 3)
+#else
+#define FORMAT_VERSION "1"
+#define RND_MAX_LEN (sizeof("18446744073709551615") - 1)
+#define SIG_MAX_LEN (sizeof(((struct elerium_signature*)0)->data) * 2)
+#endif
+
+#define FORMAT_VERSION_PARAM "v=" FORMAT_VERSION
+#define TEMPLATE_DEFAULT_QUERY "?" FORMAT_VERSION_PARAM "&ctr={ctr}&rnd={rnd}&sign={sig}"
+
+// Encoded signature with its terminator, borrowed from the scratch arena while rendering
+#define SIG_TEXT_SIZE (SIG_MAX_LEN + 1)
+
+BUILD_ASSERT(ELERIUM_SCRATCH_ROUND(SIG_TEXT_SIZE) <= ELERIUM_SCRATCH_SIZE);
 
 //***************************************************************************//
 
@@ -25,59 +65,142 @@ struct url_sign_data {
     char url[256];
 };
 
+enum url_segment_type {
+    URL_SEGMENT_TEXT,
+    URL_SEGMENT_UID,
+    URL_SEGMENT_CTR,
+    URL_SEGMENT_RND,
+    URL_SEGMENT_SIG,
+};
+
+struct url_segment {
+    uint8_t type;
+    uint8_t offset;
+    uint8_t len;
+};
+
+/// @brief URL parsed at program time, literal text segments point into text
+struct url_template {
+    uint8_t count;
+    uint8_t text_len;
+    struct url_segment segments[TEMPLATE_MAX_SEGMENTS];
+    char text[256];
+
+    // Signed message state after the leading literal segments
+    uint8_t prefix_count;
+    struct elerium_sha256_midstate prefix_midstate;
+};
+
+struct url_fields {
+    char ctr[CTR_MAX_LEN];
+    char rnd[RND_MAX_LEN];
+    const char* sig;
+    size_t ctr_len;
+    size_t rnd_len;
+    size_t sig_len;
+};
+
+struct url_sign_entry {
+    uint32_t counter;
+    uint64_t rnd_number;
+    struct elerium_signature sign;
+};
+
 //***************************************************************************//
 
-static int url_sign_init(void);
 static int generate_url(void);
+static int template_compile(const char* url, struct url_template* template);
+static int sign_entry(struct url_sign_entry* entry);
+static int message_hash(const struct url_fields* fields, struct elerium_hash* hash);
+static int encode_fields(const struct url_sign_entry* entry, struct url_fields* fields);
+static size_t segment_data(const struct url_segment* segment,
+                           const struct url_fields* fields,
+                           const char** data);
+static int counter_next(uint32_t* counter);
+static void ring_clear(void);
+static bool ring_pop(struct url_sign_entry* entry);
 static int set_default_url(void);
 
 //***************************************************************************//
 
-// Kernel
-SYS_INIT(url_sign_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
-
-static char url_buffer[2048];
-static char url_sign_hex_buffer[256];
-static struct elerium_hash rnd_number_hash;
-static struct elerium_signature rnd_number_sign;
 
 // Module
 static struct {
     struct k_mutex mut;
     struct elerium_key_pair key_pair;
     struct url_sign_data sign_data;
+    struct url_template template;
     struct k_work_delayable generate_work;
     struct k_work_delayable reset_work;
+
+    // Key pair is generated in the background on first boot
+    bool key_ready;
+    struct k_work_delayable provision_work;
+
+    // Device unique ID, hex encoded once at boot
+    char uid_hex[(UID_MAX_SIZE * 2) + 1];
+    uint8_t uid_len;
+
+    // Tap counter, values below counter_limit are reserved in storage
+    uint32_t counter;
+    uint32_t counter_limit;
+
+#if RING_DEPTH > 0
+    // Pre-signed entries, served oldest first
+    struct url_sign_entry ring[RING_DEPTH];
+    size_t ring_head;
+    size_t ring_count;
+    struct k_work_delayable refill_work;
+#endif
 } mod;
 
 //***************************************************************************//
 
 int elerium_url_sign_get_pub(struct elerium_pub_key* pub_key) {
+    int rc = -EINPROGRESS;
 
     __ASSERT_NO_MSG(pub_key != NULL);
 
-    memcpy(pub_key, &mod.key_pair.pub, sizeof(*pub_key));
+    k_mutex_lock(&mod.mut, K_FOREVER);
 
-    return 0;
+    if (mod.key_ready) {
+        memcpy(pub_key, &mod.key_pair.pub, sizeof(*pub_key));
+        rc = 0;
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
 }
 
 int elerium_url_sign_get_pub_raw(uint8_t* data, size_t cap) {
+    int rc = -EINPROGRESS;
 
     __ASSERT_NO_MSG(pub_key != NULL);
     __ASSERT_NO_MSG(sizeof(mod.key_pair.pub) <= cap);
 
-    memcpy(data, &mod.key_pair.pub, sizeof(mod.key_pair.pub));
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    if (mod.key_ready) {
+        memcpy(data, &mod.key_pair.pub, sizeof(mod.key_pair.pub));
+        rc = 0;
+    }
 
-    return 0;
+    k_mutex_unlock(&mod.mut);
+
+    return rc;
 }
 
 int elerium_url_sign_generate(void) {
 
     int rc = -EAGAIN;
 
+    // Rendering borrows from the arena, claimed before the module lock like every other user
+    const size_t mark = elerium_scratch_begin();
+
     k_mutex_lock(&mod.mut, K_FOREVER);
 
-    if (mod.sign_data.enabled) {
+    if (mod.sign_data.enabled && mod.key_ready) {
         rc = 0;
     } else {
         (void)set_default_url();
@@ -87,13 +210,21 @@ int elerium_url_sign_generate(void) {
         rc = generate_url();
     }
 
-    if (rc == 0) {
-        url_buffer[sizeof(url_buffer) - 1] = '\0';
-        rc = elerium_nfc_set_ndef_url(url_buffer, strlen(url_buffer));
-    }
+#if RING_DEPTH > 0
+    // Refill once the ring drops to the threshold, after the reader is done
+    const bool refill = mod.sign_data.enabled && (mod.ring_count <= RING_REFILL_THRESHOLD);
+#endif
 
     k_mutex_unlock(&mod.mut);
 
+    elerium_scratch_end(mark);
+
+#if RING_DEPTH > 0
+    if (refill) {
+        (void)elerium_worker_reschedule(&mod.refill_work, RING_REFILL_DELAY);
+    }
+#endif
+
     return rc;
 }
 
@@ -103,28 +234,49 @@ int elerium_url_sign_program(const char* password, const char* url) {
     __ASSERT_NO_MSG(password != NULL);
     __ASSERT_NO_MSG(url != NULL);
 
+    // The storage transaction stages its journal in the arena
+    const size_t mark = elerium_scratch_begin();
+
     k_mutex_lock(&mod.mut, K_FOREVER);
 
     // Check if URL signer already enabled
-    if (!mod.sign_data.enabled) {
+    if (!mod.key_ready) {
+        rc = -EINPROGRESS;
+    } else if (!mod.sign_data.enabled) {
         rc = 0;
     }
 
+    if (rc == 0) {
+        rc = template_compile(url, &mod.template);
+    }
+
+    // Template and URL data are committed together so a power cut never leaves them mismatched
+    if (rc == 0) {
+        rc = elerium_storage_txn_begin();
+    }
+
     if (rc == 0) {
         elerium_crypto_sha256(password, strlen(password), &mod.sign_data.password_hash);
 
         strncpy(mod.sign_data.url, url, sizeof(mod.sign_data.url) - 1);
 
         mod.sign_data.enabled = true;
-        rc = elerium_storage_save(URL_DATA_ID, &mod.sign_data, sizeof(mod.sign_data));
+
+        (void)elerium_storage_txn_put(TEMPLATE_ID, &mod.template, sizeof(mod.template));
+        (void)elerium_storage_txn_put(URL_DATA_ID, &mod.sign_data, sizeof(mod.sign_data));
+        rc = elerium_storage_txn_commit();
 
         mod.sign_data.enabled = (rc == 0);
+
+        ring_clear();
     }
 
     k_mutex_unlock(&mod.mut);
 
+    elerium_scratch_end(mark);
+
     if (rc == 0) {
-        k_work_schedule(&mod.generate_work, K_MSEC(2000));
+        elerium_worker_schedule(&mod.generate_work, K_MSEC(2000));
     }
 
     return rc;
@@ -138,6 +290,8 @@ int elerium_url_sign_reset(const char* password) {
     struct elerium_hash password_hash = { 0 };
     rc = elerium_crypto_sha256(password, strlen(password), &password_hash);
 
+    const size_t mark = elerium_scratch_begin();
+
     k_mutex_lock(&mod.mut, K_FOREVER);
 
     if (rc == 0) {
@@ -150,15 +304,24 @@ int elerium_url_sign_reset(const char* password) {
 
     // Password is correct
     if (rc == 0) {
-        elerium_storage_delete(URL_DATA_ID);
+        if (elerium_storage_txn_begin() == 0) {
+            (void)elerium_storage_txn_delete(URL_DATA_ID);
+            (void)elerium_storage_txn_delete(TEMPLATE_ID);
+            (void)elerium_storage_txn_commit();
+        }
         memset(&mod.sign_data, 0x00, sizeof(mod.sign_data));
+        memset(&mod.template, 0x00, sizeof(mod.template));
         mod.sign_data.enabled = false;
+
+        ring_clear();
     }
 
     k_mutex_unlock(&mod.mut);
 
+    elerium_scratch_end(mark);
+
     if (rc == 0) {
-        k_work_schedule(&mod.reset_work, K_MSEC(2500));
+        elerium_worker_schedule(&mod.reset_work, K_MSEC(2500));
     }
 
     return rc;
@@ -167,80 +330,600 @@ int elerium_url_sign_reset(const char* password) {
 //***************************************************************************//
 
 int set_default_url(void) {
-    (void)snprintk(
-        url_buffer, sizeof(url_buffer), "%s", CONFIG_BEECHAT_ELERIUM_URL_SIGN_DEFAULT_URI);
-    return elerium_nfc_set_ndef_url(url_buffer, strlen(url_buffer));
+    return elerium_nfc_set_ndef_url(CONFIG_BEECHAT_ELERIUM_URL_SIGN_DEFAULT_URI,
+                                    strlen(CONFIG_BEECHAT_ELERIUM_URL_SIGN_DEFAULT_URI));
 }
 
-int generate_url(void) {
-    int rc;
+static int template_add(struct url_template* template,
+                        enum url_segment_type type,
+                        const char* text,
+                        size_t len) {
 
-    const uint64_t rnd_number = elerium_crypto_random();
+    if ((type == URL_SEGMENT_TEXT) && (len == 0)) {
+        return 0;
+    }
 
-    int size = snprintk(url_buffer, sizeof(url_buffer), "%llu", rnd_number);
+    if (template->count >= ARRAY_SIZE(template->segments)) {
+        return -ENOMEM;
+    }
+
+    struct url_segment* segment = &template->segments[template->count];
+
+    segment->type = type;
+    segment->offset = template->text_len;
+    segment->len = 0;
+
+    if (type == URL_SEGMENT_TEXT) {
+        if (len > (UINT8_MAX - template->text_len)) {
+            return -ENOMEM;
+        }
+
+        // Merge adjacent literals
+        if ((template->count > 0) && (segment[-1].type == URL_SEGMENT_TEXT)) {
+            --segment;
+        } else {
+            ++template->count;
+        }
+
+        (void)memcpy(&template->text[template->text_len], text, len);
+        template->text_len += len;
+        segment->len += len;
 
-    if (size > 0) {
-        // TODO: change to 'size' instead of strlen()
-        rc = elerium_crypto_sha256(url_buffer, strlen(url_buffer), &rnd_number_hash);
     } else {
+        ++template->count;
+    }
+
+    return 0;
+}
+
+static size_t template_max_len(const struct url_template* template) {
+    size_t len = 0;
+
+    for (size_t i = 0; i < template->count; ++i) {
+        switch (template->segments[i].type) {
+        case URL_SEGMENT_TEXT:
+            len += template->segments[i].len;
+            break;
+        case URL_SEGMENT_UID:
+            len += UID_MAX_SIZE * 2;
+            break;
+        case URL_SEGMENT_CTR:
+            len += CTR_MAX_LEN;
+            break;
+        case URL_SEGMENT_RND:
+            len += RND_MAX_LEN;
+            break;
+        case URL_SEGMENT_SIG:
+            len += SIG_MAX_LEN;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return len;
+}
+
+static int template_parse(const char* url, struct url_template* template) {
+    static const struct {
+        const char* name;
+        enum url_segment_type type;
+    } fields[] = {
+        { "{uid}", URL_SEGMENT_UID },
+        { "{ctr}", URL_SEGMENT_CTR },
+        { "{rnd}", URL_SEGMENT_RND },
+        { "{sig}", URL_SEGMENT_SIG },
+    };
+
+    int rc = 0;
+
+    const char* text = url;
+
+    while ((rc == 0) && (*url != '\0')) {
+        if (*url != '{') {
+            ++url;
+            continue;
+        }
+
+        size_t i;
+        for (i = 0; i < ARRAY_SIZE(fields); ++i) {
+            if (strncmp(url, fields[i].name, strlen(fields[i].name)) == 0) {
+                break;
+            }
+        }
+
+        if (i == ARRAY_SIZE(fields)) {
+            return -EINVAL;
+        }
+
+        rc = template_add(template, URL_SEGMENT_TEXT, text, url - text);
+
+        if (rc == 0) {
+            rc = template_add(template, fields[i].type, NULL, 0);
+        }
+
+        url += strlen(fields[i].name);
+        text = url;
+    }
+
+    if (rc == 0) {
+        rc = template_add(template, URL_SEGMENT_TEXT, text, url - text);
+    }
+
+    return rc;
+}
+
+// Hash the constant prefix once, every signature continues from this midstate
+static int template_prefix(struct url_template* template) {
+    int rc;
+
+    struct elerium_sha256_ctx ctx;
+    size_t sig_count = 0;
+
+    for (size_t i = 0; i < template->count; ++i) {
+        if (template->segments[i].type == URL_SEGMENT_SIG) {
+            ++sig_count;
+        }
+    }
+
+    // A single signature, otherwise the URL is not bound to it
+    if (sig_count != 1) {
+        return -EINVAL;
+    }
+
+    rc = elerium_crypto_sha256_init(&ctx);
+
+    template->prefix_count = 0;
+
+    while ((rc == 0) && (template->prefix_count < template->count)) {
+        const struct url_segment* segment = &template->segments[template->prefix_count];
+
+        if (segment->type != URL_SEGMENT_TEXT) {
+            break;
+        }
+
+        rc = elerium_crypto_sha256_update(&ctx, &template->text[segment->offset], segment->len);
+        ++template->prefix_count;
+    }
+
+    if (rc == 0) {
+        rc = elerium_crypto_sha256_export(&ctx, &template->prefix_midstate);
+    }
+
+    return rc;
+}
+
+// The backend reads the format from v, so a custom template has to carry it in its query
+static bool template_has_version(const char* url) {
+    const size_t len = strlen(FORMAT_VERSION_PARAM);
+
+    for (const char* p = strchr(url, '?'); p != NULL; p = strchr(p + 1, '&')) {
+        if ((strncmp(p + 1, FORMAT_VERSION_PARAM, len) == 0)
+            && ((p[1 + len] == '&') || (p[1 + len] == '\0'))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int template_compile(const char* url, struct url_template* template) {
+    int rc;
+
+    (void)memset(template, 0x00, sizeof(*template));
+
+    rc = template_parse(url, template);
+
+    // Plain URLs get the query of the selected format, which names its version
+    if ((rc == 0) && (strchr(url, '{') == NULL)) {
+        rc = template_parse(TEMPLATE_DEFAULT_QUERY, template);
+    } else if ((rc == 0) && !template_has_version(url)) {
+        rc = -EINVAL;
+    }
+
+    // The longest rendering has to fit the NDEF record, checked once here instead of per tap
+    if ((rc == 0) && (template_max_len(template) > ELERIUM_NFC_NDEF_URL_MAX_LEN)) {
         rc = -EMSGSIZE;
     }
 
     if (rc == 0) {
-        rc = elerium_crypto_sign(&mod.key_pair.priv,
-                                 rnd_number_hash.data,
-                                 sizeof(rnd_number_hash.data),
-                                 &rnd_number_sign);
+        rc = template_prefix(template);
+    }
+
+    return rc;
+}
+
+static size_t dec_encode(uint64_t value, char* out) {
+    char digits[sizeof("18446744073709551615") - 1];
+    size_t len = 0;
+
+    do {
+        digits[len++] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = digits[len - 1 - i];
+    }
+
+    return len;
+}
+
+int counter_next(uint32_t* counter) {
+    int rc = 0;
+
+    // Reserve the next range before handing out values from it, one word of the counter page
+    if (mod.counter >= mod.counter_limit) {
+        if (mod.counter > (UINT32_MAX - COUNTER_STEP)) {
+            return -EOVERFLOW;
+        }
+
+        const uint32_t limit = mod.counter + COUNTER_STEP;
+
+        rc = elerium_storage_counter_save(COUNTER_ID, limit);
+        if (rc == 0) {
+            mod.counter_limit = limit;
+        }
     }
 
     if (rc == 0) {
+        *counter = mod.counter++;
+    }
 
-        size = bin2hex(rnd_number_sign.data,
-                       sizeof(rnd_number_sign.data),
-                       url_sign_hex_buffer,
-                       sizeof(url_sign_hex_buffer));
+    return rc;
+}
+
+// The signed message is the rendered URL without the scheme and the signature itself
+int message_hash(const struct url_fields* fields, struct elerium_hash* hash) {
+    int rc;
 
-        if (size == 0) {
-            rc = -EMSGSIZE;
+    struct elerium_sha256_ctx ctx;
+
+    // Only the variable tail is hashed on each entry
+    rc = elerium_crypto_sha256_import(&ctx, &mod.template.prefix_midstate);
+
+    for (size_t i = mod.template.prefix_count; (rc == 0) && (i < mod.template.count); ++i) {
+        const struct url_segment* segment = &mod.template.segments[i];
+        const char* data;
+
+        if (segment->type != URL_SEGMENT_SIG) {
+            const size_t len = segment_data(segment, fields, &data);
+            rc = elerium_crypto_sha256_update(&ctx, data, len);
         }
     }
 
     if (rc == 0) {
-        size = snprintk(url_buffer,
-                        sizeof(url_buffer),
-                        "%s?rnd=%llu&sign=%s",
-                        mod.sign_data.url,
-                        rnd_number,
-                        url_sign_hex_buffer);
+        rc = elerium_crypto_sha256_final(&ctx, hash);
+    }
+
+    return rc;
+}
+
+int sign_entry(struct url_sign_entry* entry) {
+    int rc;
+
+    struct url_fields fields;
+    struct elerium_hash hash;
+
+    rc = counter_next(&entry->counter);
+
+    if (rc == 0) {
+        rc = elerium_crypto_random(&entry->rnd_number);
+    }
+
+    if (rc == 0) {
+        rc = encode_fields(entry, &fields);
+    }
+
+    if (rc == 0) {
+        rc = message_hash(&fields, &hash);
+    }
 
-        rc = (size > 0) ? 0 : -EMSGSIZE;
+    if (rc == 0) {
+        rc = elerium_crypto_sign(&mod.key_pair.priv, hash.data, sizeof(hash.data), &entry->sign);
     }
 
     return rc;
 }
 
-static int init_key(void) {
+#if RING_DEPTH > 0
+void ring_clear(void) {
+    (void)memset(mod.ring, 0x00, sizeof(mod.ring));
+    mod.ring_head = 0;
+    mod.ring_count = 0;
+}
+
+bool ring_pop(struct url_sign_entry* entry) {
+    if (mod.ring_count == 0) {
+        return false;
+    }
+
+    (void)memcpy(entry, &mod.ring[mod.ring_head], sizeof(*entry));
+    (void)memset(&mod.ring[mod.ring_head], 0x00, sizeof(*entry));
+
+    mod.ring_head = (mod.ring_head + 1) % ARRAY_SIZE(mod.ring);
+    --mod.ring_count;
+
+    return true;
+}
+#else
+void ring_clear(void) {
+}
+
+bool ring_pop(struct url_sign_entry* entry) {
+    ARG_UNUSED(entry);
+
+    return false;
+}
+#endif
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_URL_SIGN_FORMAT_BASE64URL)
+// RFC 4648 base64url without padding, returns the encoded length or 0
+static size_t base64url_encode(const uint8_t* data, size_t len, char* out, size_t cap) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    const size_t out_len = ((len * 4) + 2) / 3;
+    size_t pos = 0;
+
+    if (cap < (out_len + 1)) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t group = (uint32_t)data[i] << 16;
+
+        if ((i + 1) < len) {
+            group |= (uint32_t)data[i + 1] << 8;
+        }
+
+        if ((i + 2) < len) {
+            group |= data[i + 2];
+        }
+
+        for (size_t j = 0; (j < 4) && (pos < out_len); ++j) {
+            out[pos++] = alphabet[(group >> (18 - (6 * j))) & 0x3F];
+        }
+    }
 
+    out[pos] = '\0';
+
+    return pos;
+}
+
+int encode_fields(const struct url_sign_entry* entry, struct url_fields* fields) {
+    // Big-endian so the encoded nonce sorts and parses like the integer
+    uint8_t rnd_number[sizeof(entry->rnd_number)];
+    char rnd_number_b64[RND_MAX_LEN + 1];
+
+    fields->ctr_len = dec_encode(entry->counter, fields->ctr);
+
+    sys_put_be64(entry->rnd_number, rnd_number);
+
+    fields->rnd_len =
+        base64url_encode(rnd_number, sizeof(rnd_number), rnd_number_b64, sizeof(rnd_number_b64));
+    if (fields->rnd_len == 0) {
+        return -EMSGSIZE;
+    }
+
+    (void)memcpy(fields->rnd, rnd_number_b64, fields->rnd_len);
+
+    return 0;
+}
+
+static int encode_sign(const struct url_sign_entry* entry, char* out, struct url_fields* fields) {
+    fields->sig = out;
+    fields->sig_len =
+        base64url_encode(entry->sign.data, sizeof(entry->sign.data), out, SIG_TEXT_SIZE);
+
+    return (fields->sig_len == 0) ? -EMSGSIZE : 0;
+}
+#else
+int encode_fields(const struct url_sign_entry* entry, struct url_fields* fields) {
+    fields->ctr_len = dec_encode(entry->counter, fields->ctr);
+    fields->rnd_len = dec_encode(entry->rnd_number, fields->rnd);
+
+    return 0;
+}
+
+static int encode_sign(const struct url_sign_entry* entry, char* out, struct url_fields* fields) {
+    fields->sig = out;
+    fields->sig_len = bin2hex(entry->sign.data, sizeof(entry->sign.data), out, SIG_TEXT_SIZE);
+
+    return (fields->sig_len == 0) ? -EMSGSIZE : 0;
+}
+#endif
+
+size_t segment_data(const struct url_segment* segment,
+                    const struct url_fields* fields,
+                    const char** data) {
+
+    switch (segment->type) {
+    case URL_SEGMENT_TEXT:
+        *data = &mod.template.text[segment->offset];
+        return segment->len;
+    case URL_SEGMENT_UID:
+        *data = mod.uid_hex;
+        return mod.uid_len * 2;
+    case URL_SEGMENT_CTR:
+        *data = fields->ctr;
+        return fields->ctr_len;
+    case URL_SEGMENT_RND:
+        *data = fields->rnd;
+        return fields->rnd_len;
+    case URL_SEGMENT_SIG:
+        *data = fields->sig;
+        return fields->sig_len;
+    default:
+        *data = NULL;
+        return 0;
+    }
+}
+
+// Stream the template into the NDEF record, fields are encoded up front for the length
+static int render_url(const struct url_sign_entry* entry) {
     int rc;
 
-    rc = elerium_storage_load(KEY_PAIR_ID, &mod.key_pair, sizeof(mod.key_pair));
-    if (rc != 0) {
-        rc = elerium_crypto_generate(&mod.key_pair.priv, &mod.key_pair.pub);
+    struct url_fields fields;
+    size_t len = 0;
+
+    const char* data[ARRAY_SIZE(mod.template.segments)];
+    size_t data_len[ARRAY_SIZE(mod.template.segments)];
+
+    char* const sig = elerium_scratch_alloc(SIG_TEXT_SIZE);
+
+    rc = (sig != NULL) ? encode_fields(entry, &fields) : -ENOMEM;
+
+    if (rc == 0) {
+        rc = encode_sign(entry, sig, &fields);
+    }
 
+    for (size_t i = 0; (rc == 0) && (i < mod.template.count); ++i) {
+        data_len[i] = segment_data(&mod.template.segments[i], &fields, &data[i]);
+        len += data_len[i];
+    }
+
+    if (rc == 0) {
+        rc = elerium_nfc_ndef_url_begin(len);
+    }
+
+    if (rc == 0) {
+        for (size_t i = 0; (rc == 0) && (i < mod.template.count); ++i) {
+            rc = elerium_nfc_ndef_url_append(data[i], data_len[i]);
+        }
+
+        const int end_rc = elerium_nfc_ndef_url_end();
         if (rc == 0) {
-            rc = elerium_storage_save(KEY_PAIR_ID, &mod.key_pair, sizeof(mod.key_pair));
+            rc = end_rc;
         }
     }
 
     return rc;
 }
 
+int generate_url(void) {
+    int rc = 0;
+
+    struct url_sign_entry entry;
+
+    // Fall back to signing on the tap when the ring ran dry
+    if (!ring_pop(&entry)) {
+        rc = sign_entry(&entry);
+    }
+
+    if (rc == 0) {
+        rc = render_url(&entry);
+    }
+
+    return rc;
+}
+
+static void provision_work(struct k_work* work) {
+    ARG_UNUSED(work);
+
+    int rc;
+
+    bool enabled = false;
+    struct elerium_key_pair key_pair;
+
+    if (elerium_energy_defer(&mod.provision_work, ELERIUM_ENERGY_COST_KEYGEN)) {
+        return;
+    }
+
+    const uint32_t start = k_cycle_get_32();
+
+    rc = elerium_crypto_generate(&key_pair.priv, &key_pair.pub);
+
+    // Only a saved key is used, so a power loss here just repeats the work on the next boot
+    if (rc == 0) {
+        rc = elerium_storage_save(KEY_PAIR_ID, &key_pair, sizeof(key_pair));
+    }
+
+    if (rc == 0) {
+        elerium_subsys_provisioned(ELERIUM_SUBSYS_URL_SIGN,
+                                   k_cyc_to_us_floor32(k_cycle_get_32() - start));
+
+        k_mutex_lock(&mod.mut, K_FOREVER);
+
+        (void)memcpy(&mod.key_pair, &key_pair, sizeof(key_pair));
+        mod.key_ready = true;
+        enabled = mod.sign_data.enabled;
+
+        k_mutex_unlock(&mod.mut);
+    } else {
+        (void)elerium_worker_schedule(&mod.provision_work, PROVISION_RETRY);
+    }
+
+    (void)memset(&key_pair, 0x00, sizeof(key_pair));
+
+    if (enabled) {
+        elerium_worker_schedule(&mod.generate_work, K_NO_WAIT);
+    }
+}
+
+static void init_key(void) {
+    if (elerium_storage_load(KEY_PAIR_ID, &mod.key_pair, sizeof(mod.key_pair)) == 0) {
+        mod.key_ready = true;
+    } else {
+        (void)memset(&mod.key_pair, 0x00, sizeof(mod.key_pair));
+        (void)elerium_worker_schedule(&mod.provision_work, K_NO_WAIT);
+    }
+}
+
+static void init_uid(void) {
+    uint8_t uid[UID_MAX_SIZE];
+
+    const ssize_t size = hwinfo_get_device_id(uid, sizeof(uid));
+
+    mod.uid_len = 0;
+
+    if (size > 0) {
+        if (bin2hex(uid, size, mod.uid_hex, sizeof(mod.uid_hex)) != 0) {
+            mod.uid_len = size;
+        }
+    }
+}
+
 static void generate_work(struct k_work* work) {
     ARG_UNUSED(work);
 
     (void)elerium_url_sign_generate();
 }
 
+#if RING_DEPTH > 0
+static void refill_work(struct k_work* work) {
+    ARG_UNUSED(work);
+
+    bool more = false;
+    struct url_sign_entry entry;
+
+    if (elerium_energy_defer(&mod.refill_work, ELERIUM_ENERGY_COST_SIGN)) {
+        return;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    // One entry per run so a tap never waits behind more than one signature, and the supply is
+    // checked again before each
+    if (mod.sign_data.enabled && mod.key_ready && (mod.ring_count < ARRAY_SIZE(mod.ring))) {
+        if (sign_entry(&entry) == 0) {
+            const size_t tail = (mod.ring_head + mod.ring_count) % ARRAY_SIZE(mod.ring);
+
+            (void)memcpy(&mod.ring[tail], &entry, sizeof(entry));
+            ++mod.ring_count;
+
+            more = (mod.ring_count < ARRAY_SIZE(mod.ring));
+        }
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    if (more) {
+        (void)elerium_worker_schedule(&mod.refill_work, K_NO_WAIT);
+    }
+}
+#endif
+
 static void reset_work(struct k_work* work) {
     ARG_UNUSED(work);
 
@@ -251,31 +934,53 @@ static void reset_work(struct k_work* work) {
     k_mutex_unlock(&mod.mut);
 }
 
-int url_sign_init(void) {
+int elerium_url_sign_init(void) {
     int rc;
 
     k_mutex_init(&mod.mut);
 
     k_work_init_delayable(&mod.generate_work, &generate_work);
     k_work_init_delayable(&mod.reset_work, &reset_work);
+    k_work_init_delayable(&mod.provision_work, &provision_work);
+#if RING_DEPTH > 0
+    k_work_init_delayable(&mod.refill_work, &refill_work);
+#endif
 
-    rc = init_key();
+    init_uid();
 
-    if (rc == 0) {
+    // Skip whatever was left of the range reserved before the reset
+    if (elerium_storage_counter_load(COUNTER_ID, &mod.counter) != 0) {
+        mod.counter = 0;
+    }
+    mod.counter_limit = mod.counter;
 
-        rc = elerium_storage_load(URL_DATA_ID, &mod.sign_data, sizeof(mod.sign_data));
-        if (rc != 0) {
-            memset(&mod.sign_data, 0x00, sizeof(mod.sign_data));
+    rc = elerium_storage_load(URL_DATA_ID, &mod.sign_data, sizeof(mod.sign_data));
+    if (rc != 0) {
+        memset(&mod.sign_data, 0x00, sizeof(mod.sign_data));
+        mod.sign_data.enabled = false;
+    }
+
+    // Devices programmed before templates only stored the URL
+    if (mod.sign_data.enabled
+        && (elerium_storage_load(TEMPLATE_ID, &mod.template, sizeof(mod.template)) != 0)) {
+        if (template_compile(mod.sign_data.url, &mod.template) == 0) {
+            (void)elerium_storage_save(TEMPLATE_ID, &mod.template, sizeof(mod.template));
+        } else {
             mod.sign_data.enabled = false;
         }
+    }
 
-        rc = 0;
+    // A missing key is generated in the background, NFC comes up with the default URL
+    init_key();
 
-        if (mod.sign_data.enabled) {
-            (void)elerium_url_sign_generate();
-        } else {
-            (void)set_default_url();
-        }
+    rc = 0;
+
+    // The ring is RAM only, so the first URL after power-up is signed on the worker instead of
+    // holding up init, the tag keeps serving the previous URL until it lands
+    if (mod.sign_data.enabled && mod.key_ready) {
+        (void)elerium_worker_schedule(&mod.generate_work, K_NO_WAIT);
+    } else {
+        (void)set_default_url();
     }
 
     return rc;
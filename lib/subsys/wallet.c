@@ -3,29 +3,34 @@
 
 #include <string.h>
 
-#include <zephyr/drivers/flash.h>
-#include <zephyr/fs/nvs.h>
 #include <zephyr/kernel.h>
-#include <zephyr/random/random.h>
-#include <zephyr/storage/flash_map.h>
 
-#include <tinycrypt/constants.h>
-#include <tinycrypt/ctr_prng.h>
 #include <tinycrypt/ecc.h>
-#include <tinycrypt/ecc_dh.h>
-#include <tinycrypt/ecc_dsa.h>
-#include <tinycrypt/sha256.h>
-#include <tinycrypt/utils.h>
 
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+#include <wally_bip32.h>
+#include <wally_crypto.h>
+#endif
+
+#include "elerium/subsys/crypto.h"
+#include "elerium/subsys/energy.h"
+#include "elerium/subsys/storage.h"
+#include "elerium/subsys/subsys.h"
 #include "elerium/subsys/wallet.h"
+#include "elerium/subsys/worker.h"
 
 //***************************************************************************//
 
-#define NVS_PARTITION storage_partition
-#define NVS_PARTITION_DEVICE FIXED_PARTITION_DEVICE(NVS_PARTITION)
-#define NVS_PARTITION_OFFSET FIXED_PARTITION_OFFSET(NVS_PARTITION)
-
 #define WALLET_ID 0x2B01
+#define WALLET_VERSION 3
+
+#define PROVISION_RETRY K_MSEC(CONFIG_BEECHAT_ELERIUM_PROVISION_RETRY_MS)
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+#define BIP32_CACHE_SIZE CONFIG_BEECHAT_ELERIUM_WALLET_BIP32_CACHE_SIZE
+#define BIP32_CACHE_TAIL CONFIG_BEECHAT_ELERIUM_WALLET_BIP32_CACHE_TAIL
+#define BIP32_CACHE_TIMEOUT K_MSEC(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32_CACHE_TIMEOUT_MS)
+#endif
 
 //***************************************************************************//
 
@@ -33,30 +38,83 @@ struct elerium_wallet {
     uint8_t passcode_hash[32];
     uint8_t private_key[NUM_ECC_BYTES];
     uint8_t public_key[NUM_ECC_BYTES * 2];
+    // Version 2, generated on its own so no secret is shared between curves
+    uint8_t secp256k1_key[32];
+    // Version 3, the BIP32 master seed is its own secret as well
+    uint8_t bip32_seed[32];
 };
 
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+struct bip32_node {
+    bool valid;
+    uint8_t depth;
+    uint32_t last_used;
+    uint32_t path[ELERIUM_WALLET_BIP32_MAX_DEPTH];
+    struct ext_key key;
+};
+#endif
+
 //***************************************************************************//
 
-static int wallet_init(void);
+static bool key_empty(const uint8_t* key, size_t len);
 static int check_wallet(const struct elerium_wallet* wallet);
+static bool wallet_complete(const struct elerium_wallet* wallet);
+static int complete_wallet(struct elerium_wallet* wallet);
 static int load_wallet(struct elerium_wallet* wallet);
 static int save_wallet(const struct elerium_wallet* wallet);
+static int create_wallet(const uint8_t* passcode, uint8_t* seed);
+static void provision_work(struct k_work* work);
+static int wallet_ready(void);
+static int sign_path(const struct elerium_wallet* wallet,
+                     const uint32_t* path,
+                     size_t depth,
+                     const uint8_t* hash,
+                     size_t hash_length,
+                     uint8_t* signature,
+                     bool taproot);
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+static int derive_node(const struct elerium_wallet* wallet,
+                       const uint32_t* path,
+                       size_t depth,
+                       struct ext_key* node);
+static int derive_key(const struct elerium_wallet* wallet,
+                      const uint32_t* path,
+                      size_t depth,
+                      struct elerium_priv_key* priv_key);
+static void cache_wipe_work(struct k_work* work);
+#endif
 
 //***************************************************************************//
 
-// Kernel
-SYS_INIT(wallet_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+BUILD_ASSERT(sizeof(struct elerium_wallet) <= CONFIG_BEECHAT_ELERIUM_STORAGE_RECORD_SIZE);
 
-// Devices
+// The P-256 keys go through the crypto API, which boosts the clock for them
+BUILD_ASSERT(sizeof(struct elerium_priv_key) == NUM_ECC_BYTES);
+BUILD_ASSERT(sizeof(struct elerium_pub_key) == (NUM_ECC_BYTES * 2));
 
-static const char personalize[] = "elerium:wallet";
+// Versions only append fields, an older record is a prefix of the current layout
+static const size_t wallet_sizes[WALLET_VERSION + 1] = {
+    [1] = offsetof(struct elerium_wallet, secp256k1_key),
+    [2] = offsetof(struct elerium_wallet, bip32_seed),
+    [3] = sizeof(struct elerium_wallet),
+};
 
 // Module
 static struct {
     struct k_mutex mut;
 
-    struct nvs_fs fs;
     struct elerium_wallet wallet;
+
+    // Set once the wallet was loaded or generated in the background
+    atomic_t ready;
+    struct k_work_delayable provision_work;
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    uint32_t cache_clock;
+    struct bip32_node cache[BIP32_CACHE_SIZE];
+    struct k_work_delayable cache_wipe_work;
+#endif
 } mod;
 
 //***************************************************************************//
@@ -64,6 +122,18 @@ static struct {
 int elerium_wallet_create(const uint8_t* passcode, uint8_t* seed) {
     int rc;
 
+    rc = wallet_ready();
+
+    if (rc == 0) {
+        rc = create_wallet(passcode, seed);
+    }
+
+    return rc;
+}
+
+int create_wallet(const uint8_t* passcode, uint8_t* seed) {
+    int rc;
+
     rc = check_wallet(&mod.wallet);
     if (rc == 0) {
         return -EBUSY;
@@ -71,13 +141,10 @@ int elerium_wallet_create(const uint8_t* passcode, uint8_t* seed) {
 
     memset(&mod.wallet, 0x00, sizeof(mod.wallet));
 
-    rc = uECC_make_key(mod.wallet.public_key, mod.wallet.private_key, uECC_secp256r1());
-    if (rc == TC_CRYPTO_SUCCESS) {
-        rc = 0;
-    }
+    rc = complete_wallet(&mod.wallet);
 
     if (rc == 0) {
-        rc = save_wallet(&mod.wallet) < 0 ? -1 : 0;
+        rc = save_wallet(&mod.wallet);
     }
 
     if (rc == 0 && seed != NULL) {
@@ -88,34 +155,54 @@ int elerium_wallet_create(const uint8_t* passcode, uint8_t* seed) {
 }
 
 int elerium_wallet_seed(const uint8_t* passcode, uint8_t* hash) {
-    int rc = 0;
-    struct tc_sha256_state_struct sha256_ctx;
+    int rc;
+    struct elerium_sha256_ctx sha256_ctx;
 
-    if (tc_sha256_init(&sha256_ctx) != TC_CRYPTO_SUCCESS) {
-        rc = -EINVAL;
+    rc = wallet_ready();
+    if (rc != 0) {
+        return rc;
     }
 
+    rc = elerium_crypto_sha256_init(&sha256_ctx);
+
     if (rc == 0) {
-        if (tc_sha256_update(&sha256_ctx, mod.wallet.private_key, sizeof(mod.wallet.private_key))
-            != TC_CRYPTO_SUCCESS) {
-            rc = -EINVAL;
-        }
+        rc = elerium_crypto_sha256_update(
+            &sha256_ctx, mod.wallet.private_key, sizeof(mod.wallet.private_key));
     }
 
     if (rc == 0) {
-        if (tc_sha256_final(hash, &sha256_ctx) != TC_CRYPTO_SUCCESS) {
-            rc = -EINVAL;
-        }
+        rc = elerium_crypto_sha256_final(&sha256_ctx, (struct elerium_hash*)hash);
     }
 
     return rc;
 }
 
 int elerium_wallet_destroy(void) {
+    int rc;
+
+    rc = wallet_ready();
+    if (rc != 0) {
+        return rc;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    // Commands see a wallet that is not ready instead of zero keys
+    atomic_clear(&mod.ready);
 
     (void)memset(&mod.wallet, 0x00, sizeof(mod.wallet));
 
-    nvs_delete(&mod.fs, WALLET_ID);
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    (void)memset(mod.cache, 0x00, sizeof(mod.cache));
+    (void)k_work_cancel_delayable(&mod.cache_wipe_work);
+#endif
+
+    (void)elerium_storage_delete(WALLET_ID);
+
+    k_mutex_unlock(&mod.mut);
+
+    // A new wallet is generated in the background, as on first boot
+    (void)elerium_worker_schedule(&mod.provision_work, K_NO_WAIT);
 
     return 0;
 }
@@ -125,69 +212,495 @@ struct elerium_wallet* elerium_wallet_get(const uint8_t* passcode) {
 }
 
 int elerium_wallet_sign(const struct elerium_wallet* wallet,
+                        enum elerium_crypto_curve curve,
                         const uint8_t* hash,
                         size_t hash_length,
                         uint8_t* signature) {
     int rc;
 
-    rc = uECC_sign(wallet->private_key, hash, hash_length, signature, uECC_secp256r1());
+    rc = wallet_ready();
+    if (rc != 0) {
+        return rc;
+    }
 
-    if (rc == TC_CRYPTO_SUCCESS) {
-        rc = 0;
-    } else {
-        rc = -EINVAL;
+    switch (curve) {
+        case ELERIUM_CRYPTO_CURVE_SECP256R1:
+            rc = elerium_crypto_sign((struct elerium_priv_key*)wallet->private_key,
+                                     hash,
+                                     hash_length,
+                                     (struct elerium_signature*)signature);
+            break;
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_CRYPTO_SECP256K1)
+        case ELERIUM_CRYPTO_CURVE_SECP256K1:
+            rc = elerium_crypto_secp256k1_sign(
+                (const struct elerium_priv_key*)wallet->secp256k1_key,
+                hash,
+                hash_length,
+                (struct elerium_signature*)signature);
+            break;
+#endif
+
+        default:
+            rc = -ENOTSUP;
+            break;
     }
 
     return rc;
 }
 
+int elerium_wallet_sign_path(const struct elerium_wallet* wallet,
+                             const uint32_t* path,
+                             size_t depth,
+                             const uint8_t* hash,
+                             size_t hash_length,
+                             uint8_t* signature) {
+    return sign_path(wallet, path, depth, hash, hash_length, signature, false);
+}
+
+int elerium_wallet_sign_path_taproot(const struct elerium_wallet* wallet,
+                                     const uint32_t* path,
+                                     size_t depth,
+                                     const uint8_t* hash,
+                                     size_t hash_length,
+                                     uint8_t* signature) {
+    return sign_path(wallet, path, depth, hash, hash_length, signature, true);
+}
+
+int elerium_wallet_fingerprint(const struct elerium_wallet* wallet, uint8_t* fingerprint) {
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    int rc;
+
+    __ASSERT_NO_MSG(wallet != NULL);
+    __ASSERT_NO_MSG(fingerprint != NULL);
+
+    struct ext_key master;
+    uint8_t hash160[ELERIUM_WALLET_HASH160_SIZE];
+
+    rc = wallet_ready();
+
+    if (rc == 0) {
+        rc = derive_node(wallet, NULL, 0, &master);
+    }
+
+    if (rc == 0) {
+        rc = wally_hash160(master.pub_key, sizeof(master.pub_key), hash160, sizeof(hash160));
+        rc = (rc == WALLY_OK) ? 0 : -EFAULT;
+    }
+
+    if (rc == 0) {
+        (void)memcpy(fingerprint, hash160, ELERIUM_WALLET_FINGERPRINT_SIZE);
+    }
+
+    (void)memset(&master, 0x00, sizeof(master));
+
+    return rc;
+#else
+    ARG_UNUSED(wallet);
+    ARG_UNUSED(fingerprint);
+
+    return -ENOTSUP;
+#endif
+}
+
+int elerium_wallet_path_pub(const struct elerium_wallet* wallet,
+                            const uint32_t* path,
+                            size_t depth,
+                            uint8_t* pub_key,
+                            uint8_t* hash160) {
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    int rc;
+
+    __ASSERT_NO_MSG(wallet != NULL);
+    __ASSERT_NO_MSG((path != NULL) || (depth == 0));
+    __ASSERT_NO_MSG(pub_key != NULL);
+
+    struct ext_key node;
+
+    rc = wallet_ready();
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (depth > ELERIUM_WALLET_BIP32_MAX_DEPTH) {
+        return -EINVAL;
+    }
+
+    rc = derive_node(wallet, path, depth, &node);
+
+    if (rc == 0) {
+        (void)memcpy(pub_key, node.pub_key, ELERIUM_WALLET_PUB_KEY_SIZE);
+    }
+
+    if ((rc == 0) && (hash160 != NULL)) {
+        rc = wally_hash160(
+            node.pub_key, sizeof(node.pub_key), hash160, ELERIUM_WALLET_HASH160_SIZE);
+        rc = (rc == WALLY_OK) ? 0 : -EFAULT;
+    }
+
+    (void)memset(&node, 0x00, sizeof(node));
+
+    return rc;
+#else
+    ARG_UNUSED(wallet);
+    ARG_UNUSED(path);
+    ARG_UNUSED(depth);
+    ARG_UNUSED(pub_key);
+    ARG_UNUSED(hash160);
+
+    return -ENOTSUP;
+#endif
+}
+
+void elerium_wallet_cache_wipe(void) {
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    // Nothing is cached before the wallet is ready, and a lazy wallet may not be started yet
+    if (!atomic_get(&mod.ready)) {
+        return;
+    }
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    (void)memset(mod.cache, 0x00, sizeof(mod.cache));
+
+    k_mutex_unlock(&mod.mut);
+
+    (void)k_work_cancel_delayable(&mod.cache_wipe_work);
+#endif
+}
+
 //***************************************************************************//
 
-int check_wallet(const struct elerium_wallet* wallet) {
-    int rc = -EINVAL;
+int sign_path(const struct elerium_wallet* wallet,
+              const uint32_t* path,
+              size_t depth,
+              const uint8_t* hash,
+              size_t hash_length,
+              uint8_t* signature,
+              bool taproot) {
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    int rc;
 
-    for (size_t i = 0; i < sizeof(wallet->private_key); ++i) {
-        if (wallet->private_key[i] != 0) {
-            rc = 0;
-            break;
+    __ASSERT_NO_MSG(wallet != NULL);
+    __ASSERT_NO_MSG((path != NULL) || (depth == 0));
+
+    struct elerium_priv_key priv_key;
+
+    rc = wallet_ready();
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (depth > ELERIUM_WALLET_BIP32_MAX_DEPTH) {
+        return -EINVAL;
+    }
+
+    rc = derive_key(wallet, path, depth, &priv_key);
+
+    if ((rc == 0) && taproot) {
+        rc = elerium_crypto_secp256k1_sign_taproot(
+            &priv_key, hash, hash_length, (struct elerium_signature*)signature);
+    } else if (rc == 0) {
+        rc = elerium_crypto_secp256k1_sign(
+            &priv_key, hash, hash_length, (struct elerium_signature*)signature);
+    }
+
+    (void)memset(&priv_key, 0x00, sizeof(priv_key));
+
+    return rc;
+#else
+    ARG_UNUSED(wallet);
+    ARG_UNUSED(path);
+    ARG_UNUSED(depth);
+    ARG_UNUSED(hash);
+    ARG_UNUSED(hash_length);
+    ARG_UNUSED(signature);
+    ARG_UNUSED(taproot);
+
+    return -ENOTSUP;
+#endif
+}
+
+bool key_empty(const uint8_t* key, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (key[i] != 0) {
+            return false;
         }
     }
 
+    return true;
+}
+
+int check_wallet(const struct elerium_wallet* wallet) {
+    return key_empty(wallet->private_key, sizeof(wallet->private_key)) ? -EINVAL : 0;
+}
+
+bool wallet_complete(const struct elerium_wallet* wallet) {
+    bool complete = !key_empty(wallet->private_key, sizeof(wallet->private_key));
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_CRYPTO_SECP256K1)
+    complete = complete && !key_empty(wallet->secp256k1_key, sizeof(wallet->secp256k1_key));
+#endif
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    complete = complete && !key_empty(wallet->bip32_seed, sizeof(wallet->bip32_seed));
+#endif
+
+    return complete;
+}
+
+// Generates the keys still missing, a migrated wallet keeps the ones it already has
+int complete_wallet(struct elerium_wallet* wallet) {
+    int rc = 0;
+
+    if (key_empty(wallet->private_key, sizeof(wallet->private_key))) {
+        rc = elerium_crypto_generate((struct elerium_priv_key*)wallet->private_key,
+                                     (struct elerium_pub_key*)wallet->public_key);
+    }
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_CRYPTO_SECP256K1)
+    if ((rc == 0) && key_empty(wallet->secp256k1_key, sizeof(wallet->secp256k1_key))) {
+        rc = elerium_crypto_secp256k1_generate((struct elerium_priv_key*)wallet->secp256k1_key);
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    if ((rc == 0) && key_empty(wallet->bip32_seed, sizeof(wallet->bip32_seed))) {
+        rc = elerium_crypto_random_fill(wallet->bip32_seed, sizeof(wallet->bip32_seed));
+    }
+#endif
+
     return rc;
 }
 
 int load_wallet(struct elerium_wallet* wallet) {
-    return nvs_read(&mod.fs, WALLET_ID, wallet, sizeof(*wallet));
+    uint8_t version;
+
+    (void)memset(wallet, 0x00, sizeof(*wallet));
+
+    const ssize_t len = elerium_storage_load_record(WALLET_ID, &version, wallet, sizeof(*wallet));
+    if (len < 0) {
+        return (int)len;
+    }
+
+    // Fields added after the record was written stay zero until provisioning fills them
+    if ((version == 0) || (version > WALLET_VERSION) || (len != wallet_sizes[version])) {
+        (void)memset(wallet, 0x00, sizeof(*wallet));
+        return -EINVAL;
+    }
+
+    return 0;
 }
 
 int save_wallet(const struct elerium_wallet* wallet) {
-    return nvs_write(&mod.fs, WALLET_ID, wallet, sizeof(*wallet));
+    return elerium_storage_save_record(WALLET_ID, WALLET_VERSION, wallet, sizeof(*wallet));
 }
 
-int wallet_init(void) {
-    int rc;
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+static struct bip32_node* cache_lookup(const uint32_t* path, size_t depth) {
+    struct bip32_node* best = NULL;
 
-    sys_rand_get(mod.entropy, sizeof(mod.entropy));
+    for (size_t i = 0; i < ARRAY_SIZE(mod.cache); ++i) {
+        struct bip32_node* node = &mod.cache[i];
 
-    rc = init_nvs();
+        if (!node->valid || (node->depth > depth)) {
+            continue;
+        }
 
-    if (rc == 0) {
+        if (memcmp(node->path, path, node->depth * sizeof(path[0])) != 0) {
+            continue;
+        }
 
-        rc = tc_ctr_prng_init(
-            &mod.prng, mod.entropy, sizeof(mod.entropy), personalize, sizeof(personalize));
+        if ((best == NULL) || (node->depth > best->depth)) {
+            best = node;
+        }
+    }
+
+    if (best != NULL) {
+        best->last_used = ++mod.cache_clock;
+    }
+
+    return best;
+}
+
+static struct bip32_node* cache_insert(const uint32_t* path,
+                                       size_t depth,
+                                       const struct ext_key* key) {
+    struct bip32_node* victim = &mod.cache[0];
+
+    for (size_t i = 0; i < ARRAY_SIZE(mod.cache); ++i) {
+        if (!mod.cache[i].valid) {
+            victim = &mod.cache[i];
+            break;
+        }
 
-        if (rc == TC_CRYPTO_SUCCESS) {
-            rc = 0;
+        if (mod.cache[i].last_used < victim->last_used) {
+            victim = &mod.cache[i];
         }
     }
 
-    // elerium_wallet_destroy();
+    (void)memset(victim, 0x00, sizeof(*victim));
 
-    if (load_wallet(&mod.wallet) < 0) {
-        elerium_wallet_create("", NULL);
+    victim->valid = true;
+    victim->depth = depth;
+    victim->last_used = ++mod.cache_clock;
+    (void)memcpy(victim->path, path, depth * sizeof(path[0]));
+    (void)memcpy(&victim->key, key, sizeof(*key));
+
+    return victim;
+}
+
+int derive_node(const struct elerium_wallet* wallet,
+                const uint32_t* path,
+                size_t depth,
+                struct ext_key* node) {
+    int rc = WALLY_OK;
+
+    struct ext_key base;
+    size_t base_depth = 0;
+
+    const size_t cache_depth = (depth > BIP32_CACHE_TAIL) ? (depth - BIP32_CACHE_TAIL) : 0;
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    const struct bip32_node* cached = cache_lookup(path, depth);
+
+    if (cached != NULL) {
+        (void)memcpy(&base, &cached->key, sizeof(base));
+        base_depth = cached->depth;
+    } else {
+        rc = bip32_key_from_seed(wallet->bip32_seed,
+                                 sizeof(wallet->bip32_seed),
+                                 BIP32_VER_MAIN_PRIVATE,
+                                 BIP32_FLAG_SKIP_HASH,
+                                 &base);
+    }
+
+    // Keep the intermediate node so siblings only pay for the tail
+    if ((rc == WALLY_OK) && (base_depth < cache_depth)) {
+        rc = bip32_key_from_parent_path(&base,
+                                        &path[base_depth],
+                                        cache_depth - base_depth,
+                                        BIP32_FLAG_KEY_PRIVATE | BIP32_FLAG_SKIP_HASH,
+                                        node);
+
+        if (rc == WALLY_OK) {
+            (void)cache_insert(path, cache_depth, node);
+            (void)memcpy(&base, node, sizeof(base));
+            base_depth = cache_depth;
+        }
     }
 
+    if ((rc == WALLY_OK) && (base_depth < depth)) {
+        rc = bip32_key_from_parent_path(&base,
+                                        &path[base_depth],
+                                        depth - base_depth,
+                                        BIP32_FLAG_KEY_PRIVATE | BIP32_FLAG_SKIP_HASH,
+                                        node);
+    } else if (rc == WALLY_OK) {
+        (void)memcpy(node, &base, sizeof(*node));
+    }
+
+    k_mutex_unlock(&mod.mut);
+
+    if (rc == WALLY_OK) {
+        (void)k_work_reschedule(&mod.cache_wipe_work, BIP32_CACHE_TIMEOUT);
+    }
+
+    (void)memset(&base, 0x00, sizeof(base));
+
+    return (rc == WALLY_OK) ? 0 : -EINVAL;
+}
+
+int derive_key(const struct elerium_wallet* wallet,
+               const uint32_t* path,
+               size_t depth,
+               struct elerium_priv_key* priv_key) {
+    int rc;
+
+    struct ext_key node;
+
+    rc = derive_node(wallet, path, depth, &node);
+
+    if (rc == 0) {
+        // Skip the leading zero byte of the serialized private key
+        (void)memcpy(priv_key->data, &node.priv_key[1], sizeof(priv_key->data));
+    }
+
+    (void)memset(&node, 0x00, sizeof(node));
+
     return rc;
 }
 
+void cache_wipe_work(struct k_work* work) {
+    ARG_UNUSED(work);
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+
+    (void)memset(mod.cache, 0x00, sizeof(mod.cache));
+
+    k_mutex_unlock(&mod.mut);
+}
+#endif
+
+// Starts the wallet on first use, then waits for background provisioning
+int wallet_ready(void) {
+    int rc;
+
+    rc = elerium_subsys_require(ELERIUM_SUBSYS_WALLET);
+
+    if ((rc == 0) && !atomic_get(&mod.ready)) {
+        rc = -EINPROGRESS;
+    }
+
+    return rc;
+}
+
+void provision_work(struct k_work* work) {
+    ARG_UNUSED(work);
+
+    if (elerium_energy_defer(&mod.provision_work, ELERIUM_ENERGY_COST_KEYGEN)) {
+        return;
+    }
+
+    const uint32_t start = k_cycle_get_32();
+
+    // Nothing is served from the wallet until it is saved, a power loss restarts from scratch
+    int rc = complete_wallet(&mod.wallet);
+
+    if (rc == 0) {
+        rc = save_wallet(&mod.wallet);
+    }
+
+    if (rc == 0) {
+        elerium_subsys_provisioned(ELERIUM_SUBSYS_WALLET,
+                                   k_cyc_to_us_floor32(k_cycle_get_32() - start));
+        atomic_set(&mod.ready, 1);
+    } else {
+        (void)elerium_worker_schedule(&mod.provision_work, PROVISION_RETRY);
+    }
+}
+
+int elerium_wallet_init(void) {
+    k_mutex_init(&mod.mut);
+
+    k_work_init_delayable(&mod.provision_work, &provision_work);
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_WALLET_BIP32)
+    k_work_init_delayable(&mod.cache_wipe_work, &cache_wipe_work);
+#endif
+
+    // Key generation runs in the background so NFC is ready right after boot, an older record
+    // only gains the keys it lacks
+    (void)load_wallet(&mod.wallet);
+
+    if (wallet_complete(&mod.wallet)) {
+        atomic_set(&mod.ready, 1);
+    } else {
+        (void)elerium_worker_schedule(&mod.provision_work, K_NO_WAIT);
+    }
+
+    return 0;
+}
+
 //***************************************************************************//
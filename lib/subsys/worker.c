@@ -0,0 +1,53 @@
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+#include "elerium/subsys/worker.h"
+
+//***************************************************************************//
+
+#define WORKER_STACK_SIZE CONFIG_BEECHAT_ELERIUM_WORKER_STACK_SIZE
+#define WORKER_PRIORITY CONFIG_BEECHAT_ELERIUM_WORKER_PRIORITY
+
+//***************************************************************************//
+
+static int worker_init(void);
+
+//***************************************************************************//
+
+// Kernel
+SYS_INIT(worker_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+K_THREAD_STACK_DEFINE(worker_stack, WORKER_STACK_SIZE);
+
+// Module
+static struct {
+    struct k_work_q queue;
+} mod;
+
+//***************************************************************************//
+
+int elerium_worker_schedule(struct k_work_delayable* work, k_timeout_t delay) {
+    return k_work_schedule_for_queue(&mod.queue, work, delay);
+}
+
+int elerium_worker_reschedule(struct k_work_delayable* work, k_timeout_t delay) {
+    return k_work_reschedule_for_queue(&mod.queue, work, delay);
+}
+
+//***************************************************************************//
+
+int worker_init(void) {
+    const struct k_work_queue_config config = {
+        .name = "elerium_worker",
+    };
+
+    k_work_queue_init(&mod.queue);
+    k_work_queue_start(
+        &mod.queue, worker_stack, K_THREAD_STACK_SIZEOF(worker_stack), WORKER_PRIORITY, &config);
+
+    return 0;
+}
+
+//***************************************************************************//
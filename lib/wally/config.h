@@ -0,0 +1,20 @@
+#ifndef ELERIUM_WALLY_CONFIG_H_
+#define ELERIUM_WALLY_CONFIG_H_
+
+//***************************************************************************//
+
+// Hand written replacement for the autotools config.h of libwally-core
+
+#define HAVE_BUILTIN_TYPES_COMPATIBLE_P 1
+#define HAVE_TYPEOF 1
+#define HAVE_LITTLE_ENDIAN 1
+#define HAVE_BIG_ENDIAN 0
+#define HAVE_BYTESWAP_H 0
+#define HAVE_BSWAP_64 0
+#define HAVE_UNALIGNED_ACCESS 0
+#define HAVE_MMAP 0
+#define HAVE_POSIX_MEMALIGN 0
+
+//***************************************************************************//
+
+#endif // ELERIUM_WALLY_CONFIG_H_
@@ -0,0 +1,140 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "mocks.h"
+
+// Built into the test so each case starts from a fresh governor
+#include "clock.c"
+
+//***************************************************************************//
+
+#define TEST_WEAK_MV (CONFIG_BEECHAT_ELERIUM_CLOCK_BOOST_MV - 1)
+
+//***************************************************************************//
+
+static void clock_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    mock_clock_reset();
+    mock_energy_reset();
+
+    (void)memset(&mod, 0x00, sizeof(mod));
+    zassert_ok(clock_init());
+}
+
+ZTEST_SUITE(clock, NULL, NULL, clock_before, NULL, NULL);
+
+//***************************************************************************//
+
+static void check_stats(uint32_t boosts, uint32_t denied, uint32_t failed) {
+    struct elerium_clock_stats stats;
+
+    zassert_ok(elerium_clock_stats(&stats));
+
+    zassert_equal(stats.boosts, boosts);
+    zassert_equal(stats.denied, denied);
+    zassert_equal(stats.failed, failed);
+}
+
+ZTEST(clock, test_nested_bursts_share_one_boost) {
+    elerium_clock_boost_begin();
+    elerium_clock_boost_begin();
+
+    zassert_equal(mock_clock.level, ELERIUM_CLOCK_LEVEL_BOOST);
+
+    elerium_clock_boost_end();
+
+    zassert_equal(mock_clock.level, ELERIUM_CLOCK_LEVEL_BOOST);
+
+    elerium_clock_boost_end();
+
+    zassert_equal(mock_clock.level, ELERIUM_CLOCK_LEVEL_LOW);
+    zassert_equal(mock_clock.switches, 2);
+
+    check_stats(1, 0, 0);
+}
+
+ZTEST(clock, test_boost_time_counted) {
+    struct elerium_clock_stats stats;
+
+    elerium_clock_boost_begin();
+    k_sleep(K_MSEC(20));
+    elerium_clock_boost_end();
+
+    zassert_ok(elerium_clock_stats(&stats));
+    zassert_true(stats.boost_ms >= 20, "%u ms", stats.boost_ms);
+}
+
+ZTEST(clock, test_weak_supply_denied) {
+    mock_energy.supply_mv = TEST_WEAK_MV;
+
+    elerium_clock_boost_begin();
+
+    // The supply recovering mid burst does not boost it
+    mock_energy.supply_mv = CONFIG_BEECHAT_ELERIUM_CLOCK_BOOST_MV;
+
+    elerium_clock_boost_begin();
+    elerium_clock_boost_end();
+    elerium_clock_boost_end();
+
+    zassert_equal(mock_clock.switches, 0);
+    check_stats(0, 1, 0);
+
+    // The next burst samples again
+    elerium_clock_boost_begin();
+
+    zassert_equal(mock_clock.level, ELERIUM_CLOCK_LEVEL_BOOST);
+
+    elerium_clock_boost_end();
+
+    check_stats(1, 1, 0);
+}
+
+ZTEST(clock, test_unknown_supply_boosts) {
+    mock_energy.supply_mv = 0;
+
+    elerium_clock_boost_begin();
+
+    zassert_equal(mock_clock.level, ELERIUM_CLOCK_LEVEL_BOOST);
+
+    elerium_clock_boost_end();
+
+    check_stats(1, 0, 0);
+}
+
+ZTEST(clock, test_failed_boost_stays_low) {
+    mock_clock.switch_rc = -EIO;
+
+    elerium_clock_boost_begin();
+    elerium_clock_boost_end();
+
+    // No switch back is attempted for a boost that never happened
+    zassert_equal(mock_clock.level, ELERIUM_CLOCK_LEVEL_LOW);
+    zassert_equal(mock_clock.switches, 1);
+
+    check_stats(0, 0, 1);
+}
+
+ZTEST(clock, test_failed_restore_counted) {
+    elerium_clock_boost_begin();
+
+    mock_clock.switch_rc = -EIO;
+
+    elerium_clock_boost_end();
+
+    check_stats(1, 0, 1);
+
+    // The governor does not retry, the next burst boosts from whatever runs
+    mock_clock.switch_rc = 0;
+
+    elerium_clock_boost_begin();
+    elerium_clock_boost_end();
+
+    zassert_equal(mock_clock.level, ELERIUM_CLOCK_LEVEL_LOW);
+    check_stats(2, 0, 1);
+}
+
+//***************************************************************************//
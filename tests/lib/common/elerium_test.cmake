@@ -0,0 +1,21 @@
+# Included by the tests under tests/lib after find_package(Zephyr)
+
+set(ELERIUM_ROOT ${CMAKE_CURRENT_LIST_DIR}/../../..)
+set(ELERIUM_TEST_COMMON ${CMAKE_CURRENT_LIST_DIR})
+
+target_include_directories(
+    app
+
+    PRIVATE
+        ${ELERIUM_ROOT}/include
+        ${ELERIUM_ROOT}/lib/subsys
+        ${ELERIUM_ROOT}/tests/vectors
+        ${ELERIUM_TEST_COMMON}/include
+)
+
+# Links the named mocks from common/src, a test leaves out the modules it builds for real
+function(elerium_test_mocks)
+    foreach(mock ${ARGN})
+        target_sources(app PRIVATE ${ELERIUM_TEST_COMMON}/src/mock_${mock}.c)
+    endforeach()
+endfunction()
@@ -0,0 +1,112 @@
+#ifndef ELERIUM_TESTS_MOCKS_H_
+#define ELERIUM_TESTS_MOCKS_H_
+
+//***************************************************************************//
+
+#include <zephyr/kernel.h>
+
+#include "elerium/subsys/clock.h"
+#include "elerium/subsys/nfc.h"
+#include "elerium/subsys/wallet.h"
+
+//***************************************************************************//
+
+/// @brief mock_clock_backend.c, fake clock tree
+struct mock_clock {
+    enum elerium_clock_level level;
+    size_t switches;
+    // Returned by the next switches, the level only changes on success
+    int switch_rc;
+};
+
+/// @brief mock_energy.c, fake supply sensor
+struct mock_energy {
+    // 0 for an unknown supply
+    uint16_t supply_mv;
+    size_t defers;
+};
+
+/// @brief mock_nfc.c, last URL streamed into the NDEF record
+struct mock_ndef {
+    char url[ELERIUM_NFC_NDEF_URL_MAX_LEN + 1];
+    size_t len;
+    size_t expected_len;
+};
+
+/// @brief mock_storage_backend.c, RAM backend, every write and delete either lands whole or not
+struct mock_flash {
+    // Writes and deletes that still land before the power is cut, negative for no limit
+    int writes_left;
+    size_t writes;
+
+    ssize_t sector_free;
+    size_t sector_next_calls;
+    // Writes that had landed when the sector was last changed
+    size_t sector_next_at;
+
+    // Time a write and a sector erase take
+    uint32_t write_us;
+    uint32_t erase_us;
+};
+
+/// @brief mock_storage_ecc.c, double ECC errors of the flash simulator
+struct mock_ecc {
+    // Reads covering it fail, negative for none
+    off_t torn_offset;
+    size_t errors;
+};
+
+/// @brief mock_worker.c, jobs are recorded and only run when a test runs them
+struct mock_worker {
+    size_t scheduled;
+    struct k_work_delayable* last;
+};
+
+/// @brief mock_wallet.c, one key for every path, signing records the hash
+struct mock_wallet {
+    uint8_t fingerprint[ELERIUM_WALLET_FINGERPRINT_SIZE];
+    uint8_t pub_key[ELERIUM_WALLET_PUB_KEY_SIZE];
+    uint8_t hash160[ELERIUM_WALLET_HASH160_SIZE];
+
+    // Last path derived, a signature for any other path fails
+    uint32_t path[ELERIUM_WALLET_BIP32_MAX_DEPTH];
+    size_t depth;
+
+    size_t signs;
+    bool taproot;
+    uint8_t hash[32];
+};
+
+extern struct mock_clock mock_clock;
+extern struct mock_energy mock_energy;
+extern struct mock_ndef mock_ndef;
+extern struct mock_flash mock_flash;
+extern struct mock_ecc mock_ecc;
+extern struct mock_worker mock_worker;
+extern struct mock_wallet mock_wallet;
+
+//***************************************************************************//
+
+/// @brief Low clock, working backend
+void mock_clock_reset(void);
+
+/// @brief Full supply, nothing deferred
+void mock_energy_reset(void);
+
+/// @brief Erases every record and restores the power
+void mock_flash_reset(void);
+
+/// @brief No torn word
+void mock_ecc_reset(void);
+
+void mock_worker_reset(void);
+
+/// @brief Runs the last scheduled job on the calling thread
+void mock_worker_run(void);
+
+/// @brief Zero fingerprint and key, nothing signed
+void mock_wallet_reset(void);
+
+//***************************************************************************//
+
+#endif // ELERIUM_TESTS_MOCKS_H_
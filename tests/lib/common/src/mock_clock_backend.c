@@ -0,0 +1,30 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include "clock_backend.h"
+#include "mocks.h"
+
+//***************************************************************************//
+
+struct mock_clock mock_clock;
+
+//***************************************************************************//
+
+void mock_clock_reset(void) {
+    (void)memset(&mock_clock, 0x00, sizeof(mock_clock));
+
+    mock_clock.level = ELERIUM_CLOCK_LEVEL_LOW;
+}
+
+int clock_backend_set(enum elerium_clock_level level) {
+    ++mock_clock.switches;
+
+    if (mock_clock.switch_rc == 0) {
+        mock_clock.level = level;
+    }
+
+    return mock_clock.switch_rc;
+}
+
+//***************************************************************************//
@@ -0,0 +1,33 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include "elerium/subsys/energy.h"
+
+#include "mocks.h"
+
+//***************************************************************************//
+
+struct mock_energy mock_energy;
+
+//***************************************************************************//
+
+void mock_energy_reset(void) {
+    (void)memset(&mock_energy, 0x00, sizeof(mock_energy));
+
+    mock_energy.supply_mv = 3300;
+}
+
+uint16_t elerium_energy_supply_mv(void) {
+    return mock_energy.supply_mv;
+}
+
+// Every job is admitted, energy.c has its own test
+bool elerium_energy_defer(struct k_work_delayable* work, enum elerium_energy_cost cost) {
+    ARG_UNUSED(work);
+    ARG_UNUSED(cost);
+
+    return false;
+}
+
+//***************************************************************************//
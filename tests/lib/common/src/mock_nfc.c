@@ -0,0 +1,53 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include "elerium/subsys/nfc.h"
+
+#include "mocks.h"
+
+//***************************************************************************//
+
+struct mock_ndef mock_ndef;
+
+//***************************************************************************//
+
+int elerium_nfc_ndef_url_begin(size_t url_len) {
+    if (url_len > ELERIUM_NFC_NDEF_URL_MAX_LEN) {
+        return -EMSGSIZE;
+    }
+
+    (void)memset(&mock_ndef, 0x00, sizeof(mock_ndef));
+    mock_ndef.expected_len = url_len;
+
+    return 0;
+}
+
+int elerium_nfc_ndef_url_append(const char* data, size_t len) {
+    if (len > (mock_ndef.expected_len - mock_ndef.len)) {
+        return -EMSGSIZE;
+    }
+
+    (void)memcpy(&mock_ndef.url[mock_ndef.len], data, len);
+    mock_ndef.len += len;
+
+    return 0;
+}
+
+int elerium_nfc_ndef_url_end(void) {
+    return (mock_ndef.len == mock_ndef.expected_len) ? 0 : -EIO;
+}
+
+int elerium_nfc_set_ndef_url(const char* url, size_t url_len) {
+    int rc;
+
+    rc = elerium_nfc_ndef_url_begin(url_len);
+
+    if (rc == 0) {
+        rc = elerium_nfc_ndef_url_append(url, url_len);
+    }
+
+    return (rc == 0) ? elerium_nfc_ndef_url_end() : rc;
+}
+
+//***************************************************************************//
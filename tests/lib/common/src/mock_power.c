@@ -0,0 +1,17 @@
+//***************************************************************************//
+
+#include "elerium/subsys/power.h"
+
+//***************************************************************************//
+
+void elerium_power_stop_lock_get(void) {
+}
+
+void elerium_power_stop_lock_put(void) {
+}
+
+void elerium_power_wake_event(uint32_t irq_cycle) {
+    ARG_UNUSED(irq_cycle);
+}
+
+//***************************************************************************//
@@ -0,0 +1,42 @@
+//***************************************************************************//
+
+#include "elerium/subsys/storage.h"
+
+//***************************************************************************//
+
+// Nothing is persisted, every record reads as missing
+int elerium_storage_load(uint16_t key, void* data, size_t len) {
+    return -ENOENT;
+}
+
+int elerium_storage_save(uint16_t key, const void* data, size_t len) {
+    return 0;
+}
+
+int elerium_storage_counter_load(uint16_t key, uint32_t* value) {
+    *value = 0;
+
+    return 0;
+}
+
+int elerium_storage_counter_save(uint16_t key, uint32_t value) {
+    return 0;
+}
+
+int elerium_storage_txn_begin(void) {
+    return 0;
+}
+
+int elerium_storage_txn_put(uint16_t key, const void* data, size_t len) {
+    return 0;
+}
+
+int elerium_storage_txn_delete(uint16_t key) {
+    return 0;
+}
+
+int elerium_storage_txn_commit(void) {
+    return 0;
+}
+
+//***************************************************************************//
@@ -0,0 +1,162 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include "mocks.h"
+#include "storage_backend.h"
+
+//***************************************************************************//
+
+#define MOCK_RECORDS 8
+#define MOCK_RECORD_SIZE 768
+#define MOCK_SECTOR_SIZE 2048
+#define MOCK_ATE_SIZE 8
+
+// Busy waits, native_sim time only moves when the simulated flash is slow
+#define MOCK_WRITE_US 100
+#define MOCK_ERASE_US 20000
+
+//***************************************************************************//
+
+struct mock_record {
+    bool used;
+    uint16_t key;
+    uint16_t len;
+    uint8_t data[MOCK_RECORD_SIZE];
+};
+
+//***************************************************************************//
+
+struct mock_flash mock_flash;
+
+static struct mock_record records[MOCK_RECORDS];
+
+//***************************************************************************//
+
+void mock_flash_reset(void) {
+    (void)memset(records, 0x00, sizeof(records));
+    (void)memset(&mock_flash, 0x00, sizeof(mock_flash));
+
+    mock_flash.writes_left = -1;
+    mock_flash.sector_free = MOCK_SECTOR_SIZE;
+    mock_flash.write_us = MOCK_WRITE_US;
+    mock_flash.erase_us = MOCK_ERASE_US;
+}
+
+static struct mock_record* record_find(uint16_t key) {
+    for (size_t i = 0; i < ARRAY_SIZE(records); ++i) {
+        if (records[i].used && (records[i].key == key)) {
+            return &records[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Once the budget is spent the power stays off until the test restores it
+static bool power_cut(void) {
+    if (mock_flash.writes_left == 0) {
+        return true;
+    }
+
+    if (mock_flash.writes_left > 0) {
+        --mock_flash.writes_left;
+    }
+
+    ++mock_flash.writes;
+
+    return false;
+}
+
+// Data and its allocation entry fill the sector, a write that does not fit erases the next one
+static void sector_use(size_t len) {
+    const ssize_t size = (ssize_t)(len + MOCK_ATE_SIZE);
+
+    if (mock_flash.sector_free < size) {
+        k_busy_wait(mock_flash.erase_us);
+        mock_flash.sector_free = MOCK_SECTOR_SIZE;
+    }
+
+    mock_flash.sector_free -= size;
+
+    k_busy_wait(mock_flash.write_us);
+}
+
+//***************************************************************************//
+
+int storage_backend_mount(const struct device* dev, off_t offset, size_t size) {
+    return 0;
+}
+
+ssize_t storage_backend_read(uint16_t key, void* data, size_t len) {
+    const struct mock_record* record = record_find(key);
+
+    if (record == NULL) {
+        return -ENOENT;
+    }
+
+    (void)memcpy(data, record->data, MIN(len, record->len));
+
+    return record->len;
+}
+
+ssize_t storage_backend_write(uint16_t key, const void* data, size_t len) {
+    struct mock_record* record = record_find(key);
+
+    if ((len > MOCK_RECORD_SIZE) || power_cut()) {
+        return -EIO;
+    }
+
+    for (size_t i = 0; (record == NULL) && (i < ARRAY_SIZE(records)); ++i) {
+        if (!records[i].used) {
+            record = &records[i];
+        }
+    }
+
+    if (record == NULL) {
+        return -ENOSPC;
+    }
+
+    sector_use(len);
+
+    record->used = true;
+    record->key = key;
+    record->len = len;
+    (void)memcpy(record->data, data, len);
+
+    return len;
+}
+
+int storage_backend_delete(uint16_t key) {
+    struct mock_record* record = record_find(key);
+
+    if (power_cut()) {
+        return -EIO;
+    }
+
+    sector_use(0);
+
+    if (record != NULL) {
+        (void)memset(record, 0x00, sizeof(*record));
+    }
+
+    return 0;
+}
+
+ssize_t storage_backend_sector_free(void) {
+    return mock_flash.sector_free;
+}
+
+int storage_backend_sector_next(void) {
+    ++mock_flash.sector_next_calls;
+    mock_flash.sector_next_at = mock_flash.writes;
+    mock_flash.sector_free = MOCK_SECTOR_SIZE;
+
+    k_busy_wait(mock_flash.erase_us);
+
+    return 0;
+}
+
+//***************************************************************************//
@@ -0,0 +1,30 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include "mocks.h"
+#include "storage_ecc.h"
+
+//***************************************************************************//
+
+struct mock_ecc mock_ecc;
+
+//***************************************************************************//
+
+void mock_ecc_reset(void) {
+    (void)memset(&mock_ecc, 0x00, sizeof(mock_ecc));
+
+    mock_ecc.torn_offset = -1;
+}
+
+// The flash simulator has no ECC, a read over the torn offset fails as the STM32 NMI path does
+int storage_ecc_read(const struct flash_area* fa, off_t offset, void* data, size_t len) {
+    if ((mock_ecc.torn_offset >= offset) && (mock_ecc.torn_offset < (off_t)(offset + len))) {
+        ++mock_ecc.errors;
+        return -EBADMSG;
+    }
+
+    return flash_area_read(fa, offset, data, len);
+}
+
+//***************************************************************************//
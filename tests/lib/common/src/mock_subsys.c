@@ -0,0 +1,12 @@
+//***************************************************************************//
+
+#include "elerium/subsys/subsys.h"
+
+//***************************************************************************//
+
+void elerium_subsys_provisioned(enum elerium_subsys subsys, uint32_t us) {
+    ARG_UNUSED(subsys);
+    ARG_UNUSED(us);
+}
+
+//***************************************************************************//
@@ -0,0 +1,108 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include "elerium/subsys/wallet.h"
+
+#include "mocks.h"
+
+//***************************************************************************//
+
+struct mock_wallet mock_wallet;
+
+// Only compared against NULL by the callers
+static uint8_t wallet_handle;
+
+//***************************************************************************//
+
+void mock_wallet_reset(void) {
+    (void)memset(&mock_wallet, 0x00, sizeof(mock_wallet));
+}
+
+struct elerium_wallet* elerium_wallet_get(const uint8_t* passcode) {
+    ARG_UNUSED(passcode);
+
+    return (struct elerium_wallet*)&wallet_handle;
+}
+
+int elerium_wallet_fingerprint(const struct elerium_wallet* wallet, uint8_t* fingerprint) {
+    ARG_UNUSED(wallet);
+
+    (void)memcpy(fingerprint, mock_wallet.fingerprint, sizeof(mock_wallet.fingerprint));
+
+    return 0;
+}
+
+// Every path derives the same key, the path asked for is recorded
+int elerium_wallet_path_pub(const struct elerium_wallet* wallet,
+                            const uint32_t* path,
+                            size_t depth,
+                            uint8_t* pub_key,
+                            uint8_t* hash160) {
+    ARG_UNUSED(wallet);
+
+    if (depth > ARRAY_SIZE(mock_wallet.path)) {
+        return -EINVAL;
+    }
+
+    (void)memcpy(mock_wallet.path, path, depth * sizeof(path[0]));
+    mock_wallet.depth = depth;
+
+    (void)memcpy(pub_key, mock_wallet.pub_key, sizeof(mock_wallet.pub_key));
+
+    if (hash160 != NULL) {
+        (void)memcpy(hash160, mock_wallet.hash160, sizeof(mock_wallet.hash160));
+    }
+
+    return 0;
+}
+
+static int sign(const uint32_t* path,
+                size_t depth,
+                const uint8_t* hash,
+                size_t hash_length,
+                uint8_t* signature,
+                bool taproot) {
+    if ((depth != mock_wallet.depth)
+        || (memcmp(path, mock_wallet.path, depth * sizeof(path[0])) != 0)) {
+        return -EINVAL;
+    }
+
+    if (hash_length != sizeof(mock_wallet.hash)) {
+        return -EINVAL;
+    }
+
+    (void)memcpy(mock_wallet.hash, hash, hash_length);
+    mock_wallet.taproot = taproot;
+    ++mock_wallet.signs;
+
+    // The hash stands in for a signature, the tests only check what was signed
+    (void)memset(signature, 0x00, sizeof(struct elerium_signature));
+    (void)memcpy(signature, hash, hash_length);
+
+    return 0;
+}
+
+int elerium_wallet_sign_path(const struct elerium_wallet* wallet,
+                             const uint32_t* path,
+                             size_t depth,
+                             const uint8_t* hash,
+                             size_t hash_length,
+                             uint8_t* signature) {
+    ARG_UNUSED(wallet);
+
+    return sign(path, depth, hash, hash_length, signature, false);
+}
+
+int elerium_wallet_sign_path_taproot(const struct elerium_wallet* wallet,
+                                     const uint32_t* path,
+                                     size_t depth,
+                                     const uint8_t* hash,
+                                     size_t hash_length,
+                                     uint8_t* signature) {
+    ARG_UNUSED(wallet);
+
+    return sign(path, depth, hash, hash_length, signature, true);
+}
+
+//***************************************************************************//
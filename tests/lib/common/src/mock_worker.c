@@ -0,0 +1,44 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "elerium/subsys/worker.h"
+
+#include "mocks.h"
+
+//***************************************************************************//
+
+struct mock_worker mock_worker;
+
+//***************************************************************************//
+
+void mock_worker_reset(void) {
+    (void)memset(&mock_worker, 0x00, sizeof(mock_worker));
+}
+
+void mock_worker_run(void) {
+    struct k_work_delayable* const work = mock_worker.last;
+
+    zassert_not_null(work, "no job scheduled");
+
+    mock_worker.last = NULL;
+    work->work.handler(&work->work);
+}
+
+// Background jobs are driven by the tests
+int elerium_worker_schedule(struct k_work_delayable* work, k_timeout_t delay) {
+    ARG_UNUSED(delay);
+
+    ++mock_worker.scheduled;
+    mock_worker.last = work;
+
+    return 0;
+}
+
+int elerium_worker_reschedule(struct k_work_delayable* work, k_timeout_t delay) {
+    return elerium_worker_schedule(work, delay);
+}
+
+//***************************************************************************//
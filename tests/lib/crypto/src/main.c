@@ -0,0 +1,182 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "mocks.h"
+
+// Built into the test so the pool can be drained and refilled directly
+#include "crypto_tinycrypt.c"
+
+//***************************************************************************//
+
+#define TEST_DRAW_SIZE 32
+#define TEST_BENCH_ROUNDS 64
+
+//***************************************************************************//
+
+static void crypto_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    mock_worker_reset();
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+    zassert_ok(drbg_refill());
+    k_mutex_unlock(&mod.mut);
+}
+
+ZTEST_SUITE(crypto, NULL, NULL, crypto_before, NULL, NULL);
+
+//***************************************************************************//
+
+static struct elerium_crypto_drbg_stats get_stats(void) {
+    struct elerium_crypto_drbg_stats stats;
+
+    elerium_crypto_random_stats(&stats);
+
+    return stats;
+}
+
+ZTEST(crypto, test_seeded_at_boot) {
+    const struct elerium_crypto_drbg_stats stats = get_stats();
+
+    zassert_true(mod.seeded);
+    zassert_true(stats.reseeds >= 1);
+    zassert_equal(stats.health_failures, 0);
+}
+
+// The nonces of a signature come out of the pool, the DRBG does not run on the signing path
+ZTEST(crypto, test_sign_served_from_pool) {
+    struct elerium_priv_key priv_key;
+    struct elerium_pub_key pub_key;
+    struct elerium_signature sign;
+    struct elerium_hash hash;
+
+    zassert_ok(elerium_crypto_generate(&priv_key, &pub_key));
+    zassert_ok(elerium_crypto_sha256("elerium", 7, &hash));
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+    zassert_ok(drbg_refill());
+    k_mutex_unlock(&mod.mut);
+
+    const struct elerium_crypto_drbg_stats before = get_stats();
+
+    zassert_ok(elerium_crypto_sign(&priv_key, hash.data, sizeof(hash.data), &sign));
+
+    const struct elerium_crypto_drbg_stats after = get_stats();
+
+    zassert_equal(after.bytes_generated, before.bytes_generated);
+    zassert_equal(after.pool_misses, before.pool_misses);
+
+    zassert_ok(elerium_crypto_verify(&pub_key, hash.data, sizeof(hash.data), &sign));
+}
+
+ZTEST(crypto, test_pool_miss_generates_inline) {
+    uint8_t out[DRBG_POOL_SIZE + TEST_DRAW_SIZE];
+
+    const struct elerium_crypto_drbg_stats before = get_stats();
+
+    zassert_ok(elerium_crypto_random_fill(out, sizeof(out)));
+
+    const struct elerium_crypto_drbg_stats after = get_stats();
+
+    zassert_equal(after.pool_misses, before.pool_misses + 1);
+    zassert_equal(after.bytes_generated, before.bytes_generated + TEST_DRAW_SIZE);
+    zassert_equal(mod.pool_avail, 0);
+}
+
+ZTEST(crypto, test_refill_scheduled_below_half) {
+    uint8_t out[TEST_DRAW_SIZE];
+
+    size_t draws = 0;
+
+    while (mod.pool_avail >= (DRBG_POOL_SIZE / 2)) {
+        zassert_equal(mock_worker.scheduled, 0);
+        zassert_ok(elerium_crypto_random_fill(out, sizeof(out)));
+        ++draws;
+    }
+
+    zassert_equal(draws, DIV_ROUND_UP(DRBG_POOL_SIZE / 2 + 1, TEST_DRAW_SIZE));
+    zassert_equal_ptr(mock_worker.last, &mod.refill_work);
+
+    mock_worker_run();
+
+    zassert_equal(mod.pool_avail, DRBG_POOL_SIZE);
+}
+
+// Served bytes are wiped, a later draw cannot hand them out again
+ZTEST(crypto, test_served_bytes_wiped) {
+    uint8_t out[TEST_DRAW_SIZE];
+    static const uint8_t zero[TEST_DRAW_SIZE];
+
+    zassert_ok(elerium_crypto_random_fill(out, sizeof(out)));
+
+    zassert_mem_equal(&mod.pool[mod.pool_avail], zero, sizeof(zero));
+    zassert_true(memcmp(out, zero, sizeof(out)) != 0);
+}
+
+ZTEST(crypto, test_reseed_after_bytes) {
+    uint8_t out[TEST_DRAW_SIZE];
+
+    const struct elerium_crypto_drbg_stats before = get_stats();
+
+    k_mutex_lock(&mod.mut, K_FOREVER);
+    mod.stats.bytes_since_reseed = DRBG_RESEED_BYTES;
+    k_mutex_unlock(&mod.mut);
+
+    // The caller is still served, the reseed waits for the worker
+    zassert_ok(elerium_crypto_random_fill(out, sizeof(out)));
+    zassert_equal(get_stats().reseeds, before.reseeds);
+
+    mock_worker_run();
+
+    const struct elerium_crypto_drbg_stats after = get_stats();
+
+    zassert_equal(after.reseeds, before.reseeds + 1);
+    zassert_equal(after.bytes_since_reseed, DRBG_POOL_SIZE);
+    zassert_equal(mod.pool_avail, DRBG_POOL_SIZE);
+}
+
+//***************************************************************************//
+
+// Cycles per 32 byte draw from the pool, from the DRBG and from the entropy driver as every draw
+// did before the pool. Only meaningful on hardware, native_sim time does not advance while code
+// runs.
+ZTEST(crypto, test_benchmark) {
+    uint8_t out[TEST_DRAW_SIZE];
+    uint32_t pool_cycles = 0;
+    uint32_t drbg_cycles = 0;
+    uint32_t entropy_cycles = 0;
+
+    for (size_t i = 0; i < TEST_BENCH_ROUNDS; ++i) {
+        if (mod.pool_avail < sizeof(out)) {
+            mock_worker_run();
+        }
+
+        uint32_t start = k_cycle_get_32();
+        zassert_ok(elerium_crypto_random_fill(out, sizeof(out)));
+        pool_cycles += k_cycle_get_32() - start;
+
+        k_mutex_lock(&mod.mut, K_FOREVER);
+        start = k_cycle_get_32();
+        zassert_ok(drbg_generate(out, sizeof(out)));
+        drbg_cycles += k_cycle_get_32() - start;
+        k_mutex_unlock(&mod.mut);
+
+        start = k_cycle_get_32();
+        zassert_ok(entropy_get_entropy(entropy_dev, out, sizeof(out)));
+        entropy_cycles += k_cycle_get_32() - start;
+    }
+
+    TC_PRINT("%u byte draw: pool %u, drbg %u, entropy %u cycles\n",
+             TEST_DRAW_SIZE,
+             pool_cycles / TEST_BENCH_ROUNDS,
+             drbg_cycles / TEST_BENCH_ROUNDS,
+             entropy_cycles / TEST_BENCH_ROUNDS);
+
+    zassert_true(pool_cycles <= drbg_cycles);
+    zassert_true(pool_cycles <= entropy_cycles);
+}
+
+//***************************************************************************//
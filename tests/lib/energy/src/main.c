@@ -0,0 +1,143 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/drivers/adc/adc_emul.h>
+#include <zephyr/ztest.h>
+
+#include "mocks.h"
+
+// Built into the test so each case starts without samples or deferrals
+#include "energy.c"
+
+//***************************************************************************//
+
+#define TEST_ADC_CHANNEL 0
+
+// Clear of the ADC rounding on either side of a threshold
+#define TEST_MARGIN_MV 50
+#define TEST_FULL_MV 3300
+
+#define TEST_KEYGEN_MV CONFIG_BEECHAT_ELERIUM_ENERGY_KEYGEN_MV
+#define TEST_FLASH_MV CONFIG_BEECHAT_ELERIUM_ENERGY_FLASH_MV
+
+//***************************************************************************//
+
+static const struct device* const adc_dev = DEVICE_DT_GET(DT_NODELABEL(adc0));
+
+static struct k_work_delayable test_work;
+
+//***************************************************************************//
+
+// Set the input and let the cached sample expire, so the next job converts again
+static void set_supply(uint32_t mv) {
+    zassert_ok(adc_emul_const_value_set(adc_dev, TEST_ADC_CHANNEL, mv));
+
+    k_sleep(K_MSEC(ENERGY_SAMPLE_INTERVAL_MS));
+}
+
+static struct elerium_energy_stats get_stats(void) {
+    struct elerium_energy_stats stats;
+
+    zassert_ok(elerium_energy_stats(&stats));
+
+    return stats;
+}
+
+static void energy_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    mock_worker_reset();
+
+    (void)memset(&mod, 0x00, sizeof(mod));
+    zassert_ok(energy_init());
+
+    set_supply(TEST_FULL_MV);
+}
+
+ZTEST_SUITE(energy, NULL, NULL, energy_before, NULL, NULL);
+
+//***************************************************************************//
+
+ZTEST(energy, test_supply_sampled) {
+    set_supply(TEST_KEYGEN_MV);
+
+    const uint16_t mv = elerium_energy_supply_mv();
+
+    zassert_within(mv, TEST_KEYGEN_MV, TEST_MARGIN_MV, "%u mV", mv);
+}
+
+ZTEST(energy, test_admit_above_threshold) {
+    set_supply(TEST_KEYGEN_MV + TEST_MARGIN_MV);
+
+    zassert_false(elerium_energy_defer(&test_work, ELERIUM_ENERGY_COST_KEYGEN));
+
+    zassert_equal(mock_worker.scheduled, 0);
+    zassert_equal(get_stats().admitted, 1);
+    zassert_equal(get_stats().deferred, 0);
+}
+
+// Only the costly job waits, a cheaper one still runs on the same supply
+ZTEST(energy, test_defer_below_threshold) {
+    set_supply(TEST_KEYGEN_MV - TEST_MARGIN_MV);
+
+    zassert_true(elerium_energy_defer(&test_work, ELERIUM_ENERGY_COST_KEYGEN));
+
+    zassert_equal_ptr(mock_worker.last, &test_work);
+    zassert_equal(get_stats().deferred, 1);
+
+    zassert_ok(elerium_energy_admit(ELERIUM_ENERGY_COST_FLASH));
+
+    // The job runs once the supply recovers
+    set_supply(TEST_KEYGEN_MV + TEST_MARGIN_MV);
+
+    zassert_ok(elerium_energy_admit(ELERIUM_ENERGY_COST_KEYGEN));
+    zassert_equal(get_stats().admitted, 2);
+}
+
+ZTEST(energy, test_forced_after_max_defers) {
+    set_supply(TEST_FLASH_MV - TEST_MARGIN_MV);
+
+    for (size_t i = 0; i < ENERGY_MAX_DEFERS; ++i) {
+        zassert_equal(elerium_energy_admit(ELERIUM_ENERGY_COST_KEYGEN), -EAGAIN, "defer %zu", i);
+    }
+
+    zassert_ok(elerium_energy_admit(ELERIUM_ENERGY_COST_KEYGEN));
+
+    const struct elerium_energy_stats stats = get_stats();
+
+    zassert_equal(stats.deferred, ENERGY_MAX_DEFERS);
+    zassert_equal(stats.forced, 1);
+
+    // A forced run starts the count again
+    zassert_equal(elerium_energy_admit(ELERIUM_ENERGY_COST_KEYGEN), -EAGAIN);
+}
+
+// A sensor reading 0 mV is treated as no sensor, nothing is held back
+ZTEST(energy, test_unknown_supply_admits) {
+    set_supply(0);
+
+    zassert_false(elerium_energy_defer(&test_work, ELERIUM_ENERGY_COST_KEYGEN));
+
+    const struct elerium_energy_stats stats = get_stats();
+
+    zassert_equal(stats.supply_mv, 0);
+    zassert_equal(stats.deferred, 0);
+    zassert_equal(stats.admitted, 1);
+}
+
+// Jobs started back to back share one conversion
+ZTEST(energy, test_sample_shared) {
+    zassert_ok(elerium_energy_admit(ELERIUM_ENERGY_COST_FLASH));
+    zassert_ok(elerium_energy_admit(ELERIUM_ENERGY_COST_SIGN));
+
+    zassert_equal(get_stats().samples, 1);
+
+    k_sleep(K_MSEC(ENERGY_SAMPLE_INTERVAL_MS));
+
+    zassert_ok(elerium_energy_admit(ELERIUM_ENERGY_COST_FLASH));
+
+    zassert_equal(get_stats().samples, 2);
+}
+
+//***************************************************************************//
@@ -0,0 +1,84 @@
+//***************************************************************************//
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "elerium/host/comm.h"
+
+#include "host_bottom.h"
+
+//***************************************************************************//
+
+_Static_assert(HOST_BOTTOM_DATA_MAX_LEN == ELERIUM_COMM_DATA_MAX_LEN, "host data size");
+
+//***************************************************************************//
+
+// Module
+static struct {
+    struct elerium_comm_transport transport;
+    struct elerium_comm_frame request;
+    struct elerium_comm_frame response;
+    int timeout_ms;
+
+    pthread_t thread;
+    atomic_bool done;
+    int rc;
+} mod;
+
+//***************************************************************************//
+
+static void* host_call(void* arg) {
+    (void)arg;
+
+    mod.rc = elerium_comm_call(&mod.transport, &mod.request, &mod.response, mod.timeout_ms);
+    atomic_store(&mod.done, true);
+
+    return NULL;
+}
+
+int host_bottom_open(const char* path) {
+    return (elerium_comm_socket_open(path, &mod.transport) == 0) ? 0 : -1;
+}
+
+int host_bottom_call(const uint8_t* data, size_t len, int timeout_ms) {
+
+    if (len > ELERIUM_COMM_DATA_MAX_LEN) {
+        return -1;
+    }
+
+    (void)memset(&mod.request, 0x00, sizeof(mod.request));
+    (void)memcpy(mod.request.data, data, len);
+    mod.request.length = (uint8_t)len;
+    mod.timeout_ms = timeout_ms;
+
+    atomic_store(&mod.done, false);
+
+    return (pthread_create(&mod.thread, NULL, host_call, NULL) == 0) ? 0 : -1;
+}
+
+int host_bottom_result(uint8_t* flags, uint8_t data[HOST_BOTTOM_DATA_MAX_LEN], size_t* len) {
+
+    if (!atomic_load(&mod.done)) {
+        return 1;
+    }
+
+    (void)pthread_join(mod.thread, NULL);
+
+    if (mod.rc != 0) {
+        return -1;
+    }
+
+    *flags = mod.response.flags;
+    *len = mod.response.length;
+    (void)memcpy(data, mod.response.data, mod.response.length);
+
+    return 0;
+}
+
+void host_bottom_close(void) {
+    elerium_comm_close(&mod.transport);
+}
+
+//***************************************************************************//
@@ -0,0 +1,31 @@
+#ifndef ELERIUM_TESTS_HOST_BOTTOM_H_
+#define ELERIUM_TESTS_HOST_BOTTOM_H_
+
+//***************************************************************************//
+
+#include <stddef.h>
+#include <stdint.h>
+
+//***************************************************************************//
+
+// ELERIUM_COMM_DATA_MAX_LEN, the host header is not visible from the firmware side
+#define HOST_BOTTOM_DATA_MAX_LEN 240
+
+//***************************************************************************//
+
+// Host COMM SDK on the emulator socket, a call runs on a host thread so the firmware can answer
+
+/// @brief Connects to the emulator socket, 0 on success
+int host_bottom_open(const char* path);
+
+/// @brief Starts one call with the request data, 0 once it runs
+int host_bottom_call(const uint8_t* data, size_t len, int timeout_ms);
+
+/// @brief 1 while the call runs, 0 once it returned the response and -1 if it failed
+int host_bottom_result(uint8_t* flags, uint8_t data[HOST_BOTTOM_DATA_MAX_LEN], size_t* len);
+
+void host_bottom_close(void);
+
+//***************************************************************************//
+
+#endif // ELERIUM_TESTS_HOST_BOTTOM_H_
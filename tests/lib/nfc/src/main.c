@@ -0,0 +1,129 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "host_bottom.h"
+
+// Built into the test to reach the event queue, the driver underneath is the real one on the
+// emulated tag
+#include "nfc.c"
+
+//***************************************************************************//
+
+#define TEST_TIMEOUT_MS 5000
+#define TEST_POLL_MS 10
+#define TEST_ROUND_TRIPS 3
+
+#define TEST_CMD 0xC4
+
+//***************************************************************************//
+
+// Session events come first, the request waits in the message slot
+static void wait_request(struct elerium_nfc_message* message) {
+    do {
+        zassert_ok(elerium_nfc_read_message(message, K_MSEC(TEST_TIMEOUT_MS)));
+    } while (message->type != ELERIUM_NFC_MESSAGE_TYPE_COMM);
+}
+
+static void wait_event(enum elerium_nfc_message_type type) {
+    enum elerium_nfc_message_type next;
+
+    do {
+        zassert_ok(elerium_nfc_wait_message(&next, K_MSEC(TEST_TIMEOUT_MS)));
+    } while (next != type);
+}
+
+// The host call runs outside the simulated time, its result is polled in real time steps
+static int wait_response(uint8_t* flags, uint8_t* data, size_t* len) {
+    int rc;
+
+    for (int waited = 0; waited < TEST_TIMEOUT_MS; waited += TEST_POLL_MS) {
+        rc = host_bottom_result(flags, data, len);
+
+        if (rc <= 0) {
+            return rc;
+        }
+
+        k_sleep(K_MSEC(TEST_POLL_MS));
+    }
+
+    return -ETIMEDOUT;
+}
+
+// The SDK frames the request into SRAM, the firmware parses it and its answer comes back whole
+static void round_trip(uint8_t seq) {
+    const uint8_t request[] = { TEST_CMD, seq, 0x00, 0x00, 'p', 'i', 'n', 'g' };
+    const struct elerium_nfc_message answer = {
+        .length = 5,
+        .data = { seq, 'p', 'o', 'n', 'g' },
+    };
+
+    struct elerium_nfc_message message;
+    uint8_t data[HOST_BOTTOM_DATA_MAX_LEN];
+    uint8_t flags;
+    size_t len;
+
+    zassert_ok(host_bottom_call(request, sizeof(request), TEST_TIMEOUT_MS));
+
+    wait_request(&message);
+
+    zassert_equal(message.length, sizeof(request));
+    zassert_mem_equal(message.data, request, sizeof(request));
+
+    zassert_ok(elerium_nfc_write_message(ELERIUM_NFC_MESSAGE_FLAG_OK, &answer));
+
+    zassert_ok(wait_response(&flags, data, &len), "seq %u", seq);
+    zassert_equal(flags, ELERIUM_NFC_MESSAGE_FLAG_OK);
+    zassert_equal(len, answer.length);
+    zassert_mem_equal(data, answer.data, answer.length);
+}
+
+static void* nfc_setup(void) {
+    zassert_ok(elerium_nfc_init());
+
+    return NULL;
+}
+
+static void nfc_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    k_msgq_purge(&mod.queue);
+
+    zassert_ok(host_bottom_open(CONFIG_NTAG5_EMUL_SOCKET));
+}
+
+static void nfc_after(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    host_bottom_close();
+}
+
+ZTEST_SUITE(nfc, NULL, nfc_setup, nfc_before, nfc_after, NULL);
+
+//***************************************************************************//
+
+ZTEST(nfc, test_host_round_trip) {
+    round_trip(0);
+}
+
+// The synch block read hands the SRAM back, so the next request gets through on the same field
+ZTEST(nfc, test_consecutive_round_trips) {
+    for (uint8_t seq = 0; seq < TEST_ROUND_TRIPS; ++seq) {
+        round_trip(seq);
+    }
+}
+
+// A reader that leaves drops the field, the session ends so secrets get wiped
+ZTEST(nfc, test_reader_gone_ends_session) {
+    round_trip(0);
+
+    host_bottom_close();
+
+    wait_event(ELERIUM_NFC_MESSAGE_TYPE_SESSION_END);
+
+    zassert_equal(mod.session, NFC_SESSION_IDLE);
+}
+
+//***************************************************************************//
@@ -0,0 +1,398 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/ztest.h>
+
+#include "elerium/subsys/psbt.h"
+
+#include "mocks.h"
+#include "psbt_vectors.h"
+
+//***************************************************************************//
+
+#define TEST_PSBT_SIZE 512
+// Fed in pieces smaller than any field, like NFC frames cut at arbitrary points
+#define TEST_CHUNK_SIZE 5
+
+#define TEST_HARDENED 0x80000000u
+
+#define TEST_SIGHASH_SINGLE 0x03
+
+//***************************************************************************//
+
+static const uint8_t test_fingerprint[ELERIUM_WALLET_FINGERPRINT_SIZE] = { 0x73, 0xC5, 0xDA, 0x0A };
+static const uint8_t test_foreign_fingerprint[ELERIUM_WALLET_FINGERPRINT_SIZE] = { 0xDE, 0xAD };
+
+static const uint32_t test_p2wpkh_path[] = {
+    84 | TEST_HARDENED, 0 | TEST_HARDENED, 0 | TEST_HARDENED, 0, 0,
+};
+
+static const uint32_t test_taproot_path[] = {
+    86 | TEST_HARDENED, 0 | TEST_HARDENED, 0 | TEST_HARDENED, 0, 0,
+};
+
+static struct {
+    uint8_t psbt[TEST_PSBT_SIZE];
+    size_t len;
+} test;
+
+//***************************************************************************//
+
+static void put(const void* data, size_t len) {
+    zassert_true(test.len + len <= sizeof(test.psbt));
+
+    (void)memcpy(&test.psbt[test.len], data, len);
+    test.len += len;
+}
+
+static void put_byte(uint8_t byte) {
+    put(&byte, 1);
+}
+
+// Every key and value of these tests is shorter than a multi-byte varint
+static void put_pair(const uint8_t* key, size_t key_len, const uint8_t* value, size_t value_len) {
+    zassert_true((key_len < 0xFD) && (value_len < 0xFD));
+
+    put_byte(key_len);
+    put(key, key_len);
+    put_byte(value_len);
+    put(value, value_len);
+}
+
+static void put_separator(void) {
+    put_byte(0x00);
+}
+
+static void put_utxo(const uint8_t* utxo, size_t len) {
+    static const uint8_t key[] = { 0x01 };
+
+    put_pair(key, sizeof(key), utxo, len);
+}
+
+static void put_sighash_type(uint32_t sighash_type) {
+    static const uint8_t key[] = { 0x03 };
+
+    uint8_t value[sizeof(uint32_t)];
+    sys_put_le32(sighash_type, value);
+
+    put_pair(key, sizeof(key), value, sizeof(value));
+}
+
+// Fingerprint and path after the given prefix, the leaf hash count of a taproot derivation
+static size_t derivation_value(uint8_t* value,
+                               const uint8_t* prefix,
+                               size_t prefix_len,
+                               const uint8_t* fingerprint,
+                               const uint32_t* path,
+                               size_t depth) {
+    size_t len = 0;
+
+    if (prefix_len > 0) {
+        (void)memcpy(value, prefix, prefix_len);
+        len += prefix_len;
+    }
+
+    (void)memcpy(&value[len], fingerprint, ELERIUM_WALLET_FINGERPRINT_SIZE);
+    len += ELERIUM_WALLET_FINGERPRINT_SIZE;
+
+    for (size_t i = 0; i < depth; ++i) {
+        sys_put_le32(path[i], &value[len]);
+        len += sizeof(uint32_t);
+    }
+
+    return len;
+}
+
+static void put_derivation(const uint8_t* pub_key, const uint8_t* fingerprint) {
+    uint8_t key[1 + ELERIUM_WALLET_PUB_KEY_SIZE] = { 0x06 };
+    uint8_t value[64];
+
+    (void)memcpy(&key[1], pub_key, ELERIUM_WALLET_PUB_KEY_SIZE);
+
+    const size_t len = derivation_value(
+        value, NULL, 0, fingerprint, test_p2wpkh_path, ARRAY_SIZE(test_p2wpkh_path));
+
+    put_pair(key, sizeof(key), value, len);
+}
+
+static void put_tap_derivation(const uint8_t* xonly, const uint8_t* leaf_hashes, size_t leaf_len) {
+    uint8_t key[1 + 32] = { 0x16 };
+    uint8_t value[128];
+
+    (void)memcpy(&key[1], xonly, 32);
+
+    const size_t len = derivation_value(value,
+                                        leaf_hashes,
+                                        leaf_len,
+                                        test_fingerprint,
+                                        test_taproot_path,
+                                        ARRAY_SIZE(test_taproot_path));
+
+    put_pair(key, sizeof(key), value, len);
+}
+
+// Magic and the global map, the input maps follow
+static void put_header(void) {
+    static const uint8_t magic[] = { 'p', 's', 'b', 't', 0xFF };
+    static const uint8_t tx_key[] = { 0x00 };
+
+    put(magic, sizeof(magic));
+    put_pair(tx_key, sizeof(tx_key), psbt_vector_tx, sizeof(psbt_vector_tx));
+    put_separator();
+}
+
+// Both output maps are empty
+static void put_outputs(void) {
+    put_separator();
+    put_separator();
+}
+
+static int feed(void) {
+    int rc = 0;
+
+    for (size_t pos = 0; (rc == 0) && (pos < test.len); pos += TEST_CHUNK_SIZE) {
+        rc = elerium_psbt_feed(&test.psbt[pos], MIN(TEST_CHUNK_SIZE, test.len - pos));
+    }
+
+    if (rc == 0) {
+        rc = elerium_psbt_finish();
+    }
+
+    return rc;
+}
+
+static void check_signed(uint32_t input, const uint8_t* sighash, bool taproot) {
+    struct elerium_psbt_signature signature;
+
+    zassert_ok(elerium_psbt_pop_signature(&signature));
+    zassert_equal(signature.input, input);
+    zassert_mem_equal(signature.sign.data, sighash, 32);
+
+    zassert_equal(mock_wallet.signs, 1);
+    zassert_equal(mock_wallet.taproot, taproot);
+
+    zassert_equal(elerium_psbt_pop_signature(&signature), -ENOENT);
+}
+
+static void check_unsigned(void) {
+    struct elerium_psbt_signature signature;
+
+    zassert_equal(mock_wallet.signs, 0);
+    zassert_equal(elerium_psbt_pop_signature(&signature), -ENOENT);
+}
+
+//***************************************************************************//
+
+static void psbt_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    mock_wallet_reset();
+    mock_worker_reset();
+
+    (void)memset(&test, 0x00, sizeof(test));
+
+    (void)memcpy(mock_wallet.fingerprint, test_fingerprint, sizeof(test_fingerprint));
+    (void)memcpy(mock_wallet.pub_key, psbt_vector_p2wpkh_pub_key, ELERIUM_WALLET_PUB_KEY_SIZE);
+    (void)memcpy(mock_wallet.hash160, psbt_vector_p2wpkh_hash160, ELERIUM_WALLET_HASH160_SIZE);
+
+    elerium_psbt_abort();
+    zassert_ok(elerium_psbt_begin());
+
+    put_header();
+}
+
+ZTEST_SUITE(psbt, NULL, NULL, psbt_before, NULL, NULL);
+
+//***************************************************************************//
+
+// Native P2WPKH example of BIP143, the sighash of input 1 is the one from the BIP
+ZTEST(psbt, test_p2wpkh_bip143_vector) {
+    put_separator();
+
+    put_utxo(psbt_vector_p2wpkh_utxo, sizeof(psbt_vector_p2wpkh_utxo));
+    put_derivation(psbt_vector_p2wpkh_pub_key, test_fingerprint);
+    put_separator();
+
+    put_outputs();
+
+    zassert_ok(feed());
+
+    check_signed(1, psbt_vector_p2wpkh_sighash, false);
+    zassert_mem_equal(mock_wallet.path, test_p2wpkh_path, sizeof(test_p2wpkh_path));
+}
+
+ZTEST(psbt, test_foreign_fingerprint_skipped) {
+    put_separator();
+
+    put_utxo(psbt_vector_p2wpkh_utxo, sizeof(psbt_vector_p2wpkh_utxo));
+    put_derivation(psbt_vector_p2wpkh_pub_key, test_foreign_fingerprint);
+    put_separator();
+
+    put_outputs();
+
+    zassert_ok(feed());
+
+    check_unsigned();
+    // Nothing was derived for another signer
+    zassert_equal(mock_wallet.depth, 0);
+}
+
+// The path belongs to the wallet but the PSBT names another key for it
+ZTEST(psbt, test_pub_key_mismatch_skipped) {
+    mock_wallet.pub_key[ELERIUM_WALLET_PUB_KEY_SIZE - 1] ^= 0x01;
+
+    put_separator();
+
+    put_utxo(psbt_vector_p2wpkh_utxo, sizeof(psbt_vector_p2wpkh_utxo));
+    put_derivation(psbt_vector_p2wpkh_pub_key, test_fingerprint);
+    put_separator();
+
+    put_outputs();
+
+    zassert_ok(feed());
+
+    check_unsigned();
+}
+
+// The key matches but the spent output pays to another program
+ZTEST(psbt, test_program_mismatch_skipped) {
+    uint8_t utxo[sizeof(psbt_vector_p2wpkh_utxo)];
+
+    (void)memcpy(utxo, psbt_vector_p2wpkh_utxo, sizeof(utxo));
+    utxo[sizeof(utxo) - 1] ^= 0x01;
+
+    put_separator();
+
+    put_utxo(utxo, sizeof(utxo));
+    put_derivation(psbt_vector_p2wpkh_pub_key, test_fingerprint);
+    put_separator();
+
+    put_outputs();
+
+    zassert_ok(feed());
+
+    check_unsigned();
+}
+
+ZTEST(psbt, test_own_derivation_after_foreign) {
+    put_separator();
+
+    put_utxo(psbt_vector_p2wpkh_utxo, sizeof(psbt_vector_p2wpkh_utxo));
+    put_derivation(psbt_vector_p2wpkh_pub_key, test_foreign_fingerprint);
+    put_derivation(psbt_vector_p2wpkh_pub_key, test_fingerprint);
+    put_separator();
+
+    put_outputs();
+
+    zassert_ok(feed());
+
+    check_signed(1, psbt_vector_p2wpkh_sighash, false);
+}
+
+ZTEST(psbt, test_p2wpkh_sighash_single_rejected) {
+    put_separator();
+
+    put_utxo(psbt_vector_p2wpkh_utxo, sizeof(psbt_vector_p2wpkh_utxo));
+    put_sighash_type(TEST_SIGHASH_SINGLE);
+    put_derivation(psbt_vector_p2wpkh_pub_key, test_fingerprint);
+    put_separator();
+
+    put_outputs();
+
+    zassert_equal(feed(), -ENOTSUP);
+}
+
+//***************************************************************************//
+
+static void taproot_wallet(void) {
+    mock_wallet.pub_key[0] = 0x02;
+    (void)memcpy(&mock_wallet.pub_key[1], psbt_vector_taproot_internal_key, 32);
+}
+
+ZTEST(psbt, test_taproot_key_path) {
+    static const uint8_t key_path[] = { 0x00 };
+
+    taproot_wallet();
+
+    put_utxo(psbt_vector_taproot_other_utxo, sizeof(psbt_vector_taproot_other_utxo));
+    put_separator();
+
+    put_utxo(psbt_vector_taproot_utxo, sizeof(psbt_vector_taproot_utxo));
+    put_tap_derivation(psbt_vector_taproot_internal_key, key_path, sizeof(key_path));
+    put_separator();
+
+    put_outputs();
+
+    zassert_ok(feed());
+
+    check_signed(1, psbt_vector_taproot_sighash, true);
+    zassert_mem_equal(mock_wallet.path, test_taproot_path, sizeof(test_taproot_path));
+}
+
+// The output key of the vector is the BIP86 tweak of the internal key
+ZTEST(psbt, test_taproot_output_key) {
+    uint8_t output_key[32];
+
+    zassert_ok(elerium_crypto_secp256k1_taproot_key(psbt_vector_taproot_internal_key, output_key));
+    zassert_mem_equal(output_key, psbt_vector_taproot_output_key, sizeof(output_key));
+}
+
+// A derivation for script leaves is left to a signer of script paths
+ZTEST(psbt, test_taproot_script_path_skipped) {
+    uint8_t leaf_hashes[1 + 32] = { 0x01 };
+
+    taproot_wallet();
+
+    put_utxo(psbt_vector_taproot_other_utxo, sizeof(psbt_vector_taproot_other_utxo));
+    put_separator();
+
+    put_utxo(psbt_vector_taproot_utxo, sizeof(psbt_vector_taproot_utxo));
+    put_tap_derivation(psbt_vector_taproot_internal_key, leaf_hashes, sizeof(leaf_hashes));
+    put_separator();
+
+    put_outputs();
+
+    zassert_ok(feed());
+
+    check_unsigned();
+}
+
+// BIP341 commits to the amount and script of every input
+ZTEST(psbt, test_taproot_needs_every_utxo) {
+    static const uint8_t key_path[] = { 0x00 };
+
+    taproot_wallet();
+
+    put_separator();
+
+    put_utxo(psbt_vector_taproot_utxo, sizeof(psbt_vector_taproot_utxo));
+    put_tap_derivation(psbt_vector_taproot_internal_key, key_path, sizeof(key_path));
+    put_separator();
+
+    put_outputs();
+
+    zassert_equal(feed(), -EINVAL);
+    check_unsigned();
+}
+
+ZTEST(psbt, test_taproot_sighash_single_rejected) {
+    static const uint8_t key_path[] = { 0x00 };
+
+    taproot_wallet();
+
+    put_utxo(psbt_vector_taproot_other_utxo, sizeof(psbt_vector_taproot_other_utxo));
+    put_separator();
+
+    put_utxo(psbt_vector_taproot_utxo, sizeof(psbt_vector_taproot_utxo));
+    put_sighash_type(TEST_SIGHASH_SINGLE);
+    put_tap_derivation(psbt_vector_taproot_internal_key, key_path, sizeof(key_path));
+    put_separator();
+
+    put_outputs();
+
+    zassert_equal(feed(), -ENOTSUP);
+}
+
+//***************************************************************************//
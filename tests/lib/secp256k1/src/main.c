@@ -0,0 +1,186 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "elerium/subsys/crypto.h"
+
+#include "mocks.h"
+
+//***************************************************************************//
+
+// More keys than the batch keeps parsed, so the cache has to evict
+#define TEST_KEYS 6
+#define TEST_ITEMS 12
+
+// Co-signer shaped batch, a few keys each signing several hashes
+#define TEST_BENCH_KEYS 2
+#define TEST_BENCH_ITEMS 8
+
+//***************************************************************************//
+
+static struct {
+    struct elerium_pub_key pub_keys[TEST_KEYS];
+    struct elerium_hash hashes[TEST_ITEMS];
+    struct elerium_signature signs[TEST_ITEMS];
+    struct elerium_crypto_verify_item items[TEST_ITEMS];
+} test;
+
+//***************************************************************************//
+
+// Item i is signed by key i % keys
+static void sign_items(size_t keys) {
+    struct elerium_priv_key priv_keys[TEST_KEYS];
+
+    for (size_t k = 0; k < keys; ++k) {
+        zassert_ok(elerium_crypto_secp256k1_generate(&priv_keys[k]));
+        zassert_ok(elerium_crypto_secp256k1_get_pub(&priv_keys[k], &test.pub_keys[k]));
+    }
+
+    for (size_t i = 0; i < TEST_ITEMS; ++i) {
+        const struct elerium_priv_key* priv_key = &priv_keys[i % keys];
+
+        zassert_ok(elerium_crypto_sha256(&i, sizeof(i), &test.hashes[i]));
+        zassert_ok(elerium_crypto_secp256k1_sign(
+            priv_key, test.hashes[i].data, sizeof(test.hashes[i].data), &test.signs[i]));
+
+        test.items[i] = (struct elerium_crypto_verify_item){
+            .pub_key = &test.pub_keys[i % keys],
+            .hash = test.hashes[i].data,
+            .hash_len = sizeof(test.hashes[i].data),
+            .sign = &test.signs[i],
+            .result = 1,
+        };
+    }
+
+    (void)memset(priv_keys, 0x00, sizeof(priv_keys));
+}
+
+static void secp256k1_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    mock_worker_reset();
+
+    sign_items(TEST_KEYS);
+}
+
+ZTEST_SUITE(secp256k1, NULL, NULL, secp256k1_before, NULL, NULL);
+
+//***************************************************************************//
+
+ZTEST(secp256k1, test_batch_all_valid) {
+    zassert_ok(elerium_crypto_secp256k1_verify_batch(test.items, TEST_ITEMS));
+
+    for (size_t i = 0; i < TEST_ITEMS; ++i) {
+        zassert_ok(test.items[i].result, "item %zu", i);
+    }
+}
+
+ZTEST(secp256k1, test_batch_empty) {
+    zassert_ok(elerium_crypto_secp256k1_verify_batch(NULL, 0));
+}
+
+// A bad item fails alone, the items around it, including those sharing its key, still pass
+ZTEST(secp256k1, test_batch_per_item_results) {
+    struct elerium_pub_key off_curve;
+
+    (void)memset(&off_curve, 0x00, sizeof(off_curve));
+
+    test.signs[1].data[10] ^= 0x01;
+    test.items[4].hash_len = sizeof(test.hashes[4].data) - 1;
+    test.items[5].pub_key = &off_curve;
+    // Signed by another key
+    test.items[8].sign = &test.signs[9];
+
+    zassert_equal(elerium_crypto_secp256k1_verify_batch(test.items, TEST_ITEMS), -EFAULT);
+
+    for (size_t i = 0; i < TEST_ITEMS; ++i) {
+        const struct elerium_crypto_verify_item* item = &test.items[i];
+
+        zassert_equal(item->result,
+                      elerium_crypto_secp256k1_verify(
+                          item->pub_key, item->hash, item->hash_len, item->sign),
+                      "item %zu",
+                      i);
+    }
+
+    zassert_equal(test.items[1].result, -EFAULT);
+    zassert_equal(test.items[4].result, -EINVAL);
+    zassert_equal(test.items[5].result, -EINVAL);
+    zassert_equal(test.items[8].result, -EFAULT);
+    zassert_ok(test.items[7].result);
+    zassert_ok(test.items[11].result);
+}
+
+// The key of an off-curve item stays rejected when it comes back after other keys
+ZTEST(secp256k1, test_batch_cached_rejection) {
+    struct elerium_pub_key off_curve;
+
+    (void)memset(&off_curve, 0x00, sizeof(off_curve));
+
+    test.items[0].pub_key = &off_curve;
+    test.items[2].pub_key = &off_curve;
+
+    zassert_equal(elerium_crypto_secp256k1_verify_batch(test.items, TEST_ITEMS), -EFAULT);
+
+    zassert_equal(test.items[0].result, -EINVAL);
+    zassert_ok(test.items[1].result);
+    zassert_equal(test.items[2].result, -EINVAL);
+    zassert_ok(test.items[6].result);
+}
+
+//***************************************************************************//
+
+// Cycles of one batch against the same items verified one call at a time. Only meaningful on
+// hardware, native_sim time does not advance while code runs.
+ZTEST(secp256k1, test_benchmark) {
+    sign_items(TEST_BENCH_KEYS);
+
+    uint32_t start = k_cycle_get_32();
+
+    for (size_t i = 0; i < TEST_BENCH_ITEMS; ++i) {
+        const struct elerium_crypto_verify_item* item = &test.items[i];
+
+        zassert_ok(elerium_crypto_secp256k1_verify(
+            item->pub_key, item->hash, item->hash_len, item->sign));
+    }
+
+    const uint32_t sequential_cycles = k_cycle_get_32() - start;
+
+    start = k_cycle_get_32();
+
+    zassert_ok(elerium_crypto_secp256k1_verify_batch(test.items, TEST_BENCH_ITEMS));
+
+    const uint32_t batch_cycles = k_cycle_get_32() - start;
+
+    TC_PRINT("%u signatures over %u keys: sequential %u, batch %u cycles\n",
+             TEST_BENCH_ITEMS,
+             TEST_BENCH_KEYS,
+             sequential_cycles,
+             batch_cycles);
+}
+
+// Sign latency with the generator table picked in Kconfig
+ZTEST(secp256k1, test_benchmark_sign) {
+    struct elerium_priv_key priv_key;
+    struct elerium_signature sign;
+
+    zassert_ok(elerium_crypto_secp256k1_generate(&priv_key));
+
+    const uint32_t start = k_cycle_get_32();
+
+    for (size_t i = 0; i < TEST_ITEMS; ++i) {
+        zassert_ok(elerium_crypto_secp256k1_sign(
+            &priv_key, test.hashes[i].data, sizeof(test.hashes[i].data), &sign));
+    }
+
+    const uint32_t cycles = (k_cycle_get_32() - start) / TEST_ITEMS;
+
+    TC_PRINT("sign with the %u KiB table: %u cycles, %u us\n",
+             CONFIG_BEECHAT_ELERIUM_CRYPTO_SECP256K1_ECMULT_GEN_KB,
+             cycles,
+             k_cyc_to_us_floor32(cycles));
+}
+
+//***************************************************************************//
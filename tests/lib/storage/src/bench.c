@@ -0,0 +1,139 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/drivers/flash.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/ztest.h>
+
+#include "mocks.h"
+
+// Built into the test so a reboot can clear its state, the backend is the real one on the flash
+// simulator or the board flash
+#include "storage.c"
+
+//***************************************************************************//
+
+#define TEST_RECORD_SIZE 64
+#define TEST_BENCH_ROUNDS 32
+
+// Loaded in turn, twice as many keys as cache entries miss the cache every time
+#define TEST_BENCH_KEYS (2 * CACHE_ENTRIES)
+#define TEST_KEY(i) (0x0301 + (i))
+
+//***************************************************************************//
+
+// RAM state is lost, mount and replay run again over what is on flash
+static uint32_t reboot(void) {
+    (void)memset(&mod, 0x00, sizeof(mod));
+
+    const uint32_t start = k_cycle_get_32();
+
+    zassert_ok(elerium_storage_init());
+
+    return k_cycle_get_32() - start;
+}
+
+static void bench_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    const struct flash_area* fa;
+
+    mock_worker_reset();
+
+    zassert_ok(flash_area_open(FIXED_PARTITION_ID(STORAGE_PARTITION), &fa));
+    zassert_ok(flash_area_erase(fa, 0, fa->fa_size));
+    flash_area_close(fa);
+
+    (void)reboot();
+}
+
+ZTEST_SUITE(storage_bench, NULL, NULL, bench_before, NULL, NULL);
+
+//***************************************************************************//
+
+// Records written across several sector changes are all still there after a mount
+ZTEST(storage_bench, test_records_survive_sector_changes) {
+    uint8_t record[TEST_RECORD_SIZE];
+    uint8_t loaded[TEST_RECORD_SIZE];
+
+    for (size_t round = 0; round < TEST_BENCH_ROUNDS; ++round) {
+        for (size_t i = 0; i < TEST_BENCH_KEYS; ++i) {
+            (void)memset(record, (int)(round + i), sizeof(record));
+            zassert_ok(elerium_storage_save(TEST_KEY(i), record, sizeof(record)));
+        }
+
+        mock_worker_run();
+    }
+
+    (void)reboot();
+
+    for (size_t i = 0; i < TEST_BENCH_KEYS; ++i) {
+        (void)memset(record, (int)(TEST_BENCH_ROUNDS - 1 + i), sizeof(record));
+        zassert_ok(elerium_storage_load(TEST_KEY(i), loaded, sizeof(loaded)));
+        zassert_mem_equal(loaded, record, sizeof(record), "key %zu", i);
+    }
+}
+
+//***************************************************************************//
+
+// Cycles of a save, of a load from flash and from the cache, and of a mount over the records.
+// Only meaningful on hardware, native_sim time does not advance while code runs.
+ZTEST(storage_bench, test_benchmark) {
+    uint8_t record[TEST_RECORD_SIZE];
+    struct elerium_storage_stats before;
+    struct elerium_storage_stats after;
+    struct flash_pages_info info;
+
+    zassert_ok(
+        flash_get_page_info_by_offs(STORAGE_PARTITION_DEVICE, STORAGE_PARTITION_OFFSET, &info));
+
+    (void)memset(record, 0xA5, sizeof(record));
+
+    uint32_t start = k_cycle_get_32();
+
+    for (size_t round = 0; round < TEST_BENCH_ROUNDS; ++round) {
+        zassert_ok(elerium_storage_save(TEST_KEY(round % TEST_BENCH_KEYS), record, sizeof(record)));
+    }
+
+    const uint32_t save_cycles = (k_cycle_get_32() - start) / TEST_BENCH_ROUNDS;
+
+    zassert_ok(elerium_storage_stats(&before));
+
+    start = k_cycle_get_32();
+
+    for (size_t round = 0; round < TEST_BENCH_ROUNDS; ++round) {
+        zassert_ok(elerium_storage_load(TEST_KEY(round % TEST_BENCH_KEYS), record, sizeof(record)));
+    }
+
+    const uint32_t flash_cycles = (k_cycle_get_32() - start) / TEST_BENCH_ROUNDS;
+
+    start = k_cycle_get_32();
+
+    for (size_t round = 0; round < TEST_BENCH_ROUNDS; ++round) {
+        zassert_ok(elerium_storage_load(TEST_KEY(0), record, sizeof(record)));
+    }
+
+    const uint32_t cache_cycles = (k_cycle_get_32() - start) / TEST_BENCH_ROUNDS;
+
+    zassert_ok(elerium_storage_stats(&after));
+
+    // The first load of key 0 still comes from flash, every other one from the cache
+    zassert_equal(after.cache_misses - before.cache_misses, TEST_BENCH_ROUNDS + 1);
+    zassert_equal(after.cache_hits - before.cache_hits, TEST_BENCH_ROUNDS - 1);
+
+    const uint32_t mount_cycles = reboot();
+
+    TC_PRINT("%u pages of %u bytes, %u records: save %u, load from flash %u, load from cache %u, "
+             "mount %u cycles, max write %u us\n",
+             (uint32_t)(STORAGE_PARTITION_SIZE / info.size),
+             (uint32_t)info.size,
+             TEST_BENCH_KEYS,
+             save_cycles,
+             flash_cycles,
+             cache_cycles,
+             mount_cycles,
+             after.max_write_us);
+}
+
+//***************************************************************************//
@@ -0,0 +1,107 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "mocks.h"
+
+// Built into the test so a reboot can clear its state
+#include "storage_counter.c"
+
+//***************************************************************************//
+
+#define TEST_COUNTER_KEY 0x0201
+
+//***************************************************************************//
+
+// RAM state is lost, the counter page keeps what was programmed
+static void reboot(void) {
+    (void)memset(&mod, 0x00, sizeof(mod));
+
+    zassert_ok(storage_counter_init());
+}
+
+static uint32_t load(void) {
+    uint32_t value;
+
+    zassert_ok(elerium_storage_counter_load(TEST_COUNTER_KEY, &value));
+
+    return value;
+}
+
+static void counter_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    const struct flash_area* fa;
+
+    mock_ecc_reset();
+    mock_flash_reset();
+
+    zassert_ok(flash_area_open(FIXED_PARTITION_ID(COUNTER_PARTITION), &fa));
+    zassert_ok(flash_area_erase(fa, 0, fa->fa_size));
+    flash_area_close(fa);
+
+    // The checkpoint may still be cached from another case
+    zassert_ok(elerium_storage_delete(TEST_COUNTER_KEY));
+
+    reboot();
+}
+
+ZTEST_SUITE(storage_counter, NULL, NULL, counter_before, NULL, NULL);
+
+//***************************************************************************//
+
+ZTEST(storage_counter, test_counter_survives_reboot) {
+    for (uint32_t value = 1; value <= 3; ++value) {
+        zassert_ok(elerium_storage_counter_save(TEST_COUNTER_KEY, value));
+    }
+
+    reboot();
+
+    zassert_equal(load(), 3);
+    zassert_equal(elerium_storage_counter_save(TEST_COUNTER_KEY, 2), -EIO);
+}
+
+// Power cut halfway through a program, the word fails its ECC at every later read
+ZTEST(storage_counter, test_power_cut_torn_word) {
+    static const uint8_t torn[8] = { 0x04, 0x00, 0x00, 0x00, 0xFB };
+
+    zassert_ok(elerium_storage_counter_save(TEST_COUNTER_KEY, 1));
+    zassert_ok(elerium_storage_counter_save(TEST_COUNTER_KEY, 2));
+
+    const off_t torn_offset = mod.next;
+
+    zassert_ok(flash_area_write(mod.fa, torn_offset, torn, mod.word_size));
+    mock_ecc.torn_offset = torn_offset;
+
+    // The boot scan steps over the word instead of stopping on it
+    reboot();
+
+    zassert_equal(load(), 2);
+    zassert_equal(mock_ecc.errors, 1);
+    zassert_equal(mod.next, torn_offset + mod.word_size);
+
+    zassert_ok(elerium_storage_counter_save(TEST_COUNTER_KEY, 3));
+
+    reboot();
+
+    zassert_equal(load(), 3);
+}
+
+// A word torn while it still read as erased takes the next program and then fails its ECC, the
+// value moves on to the following word
+ZTEST(storage_counter, test_unreadable_write_retried) {
+    zassert_ok(elerium_storage_counter_save(TEST_COUNTER_KEY, 1));
+
+    mock_ecc.torn_offset = mod.next;
+
+    zassert_ok(elerium_storage_counter_save(TEST_COUNTER_KEY, 2));
+    zassert_equal(mock_ecc.errors, 1);
+
+    reboot();
+
+    zassert_equal(load(), 2);
+}
+
+//***************************************************************************//
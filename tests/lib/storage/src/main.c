@@ -0,0 +1,163 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "mocks.h"
+
+// Built into the test so a reboot can clear its state
+#include "storage.c"
+
+//***************************************************************************//
+
+#define TEST_KEY_A 0x0101
+#define TEST_KEY_B 0x0102
+#define TEST_KEY_RECORD 0x0103
+
+#define TEST_RECORD_SIZE 128
+#define TEST_STRESS_COMMANDS 200
+
+// Journal write, one write per entry, journal delete
+#define TEST_COMMIT_WRITES 4
+
+//***************************************************************************//
+
+// RAM state is lost, flash keeps what landed before the cut
+static int reboot(int writes_left) {
+    mock_flash.writes_left = writes_left;
+
+    (void)memset(&mod, 0x00, sizeof(mod));
+
+    const int rc = elerium_storage_init();
+
+    mock_flash.writes_left = -1;
+
+    return rc;
+}
+
+static void storage_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    mock_flash_reset();
+    mock_worker_reset();
+
+    zassert_ok(reboot(-1));
+}
+
+ZTEST_SUITE(storage, NULL, NULL, storage_before, NULL, NULL);
+
+//***************************************************************************//
+
+// Both keys take the value in one transaction
+static int save_pair(uint32_t value) {
+    int rc;
+
+    rc = elerium_storage_txn_begin();
+
+    if (rc == 0) {
+        (void)elerium_storage_txn_put(TEST_KEY_A, &value, sizeof(value));
+        (void)elerium_storage_txn_put(TEST_KEY_B, &value, sizeof(value));
+        rc = elerium_storage_txn_commit();
+    }
+
+    return rc;
+}
+
+static void check_pair(uint32_t expected) {
+    uint32_t a;
+    uint32_t b;
+    uint8_t journal[JOURNAL_SIZE];
+
+    zassert_ok(elerium_storage_load(TEST_KEY_A, &a, sizeof(a)));
+    zassert_ok(elerium_storage_load(TEST_KEY_B, &b, sizeof(b)));
+
+    zassert_equal(a, expected);
+    zassert_equal(b, expected);
+
+    zassert_true(storage_backend_read(JOURNAL_ID, journal, sizeof(journal)) < 0);
+}
+
+ZTEST(storage, test_power_cut_during_commit) {
+    for (int cut = 0; cut <= TEST_COMMIT_WRITES; ++cut) {
+        mock_flash_reset();
+
+        zassert_ok(reboot(-1));
+        zassert_ok(save_pair(1));
+
+        mock_flash.writes_left = cut;
+
+        const int rc = save_pair(2);
+
+        zassert_ok(reboot(-1));
+
+        // Before the journal landed nothing changed, after it the replay finishes the commit
+        check_pair((cut == 0) ? 1 : 2);
+
+        if (cut == TEST_COMMIT_WRITES) {
+            zassert_ok(rc);
+        } else {
+            zassert_not_ok(rc);
+        }
+    }
+}
+
+ZTEST(storage, test_power_cut_during_replay) {
+    zassert_ok(save_pair(1));
+
+    // Only the journal lands
+    mock_flash.writes_left = 1;
+
+    zassert_not_ok(save_pair(2));
+
+    // Power fails again halfway through the replay
+    zassert_not_ok(reboot(1));
+    zassert_ok(reboot(-1));
+
+    check_pair(2);
+}
+
+ZTEST(storage, test_gc_before_journal) {
+    zassert_ok(save_pair(1));
+    zassert_equal(mock_flash.sector_next_calls, 0);
+
+    // Room for the journal alone, not for the writes that apply it
+    mock_flash.sector_free = 3 * STORAGE_BACKEND_WRITE_OVERHEAD;
+
+    const size_t writes = mock_flash.writes;
+
+    zassert_ok(save_pair(2));
+
+    zassert_equal(mock_flash.sector_next_calls, 1);
+    zassert_equal(mock_flash.sector_next_at, writes);
+
+    check_pair(2);
+}
+
+//***************************************************************************//
+
+// Commands that each save a record and commit a pair, with the housekeeping run in the quiet time
+// between them. Every erase happens there, no foreground write waits for one.
+ZTEST(storage, test_gc_stress) {
+    uint8_t record[TEST_RECORD_SIZE];
+    struct elerium_storage_stats stats;
+
+    for (uint32_t command = 0; command < TEST_STRESS_COMMANDS; ++command) {
+        (void)memset(record, (int)command, sizeof(record));
+
+        zassert_ok(elerium_storage_save(TEST_KEY_RECORD, record, sizeof(record)));
+        zassert_ok(save_pair(command));
+
+        mock_worker_run();
+    }
+
+    zassert_ok(elerium_storage_stats(&stats));
+
+    zassert_equal(stats.foreground_gc, 0);
+    zassert_true(stats.idle_gc > 0);
+    zassert_true(stats.max_write_us < (mock_flash.erase_us / 2), "%u us", stats.max_write_us);
+
+    check_pair(TEST_STRESS_COMMANDS - 1);
+}
+
+//***************************************************************************//
@@ -0,0 +1,217 @@
+//***************************************************************************//
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include "mocks.h"
+#include "url_sign_vectors.h"
+
+// Built into the test so its static helpers can be called directly
+#include "url_sign.c"
+
+//***************************************************************************//
+
+#define TEST_UID "0123456789abcdef"
+
+#if IS_ENABLED(CONFIG_BEECHAT_ELERIUM_URL_SIGN_FORMAT_BASE64URL)
+#define TEST_VERSION 2
+#else
+#define TEST_VERSION 1
+#endif
+
+//***************************************************************************//
+
+// Plain URL, a prefix longer than one SHA-256 block, and a template that starts with a field
+static const char* const midstate_templates[] = {
+    "beechat.network/t",
+    "beechat.network/tags/verify/elerium/a-path-crossing-one-block/?" FORMAT_VERSION_PARAM
+    "&ctr={ctr}&rnd={rnd}&sign={sig}",
+    "{uid}.tags.beechat.network/?" FORMAT_VERSION_PARAM "&sign={sig}&ctr={ctr}&rnd={rnd}",
+};
+
+//***************************************************************************//
+
+static void url_sign_before(void* fixture) {
+    ARG_UNUSED(fixture);
+
+    (void)memset(&mod.template, 0x00, sizeof(mod.template));
+    (void)memset(&mock_ndef, 0x00, sizeof(mock_ndef));
+
+    (void)strcpy(mod.uid_hex, TEST_UID);
+    mod.uid_len = (sizeof(TEST_UID) - 1) / 2;
+}
+
+ZTEST_SUITE(url_sign, NULL, NULL, url_sign_before, NULL, NULL);
+
+//***************************************************************************//
+
+// Renders the entry and returns the URL with the encoded signature cut out
+static size_t render_message(const struct url_sign_entry* entry, char* message) {
+    char sig[SIG_TEXT_SIZE];
+    struct url_fields fields;
+
+    const size_t mark = elerium_scratch_begin();
+
+    zassert_ok(render_url(entry));
+
+    elerium_scratch_end(mark);
+
+    zassert_ok(encode_sign(entry, sig, &fields));
+
+    const char* const pos = strstr(mock_ndef.url, sig);
+
+    zassert_not_null(pos, "signature missing from %s", mock_ndef.url);
+
+    const size_t head = pos - mock_ndef.url;
+    const size_t tail = mock_ndef.len - head - fields.sig_len;
+
+    (void)memcpy(message, mock_ndef.url, head);
+    (void)memcpy(&message[head], &pos[fields.sig_len], tail);
+
+    return head + tail;
+}
+
+ZTEST(url_sign, test_midstate_matches_one_shot) {
+    char message[ELERIUM_NFC_NDEF_URL_MAX_LEN];
+    struct url_fields fields;
+    struct elerium_hash resumed;
+    struct elerium_hash one_shot;
+
+    for (size_t i = 0; i < ARRAY_SIZE(midstate_templates); ++i) {
+        struct url_sign_entry entry = {
+            .counter = 1000 + i,
+            .rnd_number = 0x0123456789ABCDEFull + i,
+        };
+
+        for (size_t j = 0; j < sizeof(entry.sign.data); ++j) {
+            entry.sign.data[j] = (uint8_t)((i * 7) + j);
+        }
+
+        zassert_ok(template_compile(midstate_templates[i], &mod.template));
+
+        zassert_ok(encode_fields(&entry, &fields));
+        zassert_ok(message_hash(&fields, &resumed));
+
+        const size_t len = render_message(&entry, message);
+
+        zassert_ok(elerium_crypto_sha256(message, len, &one_shot));
+
+        zassert_mem_equal(resumed.data,
+                          one_shot.data,
+                          sizeof(one_shot.data),
+                          "template %u: %.*s",
+                          (unsigned)i,
+                          (int)len,
+                          message);
+    }
+}
+
+// The URLs, hashes and signatures were made off the device, host/url_verify checks the same ones
+ZTEST(url_sign, test_golden_vectors) {
+    struct elerium_pub_key pub_key;
+    struct url_fields fields;
+    struct elerium_hash hash;
+    size_t count = 0;
+
+    (void)memcpy(pub_key.data, url_sign_vector_pub_key, sizeof(pub_key.data));
+
+    for (size_t i = 0; i < ARRAY_SIZE(url_sign_vectors); ++i) {
+        const struct url_sign_vector* vector = &url_sign_vectors[i];
+
+        if (vector->version != TEST_VERSION) {
+            continue;
+        }
+
+        struct url_sign_entry entry = {
+            .counter = vector->ctr,
+            .rnd_number = vector->rnd,
+        };
+
+        (void)memcpy(entry.sign.data, vector->sig, sizeof(entry.sign.data));
+
+        (void)strcpy(mod.uid_hex, vector->uid);
+        mod.uid_len = strlen(vector->uid) / 2;
+
+        zassert_ok(template_compile(vector->template, &mod.template));
+
+        const size_t mark = elerium_scratch_begin();
+
+        zassert_ok(render_url(&entry));
+
+        elerium_scratch_end(mark);
+
+        zassert_equal(
+            mock_ndef.len, strlen(vector->url), "vector %u: %s", (unsigned)i, mock_ndef.url);
+        zassert_mem_equal(mock_ndef.url, vector->url, mock_ndef.len, "vector %u", (unsigned)i);
+
+        zassert_ok(encode_fields(&entry, &fields));
+        zassert_ok(message_hash(&fields, &hash));
+
+        zassert_mem_equal(hash.data, vector->hash, sizeof(hash.data), "vector %u", (unsigned)i);
+        zassert_ok(elerium_crypto_verify(&pub_key, hash.data, sizeof(hash.data), &entry.sign));
+
+        // Any other URL has to fail against the same signature
+        hash.data[0] ^= 0x01;
+
+        zassert_not_ok(elerium_crypto_verify(&pub_key, hash.data, sizeof(hash.data), &entry.sign));
+
+        ++count;
+    }
+
+    zassert_true(count > 0, "no vectors for version %d", TEST_VERSION);
+}
+
+ZTEST(url_sign, test_template_requires_version) {
+    struct url_template template;
+
+    zassert_equal(template_compile("beechat.network/t?ctr={ctr}&sign={sig}", &template), -EINVAL);
+    zassert_equal(template_compile("beechat.network/t?v=9&ctr={ctr}&sign={sig}", &template),
+                  -EINVAL);
+    zassert_equal(template_compile("beechat.network/t?" FORMAT_VERSION_PARAM "0&sign={sig}",
+                                   &template),
+                  -EINVAL);
+
+    zassert_ok(template_compile("beechat.network/t?ctr={ctr}&" FORMAT_VERSION_PARAM "&sign={sig}",
+                                &template));
+}
+
+// Filled to the longest URL the NDEF record takes, and one byte past it
+ZTEST(url_sign, test_template_length_limit) {
+    static const char query[] = "?" FORMAT_VERSION_PARAM "&sign={sig}";
+
+    struct url_template template;
+    char url[ELERIUM_NFC_NDEF_URL_MAX_LEN + sizeof(query)];
+
+    zassert_ok(template_compile(query, &template));
+
+    const size_t fill = ELERIUM_NFC_NDEF_URL_MAX_LEN - template_max_len(&template);
+
+    (void)memset(url, 'b', fill);
+    (void)memcpy(&url[fill], query, sizeof(query));
+
+    zassert_ok(template_compile(url, &template));
+    zassert_equal(template_max_len(&template), ELERIUM_NFC_NDEF_URL_MAX_LEN);
+
+    (void)memset(url, 'b', fill + 1);
+    (void)memcpy(&url[fill + 1], query, sizeof(query));
+
+    zassert_equal(template_compile(url, &template), -EMSGSIZE);
+}
+
+ZTEST(url_sign, test_plain_url_gets_version) {
+    zassert_ok(template_compile("beechat.network/t", &mod.template));
+
+    const struct url_sign_entry entry = { .counter = 7, .rnd_number = 1 };
+
+    const size_t mark = elerium_scratch_begin();
+
+    zassert_ok(render_url(&entry));
+
+    elerium_scratch_end(mark);
+
+    zassert_not_null(
+        strstr(mock_ndef.url, "?" FORMAT_VERSION_PARAM "&ctr=7&"), "%s", mock_ndef.url);
+}
+
+//***************************************************************************//
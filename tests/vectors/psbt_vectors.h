@@ -0,0 +1,87 @@
+#ifndef ELERIUM_TESTS_VECTORS_PSBT_VECTORS_H_
+#define ELERIUM_TESTS_VECTORS_PSBT_VECTORS_H_
+
+//***************************************************************************//
+
+#include <stdint.h>
+
+//***************************************************************************//
+
+// Unsigned transaction of the BIP143 native P2WPKH example. Input 1 spends a P2WPKH output in
+// that example, the taproot vectors spend the same transaction with input 1 as a P2TR output.
+static const uint8_t psbt_vector_tx[] = {
+    0x01, 0x00, 0x00, 0x00, 0x02, 0xFF, 0xF7, 0xF7, 0x88, 0x1A, 0x80, 0x99,
+    0xAF, 0xA6, 0x94, 0x0D, 0x42, 0xD1, 0xE7, 0xF6, 0x36, 0x2B, 0xEC, 0x38,
+    0x17, 0x1E, 0xA3, 0xED, 0xF4, 0x33, 0x54, 0x1D, 0xB4, 0xE4, 0xAD, 0x96,
+    0x9F, 0x00, 0x00, 0x00, 0x00, 0x00, 0xEE, 0xFF, 0xFF, 0xFF, 0xEF, 0x51,
+    0xE1, 0xB8, 0x04, 0xCC, 0x89, 0xD1, 0x82, 0xD2, 0x79, 0x65, 0x5C, 0x3A,
+    0xA8, 0x9E, 0x81, 0x5B, 0x1B, 0x30, 0x9F, 0xE2, 0x87, 0xD9, 0xB2, 0xB5,
+    0x5D, 0x57, 0xB9, 0x0E, 0xC6, 0x8A, 0x01, 0x00, 0x00, 0x00, 0x00, 0xFF,
+    0xFF, 0xFF, 0xFF, 0x02, 0x20, 0x2C, 0xB2, 0x06, 0x00, 0x00, 0x00, 0x00,
+    0x19, 0x76, 0xA9, 0x14, 0x82, 0x80, 0xB3, 0x7D, 0xF3, 0x78, 0xDB, 0x99,
+    0xF6, 0x6F, 0x85, 0xC9, 0x5A, 0x78, 0x3A, 0x76, 0xAC, 0x7A, 0x6D, 0x59,
+    0x88, 0xAC, 0x90, 0x93, 0x51, 0x0D, 0x00, 0x00, 0x00, 0x00, 0x19, 0x76,
+    0xA9, 0x14, 0x3B, 0xDE, 0x42, 0xDB, 0xEE, 0x7E, 0x4D, 0xBE, 0x6A, 0x21,
+    0xB2, 0xD5, 0x0C, 0xE2, 0xF0, 0x16, 0x7F, 0xAA, 0x81, 0x59, 0x88, 0xAC,
+    0x11, 0x00, 0x00, 0x00,
+};
+
+// Spent output of input 1 as a PSBT witness UTXO, amount then script
+static const uint8_t psbt_vector_p2wpkh_utxo[] = {
+    0x00, 0x46, 0xC3, 0x23, 0x00, 0x00, 0x00, 0x00, 0x16, 0x00, 0x14, 0x1D,
+    0x0F, 0x17, 0x2A, 0x0E, 0xCB, 0x48, 0xAE, 0xE1, 0xBE, 0x1F, 0x26, 0x87,
+    0xD2, 0x96, 0x3A, 0xE3, 0x3F, 0x71, 0xA1,
+};
+
+// Key of input 1, its HASH160 is the program of the spent output
+static const uint8_t psbt_vector_p2wpkh_pub_key[33] = {
+    0x02, 0x54, 0x76, 0xC2, 0xE8, 0x31, 0x88, 0x36, 0x8D, 0xA1, 0xFF, 0x3E,
+    0x29, 0x2E, 0x7A, 0xCA, 0xFC, 0xDB, 0x35, 0x66, 0xBB, 0x0A, 0xD2, 0x53,
+    0xF6, 0x2F, 0xC7, 0x0F, 0x07, 0xAE, 0xEE, 0x63, 0x57,
+};
+static const uint8_t psbt_vector_p2wpkh_hash160[20] = {
+    0x1D, 0x0F, 0x17, 0x2A, 0x0E, 0xCB, 0x48, 0xAE, 0xE1, 0xBE, 0x1F, 0x26,
+    0x87, 0xD2, 0x96, 0x3A, 0xE3, 0x3F, 0x71, 0xA1,
+};
+
+// Sighash of input 1 from BIP143
+static const uint8_t psbt_vector_p2wpkh_sighash[32] = {
+    0xC3, 0x7A, 0xF3, 0x11, 0x16, 0xD1, 0xB2, 0x7C, 0xAF, 0x68, 0xAA, 0xE9,
+    0xE3, 0xAC, 0x82, 0xF1, 0x47, 0x79, 0x29, 0x01, 0x4D, 0x5B, 0x91, 0x76,
+    0x57, 0xD0, 0xEB, 0x49, 0x47, 0x8C, 0xB6, 0x70,
+};
+
+// First receive key of the BIP86 test wallet, m/86'/0'/0'/0/0, and its BIP86 output key. The
+// sighash is not from a BIP, it was computed with a Python model of BIP341 for this spend: key
+// path, no annex, SIGHASH_DEFAULT, input 0 a foreign P2WPKH output of 6.25 BTC and input 1 this
+// key for 6 BTC.
+static const uint8_t psbt_vector_taproot_internal_key[32] = {
+    0xCC, 0x8A, 0x4B, 0xC6, 0x4D, 0x89, 0x7B, 0xDD, 0xC5, 0xFB, 0xC2, 0xF6,
+    0x70, 0xF7, 0xA8, 0xBA, 0x0B, 0x38, 0x67, 0x79, 0x10, 0x6C, 0xF1, 0x22,
+    0x3C, 0x6F, 0xC5, 0xD7, 0xCD, 0x6F, 0xC1, 0x15,
+};
+static const uint8_t psbt_vector_taproot_output_key[32] = {
+    0xA6, 0x08, 0x69, 0xF0, 0xDB, 0xCF, 0x1D, 0xC6, 0x59, 0xC9, 0xCE, 0xCB,
+    0xAF, 0x80, 0x50, 0x13, 0x5E, 0xA9, 0xE8, 0xCD, 0xC4, 0x87, 0x05, 0x3F,
+    0x1D, 0xC6, 0x88, 0x09, 0x49, 0xDC, 0x68, 0x4C,
+};
+static const uint8_t psbt_vector_taproot_utxo[] = {
+    0x00, 0x46, 0xC3, 0x23, 0x00, 0x00, 0x00, 0x00, 0x22, 0x51, 0x20, 0xA6,
+    0x08, 0x69, 0xF0, 0xDB, 0xCF, 0x1D, 0xC6, 0x59, 0xC9, 0xCE, 0xCB, 0xAF,
+    0x80, 0x50, 0x13, 0x5E, 0xA9, 0xE8, 0xCD, 0xC4, 0x87, 0x05, 0x3F, 0x1D,
+    0xC6, 0x88, 0x09, 0x49, 0xDC, 0x68, 0x4C,
+};
+static const uint8_t psbt_vector_taproot_other_utxo[] = {
+    0x40, 0xBE, 0x40, 0x25, 0x00, 0x00, 0x00, 0x00, 0x16, 0x00, 0x14, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+};
+static const uint8_t psbt_vector_taproot_sighash[32] = {
+    0x12, 0x46, 0x10, 0x51, 0xB6, 0xE1, 0x3F, 0x68, 0x0D, 0x1C, 0xA0, 0xCE,
+    0x52, 0xE3, 0x7B, 0x10, 0xE2, 0x63, 0x02, 0xD5, 0x1B, 0x14, 0xDA, 0x4A,
+    0x1E, 0x1F, 0xF2, 0x66, 0x78, 0xAB, 0xD4, 0x4B,
+};
+
+//***************************************************************************//
+
+#endif // ELERIUM_TESTS_VECTORS_PSBT_VECTORS_H_
@@ -0,0 +1,135 @@
+#ifndef ELERIUM_TESTS_VECTORS_URL_SIGN_VECTORS_H_
+#define ELERIUM_TESTS_VECTORS_URL_SIGN_VECTORS_H_
+
+//***************************************************************************//
+
+#include <stdint.h>
+
+//***************************************************************************//
+
+// Signed URLs shared by the firmware tests and host/url_verify. The signatures were made with
+// OpenSSL over SHA-256 of the URL with its signature value left empty, ECDSA is randomized so
+// they only change when a vector is added.
+
+struct url_sign_vector {
+    // Value of the v parameter, 1 is hex and 2 is base64url
+    uint8_t version;
+    // As programmed, a URL without placeholders gets the default query of its version
+    const char* template;
+    const char* uid;
+    uint32_t ctr;
+    uint64_t rnd;
+    uint8_t sig[64];
+    uint8_t hash[32];
+    // As rendered into the NDEF record, which adds https:// as a prefix code
+    const char* url;
+};
+
+//***************************************************************************//
+
+static const uint8_t url_sign_vector_pub_key[64] = {
+    0xC1, 0xE1, 0xFC, 0xCB, 0x6C, 0x38, 0x1D, 0x33, 0x3F, 0xEC, 0x66, 0x8E,
+    0x09, 0x8C, 0x74, 0x7B, 0x4D, 0xD1, 0xE6, 0x05, 0x00, 0x71, 0xE2, 0x6E,
+    0xDE, 0xAE, 0x95, 0xBC, 0xAA, 0x14, 0xE3, 0x3C, 0xC7, 0x41, 0x43, 0x91,
+    0x5C, 0xA8, 0x5E, 0x6E, 0xDD, 0x0E, 0xEE, 0x14, 0x39, 0x75, 0xDF, 0x7B,
+    0xE0, 0x22, 0xA4, 0xED, 0xCF, 0x4E, 0xE2, 0x68, 0xC4, 0x7B, 0xAA, 0x6C,
+    0x98, 0x6E, 0xE5, 0xE7,
+};
+
+static const struct url_sign_vector url_sign_vectors[] = {
+    {
+        .version = 1,
+        .template = "beechat.network/t",
+        .uid = "0123456789abcdef",
+        .ctr = 1u,
+        .rnd = 0x112210F47DE98115ull,
+        .sig = {
+            0xA4, 0xB2, 0x49, 0x21, 0xB5, 0x51, 0x7B, 0xEA, 0x34, 0x6B, 0x5B, 0xBA,
+            0xE0, 0x56, 0x4B, 0x5A, 0x83, 0x7D, 0x81, 0x8A, 0x99, 0xB2, 0xD3, 0xC2,
+            0xE0, 0x5A, 0x64, 0xD0, 0x68, 0x8D, 0xCE, 0x01, 0x9E, 0xA1, 0x08, 0xF2,
+            0xC3, 0x6C, 0x3F, 0xB0, 0xD7, 0x91, 0x36, 0xF7, 0x44, 0xA1, 0x3F, 0xDF,
+            0x61, 0x7A, 0x98, 0x67, 0x7F, 0x9A, 0xBA, 0xE0, 0x85, 0xE2, 0x60, 0x37,
+            0xFB, 0xD6, 0xE9, 0x1A,
+        },
+        .hash = {
+            0x1D, 0x47, 0x92, 0x23, 0xD8, 0xA9, 0xB2, 0x13, 0xEE, 0xB6, 0xAB, 0x97,
+            0xBE, 0x6A, 0xC6, 0x5B, 0xA4, 0xA8, 0x71, 0x20, 0x16, 0x23, 0xD3, 0x1C,
+            0xFF, 0x1E, 0x35, 0xFA, 0x1A, 0x9E, 0xC0, 0x12,
+        },
+        .url = "beechat.network/t?v=1&ctr=1&rnd=1234567890123456789&sign=a4b24921b5517bea346b5bbae"
+               "0564b5a837d818a99b2d3c2e05a64d0688dce019ea108f2c36c3fb0d79136f744a13fdf617a98677f9"
+               "abae085e26037fbd6e91a",
+    },
+    {
+        .version = 1,
+        .template = "beechat.network/t/{uid}?v=1&ctr={ctr}&rnd={rnd}&sign={sig}",
+        .uid = "0123456789abcdef",
+        .ctr = 4294967295u,
+        .rnd = 0x0000000000000000ull,
+        .sig = {
+            0x4A, 0x97, 0xBE, 0x4E, 0x6A, 0x1C, 0xB6, 0x9E, 0x6B, 0x3E, 0xF7, 0x76,
+            0xF2, 0x49, 0x96, 0xBE, 0x13, 0x92, 0xF5, 0xFA, 0xFB, 0xEF, 0x9B, 0x64,
+            0xDE, 0x3C, 0xC8, 0x29, 0xF9, 0x49, 0xEB, 0xFC, 0x5E, 0xD7, 0x59, 0xDB,
+            0xC7, 0x14, 0x96, 0x8F, 0x44, 0x53, 0xB3, 0x80, 0x39, 0x1D, 0xD9, 0x9A,
+            0xBC, 0x3E, 0x9C, 0xDE, 0x28, 0xDC, 0xE6, 0xEF, 0x87, 0x14, 0xA3, 0x3F,
+            0x4F, 0xB3, 0x87, 0x03,
+        },
+        .hash = {
+            0xC0, 0x4F, 0x47, 0xAB, 0x11, 0xEF, 0xE5, 0xB4, 0xE5, 0x7D, 0xCF, 0xF1,
+            0xC4, 0x90, 0x95, 0x8B, 0x1B, 0x05, 0x3E, 0x6C, 0x0F, 0xBD, 0xBA, 0xF0,
+            0x50, 0x32, 0xCE, 0x28, 0x5D, 0x54, 0xFB, 0xDF,
+        },
+        .url = "beechat.network/t/0123456789abcdef?v=1&ctr=4294967295&rnd=0&sign=4a97be4e6a1cb69e6"
+               "b3ef776f24996be1392f5fafbef9b64de3cc829f949ebfc5ed759dbc714968f4453b380391dd99abc3"
+               "e9cde28dce6ef8714a33f4fb38703",
+    },
+    {
+        .version = 2,
+        .template = "beechat.network/t",
+        .uid = "0123456789abcdef",
+        .ctr = 1024u,
+        .rnd = 0xFEDCBA9876543210ull,
+        .sig = {
+            0x74, 0xA1, 0x28, 0x4F, 0xD6, 0x4E, 0x0B, 0x29, 0xDE, 0x56, 0x0D, 0x39,
+            0x76, 0xC3, 0x9A, 0x95, 0x06, 0x1C, 0xF7, 0xAA, 0xB3, 0xEA, 0x0F, 0x29,
+            0x41, 0x3C, 0x1C, 0x3A, 0x56, 0xD3, 0x70, 0x7C, 0xC2, 0xAE, 0x6D, 0xEE,
+            0x49, 0x0E, 0x9A, 0xA9, 0xAE, 0x76, 0xEF, 0x66, 0xD4, 0x6C, 0x65, 0x10,
+            0x6A, 0x8F, 0x81, 0xA8, 0xC3, 0xB2, 0x01, 0xB1, 0x1A, 0x32, 0xF8, 0x7D,
+            0x3C, 0x36, 0x12, 0x86,
+        },
+        .hash = {
+            0x45, 0x44, 0xBC, 0x75, 0xEE, 0xBE, 0x43, 0x0D, 0x94, 0xE5, 0x78, 0xDC,
+            0x28, 0x84, 0xA3, 0x19, 0x19, 0x0D, 0xA1, 0xD8, 0x13, 0xEE, 0xFE, 0x41,
+            0x42, 0x33, 0x07, 0x7A, 0xD8, 0x5F, 0x99, 0xFD,
+        },
+        .url = "beechat.network/t?v=2&ctr=1024&rnd=_ty6mHZUMhA&sign=dKEoT9ZOCyneVg05dsOalQYc96qz6g"
+               "8pQTwcOlbTcHzCrm3uSQ6aqa5272bUbGUQao-BqMOyAbEaMvh9PDYShg",
+    },
+    {
+        .version = 2,
+        .template = "{uid}.beechat.network/?v=2&sign={sig}&ctr={ctr}&rnd={rnd}",
+        .uid = "00112233445566778899aabbccddeeff",
+        .ctr = 0u,
+        .rnd = 0x0000000000000001ull,
+        .sig = {
+            0x60, 0xD9, 0xC0, 0xCF, 0xB6, 0x68, 0x4A, 0xEF, 0x8C, 0x4E, 0xCC, 0x83,
+            0x0D, 0x32, 0x95, 0xF7, 0x19, 0x42, 0x77, 0x2B, 0xFE, 0x04, 0x55, 0x14,
+            0xAB, 0x4C, 0xA4, 0x20, 0xF4, 0x68, 0x20, 0x07, 0x39, 0xE8, 0x8D, 0x4C,
+            0x09, 0x1D, 0xC1, 0x42, 0xA1, 0x9D, 0xC7, 0x0F, 0x46, 0xBE, 0x6C, 0x10,
+            0xDC, 0x9D, 0xE1, 0xDF, 0x86, 0xD9, 0xEE, 0x6E, 0x79, 0xDB, 0xBD, 0x25,
+            0xE9, 0x0A, 0x3A, 0xB0,
+        },
+        .hash = {
+            0x37, 0x34, 0x3C, 0xD5, 0x9D, 0x81, 0x4C, 0x32, 0x9B, 0x21, 0x51, 0x93,
+            0x76, 0xB5, 0x27, 0xC8, 0x46, 0x54, 0x10, 0xEA, 0x91, 0x4A, 0x06, 0x39,
+            0xD6, 0xBD, 0x42, 0x2F, 0x13, 0xD7, 0xAD, 0x18,
+        },
+        .url = "00112233445566778899aabbccddeeff.beechat.network/?v=2&sign=YNnAz7ZoSu-MTsyDDTKV9xl"
+               "Cdyv-BFUUq0ykIPRoIAc56I1MCR3BQqGdxw9GvmwQ3J3h34bZ7m55270l6Qo6sA&ctr=0&rnd=AAAAAAAA"
+               "AAE",
+    },
+};
+
+//***************************************************************************//
+
+#endif // ELERIUM_TESTS_VECTORS_URL_SIGN_VECTORS_H_